@@ -8,6 +8,8 @@ QT       += gui widgets core printsupport xml xmlpatterns
 
 QMAKE_CXXFLAGS += -std=c++11
 
+CONFIG += thread
+
 TARGET = attestate-app
 TEMPLATE = app
 
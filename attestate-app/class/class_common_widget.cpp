@@ -72,7 +72,13 @@ CommonWidget::CommonWidget(QWidget *parent)
 
 void CommonWidget::setModel(Model* model)
 {
+    if (model_) {
+        disconnect(model_, SIGNAL(classDataChanged()), this, SLOT(updateFromModel()));
+    }
     model_ = model;
+    if (model_) {
+        connect(model_, SIGNAL(classDataChanged()), this, SLOT(updateFromModel()));
+    }
 
     if (!model_) {
         classId_->clear();
@@ -84,6 +90,11 @@ void CommonWidget::setModel(Model* model)
     graduationYear_->setEnabled(model_);
     issueDate_->setEnabled(model_);
 
+    updateFromModel();
+}
+
+void CommonWidget::updateFromModel()
+{
     if (!model_) {
         return;
     }
@@ -22,6 +22,7 @@ private slots:
     void onClassIdChanged(QString);
     void onGraduationYearChanged(int);
     void onIssueDateChanged(QDate);
+    void updateFromModel();
 
 private:
     QLineEdit* classId_;
@@ -3,7 +3,6 @@
 #include <attestate/grades.h>
 #include <attestate/generate.h>
 #include <doctpl/template.h>
-#include <doctpl/serialize.h>
 
 #include <QtGui>
 #include <QPushButton>
@@ -13,6 +12,12 @@
 //#include <QPrintDialog>
 #include <QFileDialog>
 #include <QObject>
+#include <QProgressDialog>
+#include <QMessageBox>
+#include <QEventLoop>
+#include <QTimer>
+#include <QShortcut>
+#include <QKeySequence>
 
 #include <memory>
 #include <sstream>
@@ -20,39 +25,10 @@
 ClassEditor::ClassEditor(QWidget* parent)
     : QWidget(parent)
 {
-    model_ = new cls::Model(QString::fromUtf8("/home/dicentra/att_2015/Топлакалцян.csv"), this);
-    view_ = new cls::View(this);
-
-    QFont f;
-    f.setPointSize(14);
-    view_->setFont(f);
-    view_->setHeaderFont(f);
-    view_->setModel(model_);
-    view_->setItemDelegate(model_->delegate());
-    view_->resizeColumnsToContents();
-    view_->resizeRowsToContents();
-
-    submitButton = new QPushButton(tr("Submit"));
-    submitButton->setDefault(true);
-    generateButton = new QPushButton(tr("&Generate"));
-    revertButton = new QPushButton(tr("&Revert"));
-    quitButton = new QPushButton(tr("Quit"));
-
-    buttonBox = new QDialogButtonBox(Qt::Vertical);
-    buttonBox->addButton(submitButton, QDialogButtonBox::ActionRole);
-    buttonBox->addButton(generateButton, QDialogButtonBox::ActionRole);
-    buttonBox->addButton(revertButton, QDialogButtonBox::ActionRole);
-    buttonBox->addButton(quitButton, QDialogButtonBox::RejectRole);
-
-    connect(submitButton, SIGNAL(clicked()), this, SLOT(submit()));
-    connect(generateButton, SIGNAL(clicked()), this, SLOT(generate()));
-    connect(revertButton, SIGNAL(clicked()), model_, SLOT(revertAll()));
-    connect(quitButton, SIGNAL(clicked()), this, SLOT(close()));
-
-    QHBoxLayout* mainLayout = new QHBoxLayout;
-    mainLayout->addWidget(view_);
-    mainLayout->addWidget(buttonBox);
-    setLayout(mainLayout);
+    // empty class, classes are opened from files or workspace
+    model_ = new cls::Model(
+        std::unique_ptr<attestate::Class>(new attestate::Class(attestate::ID::gen())), this);
+    init();
 
     setWindowTitle(tr("Attestate editor"));
 
@@ -63,6 +39,22 @@ ClassEditor::ClassEditor(const QString& csvpath, QWidget* parent)
     : QWidget(parent)
 {
     model_ = new cls::Model(csvpath, this);
+    init();
+
+    show();
+}
+
+ClassEditor::ClassEditor(std::unique_ptr<attestate::Class> cls, QWidget* parent)
+    : QWidget(parent)
+{
+    model_ = new cls::Model(std::move(cls), this);
+    init();
+
+    show();
+}
+
+void ClassEditor::init()
+{
     view_ = new cls::View(this);
 
     QFont f;
@@ -89,19 +81,23 @@ ClassEditor::ClassEditor(const QString& csvpath, QWidget* parent)
     connect(submitButton, SIGNAL(clicked()), this, SLOT(submit()));
     connect(generateButton, SIGNAL(clicked()), this, SLOT(generate()));
     connect(revertButton, SIGNAL(clicked()), model_, SLOT(revertAll()));
+
+    QShortcut* undo = new QShortcut(QKeySequence::Undo, this);
+    connect(undo, SIGNAL(activated()), model_, SLOT(undo()));
+    QShortcut* redo = new QShortcut(QKeySequence::Redo, this);
+    connect(redo, SIGNAL(activated()), model_, SLOT(redo()));
     connect(quitButton, SIGNAL(clicked()), this, SLOT(close()));
 
     QHBoxLayout* mainLayout = new QHBoxLayout;
     mainLayout->addWidget(view_);
     mainLayout->addWidget(buttonBox);
     setLayout(mainLayout);
-
-    //setWindowTitle(tr("Attestate editor"));
-
-    show();
 }
 
-void ClassEditor::submit() {}
+void ClassEditor::submit()
+{
+    emit submitted();
+}
 
 void ClassEditor::generate()
 {
@@ -110,19 +106,69 @@ void ClassEditor::generate()
         QString::fromUtf8("Шаблон аттестата"),
         "",
         "*.xml");
+    if (templatePath.isEmpty()) {
+        return;
+    }
 
     auto saveDir = QFileDialog::getExistingDirectory(
         this,
         QString::fromUtf8("Путь для сохранения PDF файлов"));
-
-
-    std::unique_ptr<doctpl::Template> doc = doctpl::xml::read(templatePath);
+    if (saveDir.isEmpty()) {
+        return;
+    }
 
     const auto& c = model_->getClass();
 
-    for (size_t i = 0; i < c.studentsCount(); ++i) {
-        attestate::gen::fillTemplate(c, i, *doc);
-        const auto& s = c.student(i);
-        doc->print(saveDir + "/" + s.familyName() + " " + s.name() + ".pdf");
+    attestate::gen::GenerationJob job(
+        c, attestate::gen::BatchParams{templatePath, saveDir, 0});
+
+    const QString title = QString::fromUtf8("Генерация PDF файлов");
+    QProgressDialog progressDialog(
+        title, tr("Cancel"), 0, static_cast<int>(job.progress().total), this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(0);
+
+    attestate::gen::BatchResult result{0, {}, false, {}};
+    std::string error;
+
+    // generation runs in background, ui is updated by timer
+    job.start();
+
+    QEventLoop loop;
+    QTimer timer;
+    connect(&timer, &QTimer::timeout, [&] {
+        const auto progress = job.progress();
+        progressDialog.setValue(static_cast<int>(progress.done));
+        if (progress.etaSeconds >= 0) {
+            progressDialog.setLabelText(title + "\n"
+                + QString::number(progress.studentsPerSecond, 'f', 1) + tr(" per second, ")
+                + tr("%1 s left").arg(static_cast<int>(progress.etaSeconds + 0.5)));
+        }
+        if (progressDialog.wasCanceled()) {
+            job.cancel();
+        }
+        if (job.isFinished()) {
+            loop.quit();
+        }
+    });
+    timer.start(50);
+    loop.exec();
+    try {
+        result = job.wait();
+    } catch (const std::exception& ex) {
+        error = ex.what();
+    }
+    progressDialog.reset();
+
+    if (!error.empty()) {
+        QMessageBox::critical(this, tr("Generation failed"), QString::fromStdString(error));
+    } else if (!result.errors.empty()) {
+        QStringList messages;
+        for (const auto& e : result.errors) {
+            const auto& s = c.student(e.first);
+            messages.push_back(
+                s.familyName() + " " + s.name() + ": " + QString::fromStdString(e.second));
+        }
+        QMessageBox::warning(this, tr("Generation errors"), messages.join("\n"));
     }
 }
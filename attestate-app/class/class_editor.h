@@ -5,6 +5,8 @@
 
 #include <QDialog>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 class QDialogButtonBox;
 class QPushButton;
@@ -17,14 +19,21 @@ class ClassEditor : public QWidget
 public:
     explicit ClassEditor(QWidget* parent = 0);
     explicit ClassEditor(const QString& csvpath, QWidget* parent = 0);
+    explicit ClassEditor(std::unique_ptr<attestate::Class> cls, QWidget* parent = 0);
 
     cls::Model* model() { return model_; }
 
+signals:
+    // class is to be saved to workspace, editor has no access to it
+    void submitted();
+
 private slots:
     void submit();
     void generate();
 
 private:
+    void init();
+
     QPushButton* submitButton;
     QPushButton* generateButton;
     QPushButton* revertButton;
@@ -4,21 +4,65 @@
 #include <attestate/grades.h>
 #include <attestate/serialize.h>
 
+#include <QBrush>
+
+#include <vector>
+
 namespace cls {
 
 namespace {
 
 const HeaderData::Index COMMON_SECTIONS = 6;
+const int ISSUE_DATE_SECTION = 1;
+
+// validated property of common section
+const QString& propertyTag(int column)
+{
+    using namespace attestate::cfg::tags;
 
+    static const std::vector<QString> s_tags = {
+        property::ATTESTATE_ID,
+        property::ISSUE_DATE,
+        property::FAMILY_NAME,
+        property::NAME,
+        property::PARENTAL_NAME,
+        property::BIRTH_DATE
+    };
+    return s_tags.at(column);
+}
+
+attestate::student::Field propertyField(int column)
+{
+    using attestate::student::Field;
+
+    static const std::vector<Field> s_fields = {
+        Field::AttestateId,
+        Field::IssueDate,
+        Field::FamilyName,
+        Field::Name,
+        Field::ParentalName,
+        Field::BirthDate
+    };
+    return s_fields.at(column);
+}
 
 } // namespace
 
 Model::Model(const QString& csvfile, QObject* parent)
+    : Model(
+        attestate::csv::read(
+            csvfile,
+            attestate::csv::Params{';', QString("dd.MM.yyyy")}),
+        parent)
+{}
+
+Model::Model(std::unique_ptr<attestate::Class> cls, QObject* parent)
     : QAbstractTableModel(parent)
+    , class_(std::move(cls))
 {
-    class_ = attestate::csv::read(
-        csvfile,
-        attestate::csv::Params{';', QString("dd.MM.yyyy")});
+    ATT_ASSERT(class_);
+    validator_.reset(new attestate::validation::Validator(*class_));
+    undo_.reset(new attestate::undo::Stack(*class_));
 
     initHeaderData();
 
@@ -83,45 +127,71 @@ int Model::columnCount(const QModelIndex& /*parent*/) const
 
 QVariant Model::data(const QModelIndex& index, int role) const
 {
+    static const QVariant s_gradeAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
+    static const QVariant s_commonAlignment(Qt::AlignLeft | Qt::AlignVCenter);
+    static const QVariant s_errorBrush = QBrush(Qt::red);
+
     checkIndexIsValid(index);
-    QVariant result;
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
-        const attestate::Student& s = class_->student(index.row());
-        if (index.column() < COMMON_SECTIONS) {
-            std::map<int, std::function<QVariant(void)>> dataMapper = {
-                {0, [&s] () { return QVariant(s.attestateId()); }},
-                {1, [&s, this] ()
-                    {
-                        return s.issueDate()
-                            ? QVariant(*s.issueDate())
-                            : class_->issueDate()
-                                ? QVariant(*class_->issueDate())
-                                : QVariant();
-                    }
-                },
-                {2, [&s] () { return QVariant(s.familyName()); }},
-                {3, [&s] () { return QVariant(s.name()); }},
-                {4, [&s] () { return QVariant(s.parentalName()); }},
-                {5, [&s] () { return QVariant(s.birthDate()); }}
-            };
-            result = dataMapper.at(index.column())();
-        } else {
-            auto grade = s.grades().value(
-                class_->subjectsPlan()->at(index.column() - COMMON_SECTIONS).id());
-            if (grade) {
-                result = QVariant(*grade);
-            }
+        const QVariant& cell = rowCache(index.row()).cells[index.column()];
+        // student without own issue date shows the one of class
+        if (index.column() == ISSUE_DATE_SECTION && cell.isNull() && class_->issueDate()) {
+            return QVariant(*class_->issueDate());
         }
+        return cell;
     } else if (role == Qt::TextAlignmentRole) {
-        result = (index.column() >= COMMON_SECTIONS)
-            ? QVariant(Qt::AlignHCenter | Qt::AlignVCenter)
-            : QVariant(Qt::AlignLeft | Qt::AlignVCenter);
-    } /*else if (role == Qt::BackgroundRole) {
-        result = QBrush(Qt::red);
-    }*/
-    return result;
+        return index.column() >= COMMON_SECTIONS ? s_gradeAlignment : s_commonAlignment;
+    } else if (role == Qt::ForegroundRole) {
+        if (hasError(index)) {
+            return s_errorBrush;
+        }
+    }
+    return QVariant();
 }
 
+const Model::RowCache& Model::rowCache(int row) const
+{
+    if (rowCache_.size() != size_t(rowCount())) {
+        rowCache_.assign(rowCount(), RowCache());
+    }
+    RowCache& cache = rowCache_[row];
+    if (cache.isValid) {
+        return cache;
+    }
+
+    const attestate::Student& s = class_->student(row);
+    cache.cells.assign(columnCount(), QVariant());
+    cache.cells[0] = s.attestateId();
+    if (s.issueDate()) {
+        cache.cells[ISSUE_DATE_SECTION] = *s.issueDate();
+    }
+    cache.cells[2] = s.familyName();
+    cache.cells[3] = s.name();
+    cache.cells[4] = s.parentalName();
+    cache.cells[5] = s.birthDate();
+
+    const auto& plan = class_->subjectsPlan();
+    for (size_t i = 0; plan && i < plan->subjectsCount(); ++i) {
+        const auto code = s.grades().code(plan->at(i).id());
+        if (code != attestate::grades::NO_CODE) {
+            cache.cells[COMMON_SECTIONS + i] = attestate::grades::isValid(code)
+                ? QVariant(attestate::grades::value(code))
+                : QVariant(*s.grades().value(plan->at(i).id()));
+        }
+    }
+    cache.isValid = true;
+    return cache;
+}
+
+void Model::invalidateRow(int row)
+{
+    if (size_t(row) < rowCache_.size()) {
+        rowCache_[row].isValid = false;
+    }
+}
+
+void Model::invalidateRows() { rowCache_.clear(); }
+
 QVariant Model::headerData(
     int section, Qt::Orientation orientation, int role) const
 {
@@ -147,40 +217,38 @@ bool Model::setData(
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
         checkIndexIsValid(index);
 
-        attestate::Student& s = class_->student(index.row());
         if (index.column() < COMMON_SECTIONS) {
-            std::map<int, std::function<void(void)>> dataMapper = {
-                {0, [&s, &data] () { s.setAttestateId(data.toString()); }},
-                {1, [&s, this, &data] ()
-                    {
-                        QDate issueDate = qvariant_cast<QDate>(data);
-                        if (!issueDate.isValid()) {
-                            return;
-                        }
-                        if (attestate::OptionalDate(issueDate) == class_->issueDate()) {
-                            s.setIssueDate(boost::none);
-                        } else {
-                            s.setIssueDate(issueDate);
-                        }
-                    }
-                },
-                {2, [&s, &data] () { s.setFamilyName(data.toString()); }},
-                {3, [&s, &data] () { s.setName(data.toString()); }},
-                {4, [&s, &data] () { s.setParentalName(data.toString()); }},
-                {5, [&s, &data] () { s.setBirthDate(data.toDate()); }}
-            };
-            dataMapper.at(index.column())();
+            using attestate::student::Field;
+
+            const Field field = propertyField(index.column());
+            if (field == Field::IssueDate) {
+                const QDate issueDate = qvariant_cast<QDate>(data);
+                if (issueDate.isValid()) {
+                    // issue date of class is not kept by student
+                    undo_->setField(index.row(), field,
+                        attestate::OptionalDate(issueDate) == class_->issueDate()
+                            ? attestate::OptionalDate()
+                            : attestate::OptionalDate(issueDate));
+                }
+            } else if (field == Field::BirthDate) {
+                undo_->setField(index.row(), field, data.toDate());
+            } else {
+                undo_->setField(index.row(), field, data.toString());
+            }
+            validator_->onPropertyChanged(index.row(), propertyTag(index.column()));
         } else {
             auto subjectId = class_->subjectsPlan()->at(index.column() - COMMON_SECTIONS).id();
             QString value = data.toString();
             if (value.isEmpty()) {
-                s.grades().setValue(subjectId, boost::none);
+                undo_->setGrade(index.row(), subjectId, boost::none);
             } else {
                 ATT_REQUIRE(attestate::grades::isValid(value), "Invalid grade value");
-                s.grades().setValue(subjectId, value);
+                undo_->setGrade(index.row(), subjectId, value);
             }
+            validator_->onGradeChanged(index.row(), subjectId);
         }
 
+        invalidateRow(index.row());
         emit dataChanged(index, index);
         return true;
     }
@@ -197,19 +265,147 @@ bool Model::removeRows(int row, int count, const QModelIndex& parent)
 
 }
 
-void Model::setClassId(const QString& classId) { class_->setClassId(classId); }
+void Model::setClassId(const QString& classId) { undo_->setClassId(classId); }
 
 void Model::setIssueDate(const QDate& date)
 {
     if (attestate::OptionalDate(date) != class_->issueDate()) {
-        class_->setIssueDate(date);
+        undo_->setIssueDate(date);
+        validator_->onClassChanged();
         emit dataChanged(
             index(0, 0),
             index(rowCount() - 1, columnCount() - 1));
     }
 }
 
-void Model::setGraduationYear(int year) { class_->setGraduationYear(year); }
+void Model::setGraduationYear(int year)
+{
+    undo_->setGraduationYear(attestate::Year(year));
+    validator_->onClassChanged();
+}
+
+size_t Model::save(attestate::db::Database& db)
+{
+    beginResetModel();
+    const size_t studentsCount = class_->studentsCount();
+    size_t rows = 0;
+    try {
+        rows = db.save(*class_);
+    } catch (...) {
+        endResetModel();
+        throw;
+    }
+    // students marked as deleted are erased, positions kept by undo steps are stale
+    if (class_->studentsCount() != studentsCount) {
+        undo_->clear();
+    }
+    validator_->onStudentsChanged();
+    invalidateRows();
+    endResetModel();
+    return rows;
+}
+
+void Model::undo()
+{
+    if (undo_->canUndo()) {
+        applyChanges(undo_->undo());
+    }
+}
+
+void Model::redo()
+{
+    if (undo_->canRedo()) {
+        applyChanges(undo_->redo());
+    }
+}
+
+void Model::revertAll()
+{
+    attestate::undo::Changes changes;
+    while (undo_->canUndo()) {
+        auto c = undo_->undo();
+        changes.students.insert(c.students.begin(), c.students.end());
+        changes.isClassChanged = changes.isClassChanged || c.isClassChanged;
+        changes.isStructureChanged = changes.isStructureChanged || c.isStructureChanged;
+    }
+    applyChanges(changes);
+}
+
+void Model::applyChanges(const attestate::undo::Changes& changes)
+{
+    if (changes.isStructureChanged) {
+        beginResetModel();
+        headerData_ = HeaderData();
+        initHeaderData();
+        validator_->onStudentsChanged();
+        invalidateRows();
+        slotsLayout_ = nullptr;
+        endResetModel();
+    } else {
+        for (auto at : changes.students) {
+            invalidateRow(at);
+            validator_->onStudentChanged(at);
+            emit dataChanged(index(at, 0), index(at, columnCount() - 1));
+        }
+    }
+    if (changes.isClassChanged) {
+        validator_->onClassChanged();
+        emit classDataChanged();
+        emit dataChanged(
+            index(0, 0),
+            index(rowCount() - 1, columnCount() - 1));
+    }
+}
+
+attestate::State Model::cellState(const QModelIndex& index) const
+{
+    checkIndexIsValid(index);
+    const attestate::Student& s = class_->student(index.row());
+    if (s.state() == attestate::State::New) {
+        return attestate::State::New;
+    }
+    bool isModified = false;
+    if (index.column() < COMMON_SECTIONS) {
+        isModified = s.modifiedFields() & attestate::student::fieldBit(propertyField(index.column()));
+    } else {
+        const auto slot = gradeSlot(s.grades(), index.column());
+        isModified = slot && s.grades().isModifiedAt(*slot);
+    }
+    return isModified ? attestate::State::Modified : attestate::State::Existing;
+}
+
+attestate::SubjectsLayout::OptionalSlot Model::gradeSlot(
+    const attestate::SubjectsGrades& grades, int column) const
+{
+    // students of a class usually share grades layout
+    const auto& layout = grades.layout();
+    const auto& plan = class_->subjectsPlan();
+    if (layout.get() != slotsLayout_ || layout->size() != slotsLayoutSize_
+        || columnSlots_.size() != plan->subjectsCount())
+    {
+        slotsLayout_ = layout.get();
+        slotsLayoutSize_ = layout->size();
+        columnSlots_.resize(plan->subjectsCount());
+        for (size_t i = 0; i < columnSlots_.size(); ++i) {
+            columnSlots_[i] = layout->find(plan->at(i).id());
+        }
+    }
+    return columnSlots_[column - COMMON_SECTIONS];
+}
+
+bool Model::hasError(const QModelIndex& index) const
+{
+    const auto& studentErrors = validator_->errors().studentErrors;
+    auto it = studentErrors.find(class_->student(index.row()).id());
+    if (it == studentErrors.end()) {
+        return false;
+    }
+    if (index.column() < COMMON_SECTIONS) {
+        return it->second.propertyErrors.count(propertyTag(index.column())) != 0;
+    }
+    const auto& subjectId = class_->subjectsPlan()->at(index.column() - COMMON_SECTIONS).id();
+    return it->second.gradeErrors.count(subjectId) != 0;
+}
 
 void Model::checkIndexIsValid(const QModelIndex& index) const
 {
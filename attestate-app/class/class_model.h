@@ -4,10 +4,15 @@
 #include "colored_cell_delegate.h"
 
 #include <attestate/class.h>
+#include <attestate/db.h>
+#include <attestate/grades.h>
+#include <attestate/undo.h>
+#include <attestate/validate.h>
 
 #include <QtCore>
 
 #include <memory>
+#include <vector>
 
 namespace cls {
 
@@ -18,6 +23,7 @@ class Model : public QAbstractTableModel {
 public:
 
     explicit Model(const QString& csvfile, QObject* parent = 0);
+    explicit Model(std::unique_ptr<attestate::Class> cls, QObject* parent = 0);
 
 
     virtual ~Model();
@@ -66,13 +72,60 @@ public:
 
     const attestate::Class& getClass() const { return *class_; }
 
+    // New for new student, Modified if value in cell is not saved
+    attestate::State cellState(const QModelIndex& index) const;
+
+    // writes changes to workspace, students marked as deleted are removed
+    size_t save(attestate::db::Database& db);
+
+    // kept up to date on every edit
+    const attestate::validation::ClassErrors& errors() const { return validator_->errors(); }
+
+    // edits made through the model
+    attestate::undo::Stack& undoStack() { return *undo_; }
+
+public slots:
+    void undo();
+    void redo();
+    // undoes all steps kept by undo stack
+    void revertAll();
+
+signals:
+    // class id, graduation year or issue date changed by undo or redo
+    void classDataChanged();
+
 private:
+    void applyChanges(const attestate::undo::Changes& changes);
+
+    // display values of a row, built on first access
+    struct RowCache {
+        bool isValid = false;
+        std::vector<QVariant> cells;
+    };
+
+    const RowCache& rowCache(int row) const;
+    void invalidateRow(int row);
+    void invalidateRows();
+
+    // slot of subject in column, resolved once per grades layout
+    attestate::SubjectsLayout::OptionalSlot gradeSlot(
+        const attestate::SubjectsGrades& grades, int column) const;
+
     void initHeaderData();
     void checkIndexIsValid(const QModelIndex& index) const;
+    bool hasError(const QModelIndex& index) const;
 
     HeaderData headerData_;
 
     std::unique_ptr<attestate::Class> class_;
+    std::unique_ptr<attestate::validation::Validator> validator_;
+    std::unique_ptr<attestate::undo::Stack> undo_;
+
+    mutable std::vector<RowCache> rowCache_;
+
+    mutable const attestate::SubjectsLayout* slotsLayout_ = nullptr;
+    mutable size_t slotsLayoutSize_ = 0;
+    mutable std::vector<attestate::SubjectsLayout::OptionalSlot> columnSlots_;
 };
 
 } // namespace cls
@@ -6,12 +6,6 @@
 
 namespace cls {
 
-namespace {
-
-const int COMMON_SECTIONS = 6;
-
-} // namespace
-
 void ColoredCellDelegate::paint(
     QPainter* painter,
     const QStyleOptionViewItem& option,
@@ -25,29 +19,7 @@ void ColoredCellDelegate::paint(
 
     painter->save();
 
-    const attestate::Student& s = model_->getClass().student(index.row());
-    attestate::State state = attestate::State::Existing;
-    if (s.state() == attestate::State::New) {
-        state = attestate::State::New;
-    } else if (index.column() < COMMON_SECTIONS) {
-        std::map<int, std::function<bool(void)>> isModified = {
-            {0, [&s] () { return s.isAttestateIdModified(); }},
-            {1, [&s] () { return s.isIssueDateModified(); }},
-            {2, [&s] () { return s.isFamilyNameModified(); }},
-            {3, [&s] () { return s.isNameModified(); }},
-            {4, [&s] () { return s.isParentalNameModified(); }},
-            {5, [&s] () { return s.isBirthDateModified(); }}
-        };
-        if (isModified.at(index.column())()) {
-            state = attestate::State::Modified;
-        }
-    } else {
-//        auto grade = s.grades().value(
-//            class_->subjectsPlan()->at(index.column() - COMMON_SECTIONS).id());
-//        if (grade) {
-//            result = QVariant(*grade);
-//        }
-    }
+    const attestate::State state = model_->cellState(index);
 
     QColor brushColor;
 
@@ -69,7 +41,7 @@ void ColoredCellDelegate::paint(
 
     if (index.column() == 1) {
         // issue date
-        if (!s.issueDate()) {
+        if (!model_->getClass().student(index.row()).issueDate()) {
             newOption.palette.setColor(QPalette::Text, Qt::gray);
         }
     }
@@ -2,8 +2,12 @@
 
 #include "class/class_editor.h"
 
+#include <attestate/serialize.h>
+#include <attestate/exception.h>
+
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QMessageBox>
 
 MainWindow::MainWindow()
 {
@@ -16,6 +20,10 @@ MainWindow::MainWindow()
     fileMenu_->addAction(openAct_);
     connect(openAct_, SIGNAL(triggered()), this, SLOT(open()));
 
+    openWorkspaceAct_ = new QAction(tr("Open &workspace"), this);
+    fileMenu_->addAction(openWorkspaceAct_);
+    connect(openWorkspaceAct_, SIGNAL(triggered()), this, SLOT(openWorkspace()));
+
     saveAct_ = new QAction(tr("&Save"), this);
     fileMenu_->addAction(saveAct_);
     connect(saveAct_, SIGNAL(triggered()), this, SLOT(save()));
@@ -23,14 +31,159 @@ MainWindow::MainWindow()
 
 void MainWindow::open()
 {
-    auto filename = QFileDialog::getOpenFileName(this, "Open csv file", "", "*.csv");
-    ClassEditor* editor = new ClassEditor(filename, this);
-    central_->common->setModel(editor->model());
-    QFileInfo fi(filename);
-    central_->classTab->addTab(editor, fi.fileName());
-    central_->classTab->setTabToolTip(0, fi.absoluteFilePath());
+    auto filenames = QFileDialog::getOpenFileNames(this, "Open csv files", "", "*.csv");
+    if (filenames.isEmpty()) {
+        return;
+    }
+
+    // classes are parsed concurrently, editors are created in files order
+    auto results = attestate::csv::readMany(
+        filenames, attestate::csv::Params{';', QString("dd.MM.yyyy")});
+
+    QStringList errors;
+    for (auto& res : results) {
+        QFileInfo fi(res.filename);
+        if (!res.cls) {
+            errors.push_back(fi.fileName() + ": " + QString::fromStdString(res.error));
+            continue;
+        }
+        ClassEditor* editor = new ClassEditor(std::move(res.cls), this);
+        connect(editor, SIGNAL(submitted()), this, SLOT(saveClass()));
+        central_->common->setModel(editor->model());
+        int tab = central_->classTab->addTab(editor, fi.fileName());
+        central_->classTab->setTabToolTip(tab, fi.absoluteFilePath());
+    }
     central_->classTab->setTabsClosable(true);
+
+    if (!errors.isEmpty()) {
+        QMessageBox::warning(this, tr("Open failed"), errors.join("\n"));
+    }
+}
+
+void MainWindow::openWorkspace()
+{
+    auto filename = QFileDialog::getOpenFileName(this, "Open workspace", "", "*.sqlite");
+    if (filename.isEmpty()) {
+        return;
+    }
+
+    try {
+        std::unique_ptr<attestate::db::Database> db(new attestate::db::Database(filename));
+        std::vector<std::unique_ptr<attestate::Class>> classes;
+        for (auto classId : db->classIds()) {
+            classes.push_back(db->load(classId));
+        }
+
+        if (!closeClasses()) {
+            return;
+        }
+        db_ = std::move(db);
+        for (auto& cls : classes) {
+            const QString title = cls->classId();
+            ClassEditor* editor = new ClassEditor(std::move(cls), this);
+            connect(editor, SIGNAL(submitted()), this, SLOT(saveClass()));
+            central_->common->setModel(editor->model());
+            central_->classTab->addTab(editor, title);
+        }
+        central_->classTab->setTabsClosable(true);
+    } catch (const attestate::Exception& e) {
+        QMessageBox::warning(this, tr("Open failed"), QString::fromStdString(e.what()));
+    }
+}
+
+QList<ClassEditor*> MainWindow::modifiedEditors() const
+{
+    QList<ClassEditor*> res;
+    for (int i = 0; i < central_->classTab->count(); ++i) {
+        auto editor = qobject_cast<ClassEditor*>(central_->classTab->widget(i));
+        if (editor && editor->model()->getClass().state() != attestate::State::Existing) {
+            res.push_back(editor);
+        }
+    }
+    return res;
+}
+
+bool MainWindow::closeClasses()
+{
+    if (!modifiedEditors().isEmpty()) {
+        auto answer = QMessageBox::question(
+            this,
+            tr("Unsaved changes"),
+            tr("Some classes have unsaved changes. Save them?"),
+            QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel,
+            QMessageBox::Save);
+        if (answer == QMessageBox::Cancel) {
+            return false;
+        }
+        if (answer == QMessageBox::Save) {
+            // to workspace opened before, failures are reported by save
+            save();
+            if (!modifiedEditors().isEmpty()) {
+                return false;
+            }
+        }
+    }
+
+    central_->common->setModel(nullptr);
+    while (central_->classTab->count()) {
+        QWidget* editor = central_->classTab->widget(0);
+        central_->classTab->removeTab(0);
+        editor->deleteLater();
+    }
+    return true;
+}
+
+bool MainWindow::openDatabase()
+{
+    if (db_) {
+        return true;
+    }
+    auto filename = QFileDialog::getSaveFileName(this, "Save workspace", "", "*.sqlite");
+    if (filename.isEmpty()) {
+        return false;
+    }
+    try {
+        db_.reset(new attestate::db::Database(filename));
+    } catch (const attestate::Exception& e) {
+        QMessageBox::warning(this, tr("Save failed"), QString::fromStdString(e.what()));
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::saveEditor(int tab)
+{
+    auto editor = qobject_cast<ClassEditor*>(central_->classTab->widget(tab));
+    if (!editor) {
+        return;
+    }
+    try {
+        editor->model()->save(*db_);
+    } catch (const attestate::Exception& e) {
+        QMessageBox::warning(
+            this,
+            tr("Save failed"),
+            central_->classTab->tabText(tab) + ": " + QString::fromStdString(e.what()));
+    }
 }
 
 void MainWindow::save()
-{}
+{
+    if (!openDatabase()) {
+        return;
+    }
+
+    // only changed rows are written, every class in its own transaction
+    for (int i = 0; i < central_->classTab->count(); ++i) {
+        saveEditor(i);
+    }
+}
+
+void MainWindow::saveClass()
+{
+    const int tab = central_->classTab->indexOf(qobject_cast<QWidget*>(sender()));
+    if (tab < 0 || !openDatabase()) {
+        return;
+    }
+    saveEditor(tab);
+}
@@ -2,6 +2,8 @@
 
 #include "class/class_widget.h"
 
+#include <attestate/db.h>
+
 #include <QMainWindow>
 #include <QTabWidget>
 #include <QMenu>
@@ -10,6 +12,10 @@
 #include <QLayout>
 #include <QObject>
 
+#include <memory>
+
+class ClassEditor;
+
 class MainWindow : public QMainWindow {
 
     Q_OBJECT
@@ -20,9 +26,23 @@ public:
 private slots:
     // file slots
     void open();
+    void openWorkspace();
     void save();
+    // class of editor which asked to submit it
+    void saveClass();
 
 private:
+    // asks for workspace file if none is opened, false if cancelled or failed
+    bool openDatabase();
+    // saves class of editor in tab to workspace, failures are reported
+    void saveEditor(int tab);
+
+    // editors of classes which are not saved to workspace
+    QList<ClassEditor*> modifiedEditors() const;
+    // asks to save or discard modified classes and removes all editors,
+    // false if cancelled or not everything is saved
+    bool closeClasses();
+
     class CentralWidget : public QWidget {
     public:
         explicit CentralWidget(MainWindow* mw)
@@ -42,9 +62,13 @@ private:
 
     CentralWidget* central_;
 
+    // chosen on first save or on workspace opening
+    std::unique_ptr<attestate::db::Database> db_;
+
     QMenu* fileMenu_;
 
     // file actions
     QAction* openAct_;
+    QAction* openWorkspaceAct_;
     QAction* saveAct_;
 };
@@ -0,0 +1,26 @@
+QT       += gui widgets core printsupport xml xmlpatterns sql
+
+QMAKE_CXXFLAGS += -std=c++11
+
+CONFIG += thread console
+CONFIG -= app_bundle
+
+TARGET = attestate-cli
+TEMPLATE = app
+
+INCLUDEPATH += \
+    ../attestate-lib/src/include \
+    ../doctpl-lib/src/include
+
+SOURCES += \
+    main.cpp \
+    commands.cpp \
+    report.cpp
+
+HEADERS += \
+    commands.h \
+    report.h
+
+LIBS += \
+    -L/home/dicentra/projects/qt/attestate/attestate-lib/build-debug/src -lattestate \
+    -L/home/dicentra/projects/qt/attestate/doctpl-lib/build-debug/src -ldoctpl
@@ -0,0 +1,236 @@
+#include "commands.h"
+
+#include <attestate/db.h>
+#include <attestate/exception.h>
+#include <attestate/generate.h>
+#include <attestate/subjects.h>
+#include <attestate/validate.h>
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <map>
+#include <set>
+
+namespace cli {
+
+namespace {
+
+QStringList csvFiles(const QStringList& inputs)
+{
+    QStringList res;
+    for (const auto& input : inputs) {
+        if (QFileInfo(input).isDir()) {
+            QDir dir(input);
+            for (const auto& name : dir.entryList(QStringList("*.csv"), QDir::Files, QDir::Name)) {
+                res.push_back(dir.filePath(name));
+            }
+        } else {
+            res.push_back(input);
+        }
+    }
+    return res;
+}
+
+// classes of csv files or, without inputs, of workspace
+attestate::csv::FileResults load(const Options& options)
+{
+    if (!options.inputs.isEmpty()) {
+        const QStringList files = csvFiles(options.inputs);
+        ATT_REQUIRE(!files.isEmpty(), "No csv files found");
+        return attestate::csv::readMany(files, options.csvParams, options.workers);
+    }
+    ATT_REQUIRE(!options.dbPath.isEmpty(), "No input files and no workspace given");
+
+    attestate::db::Database db(options.dbPath);
+    attestate::csv::FileResults res;
+    for (auto classId : db.classIds()) {
+        attestate::csv::FileResult r;
+        r.filename = options.dbPath + "#" + QString::number(classId);
+        try {
+            r.cls = db.load(classId);
+        } catch (const std::exception& ex) {
+            r.error = ex.what();
+        }
+        res.push_back(std::move(r));
+    }
+    return res;
+}
+
+std::vector<ClassReport> classReports(const attestate::csv::FileResults& sources)
+{
+    std::vector<ClassReport> res(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        res[i].source = sources[i].filename;
+        if (!sources[i].cls) {
+            res[i].error = sources[i].error;
+            continue;
+        }
+        res[i].classId = sources[i].cls->classId();
+        res[i].studentsCount = sources[i].cls->studentsCount();
+    }
+    return res;
+}
+
+QString studentName(const attestate::Student& s)
+{
+    return s.familyName() + " " + s.name();
+}
+
+QString message(attestate::validation::ValueError error)
+{
+    return error == attestate::validation::ValueError::Empty ? "empty" : "invalid";
+}
+
+void addIssues(
+    const attestate::Class& c,
+    const attestate::validation::ClassErrors& errors,
+    ClassReport& report)
+{
+    for (const auto& e : errors.propertyErrors) {
+        report.issues.push_back(Issue{boost::none, QString(), e.first, message(e.second)});
+    }
+    if (errors.studentErrors.empty()) {
+        return;
+    }
+
+    std::map<attestate::ID, attestate::Class::Index> indexes;
+    for (attestate::Class::Index i = 0; i < c.studentsCount(); ++i) {
+        indexes.emplace(c.student(i).id(), i);
+    }
+    std::map<attestate::ID, QString> subjectNames;
+    for (size_t i = 0; c.subjectsPlan() && i < c.subjectsPlan()->subjectsCount(); ++i) {
+        subjectNames.emplace(c.subjectsPlan()->at(i).id(), c.subjectsPlan()->at(i).name());
+    }
+
+    for (const auto& s : errors.studentErrors) {
+        const auto at = indexes.at(s.first);
+        const QString name = studentName(c.student(at));
+        for (const auto& e : s.second.propertyErrors) {
+            report.issues.push_back(Issue{at, name, e.first, message(e.second)});
+        }
+        for (const auto& e : s.second.gradeErrors) {
+            auto it = subjectNames.find(e.first);
+            report.issues.push_back(Issue{at, name,
+                it != subjectNames.end() ? it->second : QString("subject"), message(e.second)});
+        }
+    }
+}
+
+// all loaded classes at once, so workers share big classes
+void validateAll(
+    const attestate::csv::FileResults& sources,
+    size_t workers,
+    std::vector<ClassReport>& reports)
+{
+    std::vector<const attestate::Class*> classes;
+    for (const auto& s : sources) {
+        if (s.cls) {
+            classes.push_back(s.cls.get());
+        }
+    }
+    const auto errors = attestate::validation::validate(classes, workers);
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i].cls) {
+            continue;
+        }
+        auto it = errors.find(sources[i].cls->id());
+        reports[i].isValid = it == errors.end();
+        if (it != errors.end()) {
+            addIssues(*sources[i].cls, it->second, reports[i]);
+        }
+    }
+}
+
+// named after source file, unique within run
+QString outputDirName(const QString& source, std::set<QString>& used)
+{
+    QString base = QFileInfo(source).completeBaseName();
+    if (base.isEmpty()) {
+        base = "class";
+    }
+    QString name = base;
+    for (size_t i = 2; used.count(name); ++i) {
+        name = base + "-" + QString::number(i);
+    }
+    used.insert(name);
+    return name;
+}
+
+} // namespace
+
+Report import(const Options& options)
+{
+    ATT_REQUIRE(!options.dbPath.isEmpty(), "Workspace is not given");
+    ATT_REQUIRE(!options.inputs.isEmpty(), "No input files given");
+
+    auto sources = load(options);
+    Report report{"import", options.workers, classReports(sources)};
+
+    attestate::db::Database db(options.dbPath);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i].cls) {
+            continue;
+        }
+        try {
+            report.classes[i].savedRows = db.save(*sources[i].cls);
+        } catch (const std::exception& ex) {
+            report.classes[i].error = ex.what();
+        }
+    }
+    return report;
+}
+
+Report validate(const Options& options)
+{
+    auto sources = load(options);
+    Report report{"validate", options.workers, classReports(sources)};
+    validateAll(sources, options.workers, report.classes);
+    return report;
+}
+
+Report generate(const Options& options)
+{
+    ATT_REQUIRE(!options.templatePath.isEmpty(), "Template is not given");
+    ATT_REQUIRE(!options.outputDir.isEmpty(), "Output directory is not given");
+    ATT_REQUIRE(QFileInfo(options.templatePath).exists(),
+        "Template " << options.templatePath.toStdString() << " not found");
+
+    auto sources = load(options);
+    Report report{"generate", options.workers, classReports(sources)};
+    validateAll(sources, options.workers, report.classes);
+
+    const QDir outputDir(options.outputDir);
+    std::set<QString> usedNames;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i].cls) {
+            continue;
+        }
+        ClassReport& r = report.classes[i];
+        r.outputDir = outputDir.filePath(outputDirName(r.source, usedNames));
+        if (!*r.isValid && !options.force) {
+            r.isSkipped = true;
+            continue;
+        }
+        if (!QDir().mkpath(r.outputDir)) {
+            r.error = "Could not create directory " + r.outputDir.toStdString();
+            continue;
+        }
+        try {
+            const auto res = attestate::gen::generate(
+                *sources[i].cls,
+                attestate::gen::BatchParams{options.templatePath, r.outputDir, options.workers});
+            r.generated = res.generated;
+            for (const auto& e : res.errors) {
+                r.issues.push_back(Issue{e.first, studentName(sources[i].cls->student(e.first)),
+                    "pdf", QString::fromStdString(e.second)});
+            }
+        } catch (const std::exception& ex) {
+            r.error = ex.what();
+        }
+    }
+    return report;
+}
+
+} // namespace cli
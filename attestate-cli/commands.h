@@ -0,0 +1,35 @@
+#pragma once
+
+#include "report.h"
+
+#include <attestate/serialize.h>
+
+#include <QString>
+#include <QStringList>
+
+namespace cli {
+
+struct Options {
+    QStringList inputs; // csv files and directories with csv files
+    attestate::csv::Params csvParams;
+    size_t workers; // 0 means hardware threads count
+    QString dbPath; // workspace
+    QString templatePath;
+    QString outputDir;
+    bool force; // generate classes with validation errors
+};
+
+// Commands throw on wrong options only,
+// failures of single classes are kept in report.
+
+// reads csv files and saves classes to workspace
+Report import(const Options& options);
+
+// checks classes from csv files or, without inputs, all classes of workspace
+Report validate(const Options& options);
+
+// validates classes and prints pdf of each student into
+// a subdirectory of output dir named after the source
+Report generate(const Options& options);
+
+} // namespace cli
@@ -0,0 +1,123 @@
+#include "commands.h"
+#include "report.h"
+
+#include <attestate/exception.h>
+
+#include <QApplication>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace cli {
+namespace {
+
+// some classes failed or have errors
+const int EXIT_ISSUES = 2;
+
+void usage(std::ostream& os)
+{
+    os << "Usage: attestate-cli <command> [options] [FILE|DIR...]\n"
+        << "Commands:\n"
+        << "  import             read csv files and save classes to workspace\n"
+        << "  validate           check csv files, or all classes of workspace if no files given\n"
+        << "  generate           validate and print pdf of every student,\n"
+        << "                     into a subdirectory of output directory per class\n"
+        << "Options:\n"
+        << "  --db FILE          workspace file\n"
+        << "  --template FILE    doctpl template for generate\n"
+        << "  --out DIR          output directory for generate\n"
+        << "  --force            generate classes with validation errors\n"
+        << "  --workers N        threads for reading, validation and printing (default hardware threads)\n"
+        << "  --delimiter C      csv delimiter (default ;)\n"
+        << "  --date-format F    csv date format (default dd.MM.yyyy)\n"
+        << "  --json FILE        write machine-readable report to FILE, - for stdout\n"
+        << "Directories are scanned for *.csv files. Exit code is 2 if some classes\n"
+        << "could not be processed or have errors.\n";
+}
+
+} // namespace
+} // namespace cli
+
+int main(int argc, char** argv)
+{
+    using namespace cli;
+
+    if (argc < 2 || std::string(argv[1]) == "--help") {
+        usage(argc < 2 ? std::cerr : std::cout);
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    // pdf printing needs a gui application, but no display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    const std::string command = argv[1];
+    Options options{{}, attestate::csv::Params{';', "dd.MM.yyyy"}, 0, "", "", "", false};
+    std::string jsonPath;
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&] () -> std::string
+            {
+                ATT_REQUIRE(i + 1 < argc, "No value for option " << arg);
+                return argv[++i];
+            };
+            if (arg == "--db") {
+                options.dbPath = QString::fromStdString(value());
+            } else if (arg == "--template") {
+                options.templatePath = QString::fromStdString(value());
+            } else if (arg == "--out") {
+                options.outputDir = QString::fromStdString(value());
+            } else if (arg == "--force") {
+                options.force = true;
+            } else if (arg == "--workers") {
+                options.workers = std::stoul(value());
+            } else if (arg == "--delimiter") {
+                const std::string delimiter = value();
+                ATT_REQUIRE(delimiter.size() == 1, "Delimiter must be one character");
+                options.csvParams.delimiter = delimiter[0];
+            } else if (arg == "--date-format") {
+                options.csvParams.dateFormat = QString::fromStdString(value());
+            } else if (arg == "--json") {
+                jsonPath = value();
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                usage(std::cerr);
+                return EXIT_FAILURE;
+            } else {
+                options.inputs.push_back(QString::fromStdString(arg));
+            }
+        }
+
+        Report report;
+        if (command == "import") {
+            report = import(options);
+        } else if (command == "validate") {
+            report = validate(options);
+        } else if (command == "generate") {
+            report = generate(options);
+        } else {
+            usage(std::cerr);
+            return EXIT_FAILURE;
+        }
+
+        if (jsonPath == "-") {
+            writeJson(report, std::cout);
+        } else {
+            printSummary(report, std::cout);
+            if (!jsonPath.empty()) {
+                std::ofstream os(jsonPath);
+                ATT_REQUIRE(os, "Could not open file " << jsonPath);
+                writeJson(report, os);
+            }
+        }
+        return report.isOk() ? EXIT_SUCCESS : EXIT_ISSUES;
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,140 @@
+#include "report.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace cli {
+
+bool Report::isOk() const
+{
+    for (const auto& c : classes) {
+        if (!c.error.empty() || !c.issues.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+std::string escape(const std::string& s)
+{
+    std::ostringstream os;
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (c == '\n') {
+            os << "\\n";
+        } else if (c == '\t') {
+            os << "\\t";
+        } else if (c < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+        } else {
+            os << c;
+        }
+    }
+    return os.str();
+}
+
+std::string quote(const std::string& s) { return "\"" + escape(s) + "\""; }
+
+std::string quote(const QString& s) { return quote(s.toStdString()); }
+
+void writeIssue(const Issue& issue, std::ostream& os)
+{
+    os << "{";
+    if (issue.student) {
+        os << "\"student\": " << *issue.student
+            << ", \"name\": " << quote(issue.studentName) << ", ";
+    }
+    os << "\"field\": " << quote(issue.field)
+        << ", \"message\": " << quote(issue.message) << "}";
+}
+
+void writeClass(const ClassReport& c, std::ostream& os)
+{
+    os << "    {\"source\": " << quote(c.source);
+    if (!c.error.empty()) {
+        os << ", \"error\": " << quote(c.error) << "}";
+        return;
+    }
+    os << ", \"class\": " << quote(c.classId)
+        << ", \"students\": " << c.studentsCount;
+    if (c.savedRows) {
+        os << ", \"saved_rows\": " << *c.savedRows;
+    }
+    if (c.isValid) {
+        os << ", \"valid\": " << (*c.isValid ? "true" : "false");
+    }
+    if (!c.outputDir.isEmpty()) {
+        os << ", \"output_dir\": " << quote(c.outputDir)
+            << ", \"skipped\": " << (c.isSkipped ? "true" : "false")
+            << ", \"generated\": " << c.generated;
+    }
+    os << ", \"issues\": [";
+    for (size_t i = 0; i < c.issues.size(); ++i) {
+        os << (i ? ",\n" : "\n") << "      ";
+        writeIssue(c.issues[i], os);
+    }
+    os << (c.issues.empty() ? "]}" : "\n    ]}");
+}
+
+} // namespace
+
+void writeJson(const Report& report, std::ostream& os)
+{
+    size_t failed = 0;
+    size_t withIssues = 0;
+    size_t generated = 0;
+    for (const auto& c : report.classes) {
+        failed += c.error.empty() ? 0 : 1;
+        withIssues += c.issues.empty() ? 0 : 1;
+        generated += c.generated;
+    }
+
+    os << "{\n"
+        << "  \"command\": " << quote(report.command) << ",\n"
+        << "  \"workers\": " << report.workers << ",\n"
+        << "  \"ok\": " << (report.isOk() ? "true" : "false") << ",\n"
+        << "  \"summary\": {\"classes\": " << report.classes.size()
+        << ", \"failed\": " << failed
+        << ", \"with_issues\": " << withIssues
+        << ", \"generated\": " << generated << "},\n"
+        << "  \"classes\": [";
+    for (size_t i = 0; i < report.classes.size(); ++i) {
+        os << (i ? ",\n" : "\n");
+        writeClass(report.classes[i], os);
+    }
+    os << "\n  ]\n}\n";
+}
+
+void printSummary(const Report& report, std::ostream& os)
+{
+    for (const auto& c : report.classes) {
+        os << c.source.toStdString() << ": ";
+        if (!c.error.empty()) {
+            os << "error: " << c.error << "\n";
+            continue;
+        }
+        os << c.classId.toStdString() << ", " << c.studentsCount << " students";
+        if (c.savedRows) {
+            os << ", " << *c.savedRows << " rows saved";
+        }
+        if (c.isValid) {
+            os << (*c.isValid ? ", valid" : ", invalid");
+        }
+        if (!c.outputDir.isEmpty()) {
+            os << (c.isSkipped ? ", skipped" : ", " + std::to_string(c.generated) + " pdf generated");
+        }
+        os << "\n";
+        for (const auto& issue : c.issues) {
+            os << "  ";
+            if (issue.student) {
+                os << "#" << *issue.student + 1 << " " << issue.studentName.toStdString() << ": ";
+            }
+            os << issue.field.toStdString() << ": " << issue.message.toStdString() << "\n";
+        }
+    }
+}
+
+} // namespace cli
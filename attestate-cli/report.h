@@ -0,0 +1,54 @@
+#pragma once
+
+#include <attestate/class.h>
+
+#include <QString>
+
+#include <boost/optional.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cli {
+
+// validation error or failed pdf of a class
+struct Issue {
+    boost::optional<attestate::Class::Index> student; // none for class properties
+    QString studentName;
+    QString field; // property tag, subject name or "pdf"
+    QString message;
+};
+
+// result of a command for one csv file or workspace class
+struct ClassReport {
+    QString source;
+    std::string error; // class could not be read or saved
+
+    attestate::ClassId classId;
+    size_t studentsCount = 0;
+
+    boost::optional<size_t> savedRows; // import
+    boost::optional<bool> isValid; // validate, generate
+    bool isSkipped = false; // not generated because of validation errors
+    QString outputDir;
+    size_t generated = 0;
+
+    std::vector<Issue> issues;
+};
+
+struct Report {
+    std::string command;
+    size_t workers;
+    std::vector<ClassReport> classes;
+
+    // no read, save or generation failures and no validation errors
+    bool isOk() const;
+};
+
+void writeJson(const Report& report, std::ostream& os);
+
+// line per class
+void printSummary(const Report& report, std::ostream& os);
+
+} // namespace cli
@@ -2,7 +2,9 @@ TEMPLATE = subdirs
 
 SUBDIRS = \
     src \
-    tests
+    tests \
+    bench
 
 tests.depends = src
+bench.depends = src
 
@@ -0,0 +1,39 @@
+#include "bench.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Global operator new of bench binary counts heap allocations of library code.
+
+namespace {
+
+std::atomic<size_t> allocationsCount(0);
+
+void* allocate(size_t size)
+{
+    allocationsCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace attestate {
+namespace bench {
+
+size_t allocations() { return allocationsCount.load(std::memory_order_relaxed); }
+
+} // namespace bench
+} // namespace attestate
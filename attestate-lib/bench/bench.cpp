@@ -0,0 +1,211 @@
+#include "bench.h"
+
+#include <attestate/exception.h>
+
+#include <QApplication>
+#include <QDir>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+
+namespace attestate {
+namespace bench {
+
+double Result::minNsPerOp() const
+{
+    if (runs.empty()) {
+        return 0;
+    }
+    return *std::min_element(runs.begin(), runs.end()) / std::max<size_t>(operations, 1);
+}
+
+double Result::medianNsPerOp() const
+{
+    if (runs.empty()) {
+        return 0;
+    }
+    auto sorted = runs;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted.at(sorted.size() / 2) / std::max<size_t>(operations, 1);
+}
+
+double Result::allocationsPerOp() const
+{
+    return double(allocations) / std::max<size_t>(operations, 1);
+}
+
+bool isSelected(const Context& ctx, const std::string& name)
+{
+    return ctx.filter.empty() || name.find(ctx.filter) != std::string::npos;
+}
+
+void printTable(const Results& results, std::ostream& os)
+{
+    for (const auto& r : results) {
+        os << std::left << std::setw(40) << r.name
+            << std::right << std::setw(10) << r.size
+            << std::setw(14) << std::fixed << std::setprecision(1) << r.medianNsPerOp()
+            << " ns/op"
+            << std::setw(12) << std::setprecision(1) << r.allocationsPerOp() << " allocs/op";
+        if (r.bytes) {
+            const double minRun = *std::min_element(r.runs.begin(), r.runs.end());
+            os << std::setw(10) << std::setprecision(1) << r.bytes / minRun * 1e3 << " MB/s";
+        }
+        os << "\n";
+    }
+}
+
+namespace {
+
+std::string escape(const std::string& s)
+{
+    std::string res;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res;
+}
+
+} // namespace
+
+void writeJson(const Context& ctx, const Results& results, std::ostream& os)
+{
+    os << "{\n"
+        << "  \"compiler\": \"" << escape(__VERSION__) << "\",\n"
+        << "  \"qt\": \"" << qVersion() << "\",\n"
+        << "  \"repeat\": " << ctx.repeat << ",\n"
+        << "  \"subjects\": " << ctx.subjects << ",\n"
+        << "  \"workers\": " << ctx.workers << ",\n"
+        << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << (i ? ",\n" : "\n")
+            << "    {\"name\": \"" << escape(r.name) << "\""
+            << ", \"size\": " << r.size
+            << ", \"operations\": " << r.operations
+            << ", \"bytes\": " << r.bytes
+            << std::fixed << std::setprecision(1)
+            << ", \"min_ns_per_op\": " << r.minNsPerOp()
+            << ", \"median_ns_per_op\": " << r.medianNsPerOp()
+            << ", \"allocations_per_op\": " << r.allocationsPerOp()
+            << ", \"runs_ns\": [";
+        for (size_t j = 0; j < r.runs.size(); ++j) {
+            os << (j ? ", " : "") << r.runs[j];
+        }
+        os << "]}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+namespace {
+
+std::vector<size_t> parseSizes(const std::string& s)
+{
+    std::vector<size_t> res;
+    std::istringstream is(s);
+    std::string item;
+    while (std::getline(is, item, ',')) {
+        res.push_back(std::stoul(item));
+    }
+    ATT_REQUIRE(!res.empty(), "Empty sizes list");
+    return res;
+}
+
+void usage(std::ostream& os)
+{
+    os << "Usage: attestate-bench [options]\n"
+        << "  --sizes N[,N...]   students in synthetic classes (default 25,1000,10000,100000)\n"
+        << "  --subjects N       subjects in synthetic plans (default 25)\n"
+        << "  --repeat N         timed runs per benchmark (default 5)\n"
+        << "  --filter STR       run only benchmarks whose name contains STR\n"
+        << "  --json FILE        write machine-readable results to FILE\n"
+        << "  --workdir DIR      directory for temporary files (default system temp)\n"
+        << "  --template FILE    doctpl template for generation benchmarks\n"
+        << "  --print-limit N    max students printed to pdf per run (default 10)\n"
+        << "  --workers N        threads for parallel benchmarks (default hardware threads)\n";
+}
+
+} // namespace
+
+} // namespace bench
+} // namespace attestate
+
+int main(int argc, char** argv)
+{
+    using namespace attestate::bench;
+
+    // pdf printing needs a gui application, but no display
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    Context ctx{{25, 1000, 10000, 100000}, 25, 5, "", QDir::tempPath(), "", 10, 0};
+    std::string jsonPath;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&] () -> std::string
+            {
+                ATT_REQUIRE(i + 1 < argc, "No value for option " << arg);
+                return argv[++i];
+            };
+            if (arg == "--sizes") {
+                ctx.sizes = parseSizes(value());
+            } else if (arg == "--subjects") {
+                ctx.subjects = std::stoul(value());
+            } else if (arg == "--repeat") {
+                ctx.repeat = std::max<size_t>(std::stoul(value()), 1);
+            } else if (arg == "--filter") {
+                ctx.filter = value();
+            } else if (arg == "--json") {
+                jsonPath = value();
+            } else if (arg == "--workdir") {
+                ctx.workDir = QString::fromStdString(value());
+            } else if (arg == "--template") {
+                ctx.templatePath = QString::fromStdString(value());
+            } else if (arg == "--print-limit") {
+                ctx.printLimit = std::stoul(value());
+            } else if (arg == "--workers") {
+                ctx.workers = std::stoul(value());
+            } else {
+                usage(arg == "--help" ? std::cout : std::cerr);
+                return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+        }
+
+        const std::vector<Suite> suites = {
+            containersBench,
+            serializeBench,
+            validateBench,
+            gradesBench,
+            generateBench
+        };
+
+        Results results;
+        for (size_t size : ctx.sizes) {
+            for (const auto& suite : suites) {
+                suite(ctx, size, results);
+            }
+        }
+
+        printTable(results, std::cout);
+
+        if (!jsonPath.empty()) {
+            std::ofstream os(jsonPath);
+            ATT_REQUIRE(os, "Could not open file " << jsonPath);
+            writeJson(ctx, results, os);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
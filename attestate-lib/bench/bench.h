@@ -0,0 +1,98 @@
+#pragma once
+
+#include <attestate/class.h>
+
+#include <QString>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+
+namespace attestate {
+namespace bench {
+
+// command line driven settings shared by all suites
+struct Context {
+    std::vector<size_t> sizes;  // students in synthetic classes
+    size_t subjects;            // subjects in synthetic plans
+    size_t repeat;              // timed runs per benchmark
+    std::string filter;         // only benchmarks with names containing it
+    QString workDir;            // for temporary files
+    QString templatePath;       // doctpl template, generation is skipped if empty
+    size_t printLimit;          // max students printed to pdf per run
+    size_t workers;             // for parallel benchmarks, 0 means hardware threads
+};
+
+struct Result {
+    std::string name;
+    size_t size;        // rows in benchmarked data
+    size_t operations;  // operations per run
+    size_t bytes;       // bytes processed per run, 0 if not applicable
+    std::vector<double> runs; // ns per run
+    size_t allocations; // operator new calls per run, Qt data allocated by malloc is not counted
+
+    double minNsPerOp() const;
+    double medianNsPerOp() const;
+    double allocationsPerOp() const;
+};
+
+typedef std::vector<Result> Results;
+
+bool isSelected(const Context& ctx, const std::string& name);
+
+// operator new calls since start, all threads
+size_t allocations();
+
+// runs f() ctx.repeat times after one warm-up run
+template <class F>
+void measure(
+    const Context& ctx, Results& results,
+    const std::string& name, size_t size, size_t operations, size_t bytes,
+    F f)
+{
+    if (!isSelected(ctx, name)) {
+        return;
+    }
+    Result r{name, size, operations, bytes, {}, 0};
+    f();
+    const size_t allocationsBefore = allocations();
+    for (size_t i = 0; i < ctx.repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        r.runs.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    r.allocations = (allocations() - allocationsBefore) / ctx.repeat;
+    results.push_back(std::move(r));
+}
+
+template <class F>
+void measure(
+    const Context& ctx, Results& results,
+    const std::string& name, size_t size, size_t operations, F f)
+{
+    measure(ctx, results, name, size, operations, 0, f);
+}
+
+void printTable(const Results& results, std::ostream& os);
+void writeJson(const Context& ctx, const Results& results, std::ostream& os);
+
+// synthetic data, deterministic for given arguments
+
+std::unique_ptr<Class> syntheticClass(size_t students, size_t subjects, uint32_t seed);
+
+// benchmark suites
+
+typedef std::function<void(const Context&, size_t size, Results&)> Suite;
+
+void containersBench(const Context& ctx, size_t size, Results& results);
+void serializeBench(const Context& ctx, size_t size, Results& results);
+void validateBench(const Context& ctx, size_t size, Results& results);
+void gradesBench(const Context& ctx, size_t size, Results& results);
+void generateBench(const Context& ctx, size_t size, Results& results);
+
+} // namespace bench
+} // namespace attestate
@@ -0,0 +1,21 @@
+include(../defaults.pri)
+
+TEMPLATE = app
+
+TARGET = attestate-bench
+
+SOURCES += \
+    bench.cpp \
+    allocations.cpp \
+    synthetic.cpp \
+    containers_bench.cpp \
+    serialize_bench.cpp \
+    validate_bench.cpp \
+    grades_bench.cpp \
+    generate_bench.cpp
+
+LIBS += \
+    -L../src -lattestate
+
+HEADERS += \
+    bench.h
@@ -0,0 +1,77 @@
+#include "bench.h"
+
+#include "../src/unique_vector.h"
+#include "../src/unique_tree.h"
+
+#include <memory>
+#include <random>
+
+namespace attestate {
+namespace bench {
+
+namespace {
+
+typedef std::unique_ptr<uint32_t> ValuePtr;
+
+struct Key {
+    explicit Key(const ValuePtr& p) : k(*p) {}
+
+    bool operator < (const Key& o) const { return k < o.k; }
+
+    uint32_t k;
+};
+
+std::ostream& operator << (std::ostream& os, const Key& k)
+{
+    os << k.k;
+    return os;
+}
+
+const size_t OPERATIONS = 1000;
+
+// positional operations at random places of a container of given size,
+// every run leaves the container size unchanged
+template <class Container>
+void run(const Context& ctx, const std::string& name, size_t size, Results& results)
+{
+    std::mt19937 gen(size);
+    uint32_t next = 0;
+
+    Container c;
+    for (size_t i = 0; i < size; ++i) {
+        c.append(ValuePtr(new uint32_t(next++)));
+    }
+
+    measure(ctx, results, name + "/insert_remove", size, OPERATIONS, [&] {
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            c.insert(ValuePtr(new uint32_t(next++)), gen() % (c.size() + 1));
+            c.remove(gen() % c.size());
+        }
+    });
+
+    measure(ctx, results, name + "/move", size, OPERATIONS, [&] {
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            c.move(gen() % c.size(), gen() % c.size());
+        }
+    });
+
+    measure(ctx, results, name + "/at", size, OPERATIONS, [&] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            sum += *c.at(gen() % c.size());
+        }
+        volatile uint64_t sink = sum;
+        (void)sink;
+    });
+}
+
+} // namespace
+
+void containersBench(const Context& ctx, size_t size, Results& results)
+{
+    run<UniqueVector<ValuePtr, Key>>(ctx, "UniqueVector", size, results);
+    run<UniqueTree<ValuePtr, Key>>(ctx, "UniqueTree", size, results);
+}
+
+} // namespace bench
+} // namespace attestate
@@ -0,0 +1,65 @@
+#include "bench.h"
+
+#include <attestate/generate.h>
+#include <attestate/exception.h>
+
+#include <doctpl/template.h>
+#include <doctpl/serialize.h>
+
+#include <QFile>
+#include <QDir>
+
+namespace attestate {
+namespace bench {
+
+void generateBench(const Context& ctx, size_t size, Results& results)
+{
+    if (ctx.templatePath.isEmpty()) {
+        return;
+    }
+
+    auto cls = syntheticClass(size, ctx.subjects, size);
+    std::unique_ptr<doctpl::Template> doc = doctpl::xml::read(ctx.templatePath);
+
+    measure(ctx, results, "gen::fillTemplate", size, size, [&] {
+        for (size_t i = 0; i < size; ++i) {
+            gen::fillTemplate(*cls, i, *doc);
+        }
+    });
+
+    measure(ctx, results, "gen::BoundTemplate::fill", size, size, [&] {
+        gen::BoundTemplate bound(*doc);
+        for (size_t i = 0; i < size; ++i) {
+            bound.fill(*cls, i);
+        }
+    });
+
+    const size_t printed = std::min(size, ctx.printLimit);
+    const QString path = ctx.workDir + "/attestate-bench.pdf";
+    measure(ctx, results, "gen::BoundTemplate::fill+Template::print", size, printed, [&] {
+        gen::BoundTemplate bound(*doc);
+        for (size_t i = 0; i < printed; ++i) {
+            bound.fill(*cls, i);
+            doc->print(path);
+        }
+    });
+    QFile::remove(path);
+
+    // batch of print limit size, so that runs are comparable with printing above
+    auto batchCls = syntheticClass(printed, ctx.subjects, size);
+    QDir outDir(ctx.workDir + "/attestate-bench-batch");
+    outDir.mkpath(outDir.path());
+    for (size_t workers : {size_t(1), ctx.workers}) {
+        const std::string name = "gen::generate(workers="
+            + (workers ? std::to_string(workers) : std::string("auto")) + ")";
+        measure(ctx, results, name, size, printed, [&] {
+            auto res = gen::generate(
+                *batchCls, gen::BatchParams{ctx.templatePath, outDir.path(), workers});
+            ATT_REQUIRE(res.errors.empty(), "Batch generation failed: " << res.errors.begin()->second);
+        });
+    }
+    outDir.removeRecursively();
+}
+
+} // namespace bench
+} // namespace attestate
@@ -0,0 +1,111 @@
+#include "bench.h"
+
+#include <attestate/grades.h>
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+
+#include <random>
+
+namespace attestate {
+namespace bench {
+
+namespace {
+
+// SubjectsPlan::diff of a plan with size subjects against its shuffled copy
+void subjectsPlanBench(const Context& ctx, size_t size, Results& results)
+{
+    SubjectPtrVector subjects;
+    for (size_t i = 0; i < size; ++i) {
+        subjects.push_back(std::make_shared<Subject>(ID::gen(), QString::number(i)));
+    }
+    SubjectsPlan plan(ID::gen(), "plan", subjects);
+
+    std::mt19937 gen(size);
+    std::shuffle(subjects.begin(), subjects.end(), gen);
+    subjects.resize(size - size / 10);
+    SubjectsPlan other(ID::gen(), "other", subjects);
+
+    measure(ctx, results, "SubjectsPlan::diff", size, 1, [&] {
+        auto diff = plan.diff(other);
+        ATT_ASSERT(!diff.empty());
+    });
+}
+
+} // namespace
+
+void gradesBench(const Context& ctx, size_t size, Results& results)
+{
+    auto cls = syntheticClass(size, ctx.subjects, size);
+    const auto subjectIds = cls->subjectsPlan()->subjectIds();
+
+    // every third grade of every student is changed
+    std::vector<SubjectsGrades> changed;
+    changed.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        SubjectsGrades g = cls->student(i).grades();
+        for (size_t j = i % 3; j < subjectIds.size(); j += 3) {
+            const grades::Value v = g.value(subjectIds[j]) == grades::Value("5") ? "4" : "5";
+            g.setValue(subjectIds[j], v);
+        }
+        changed.push_back(std::move(g));
+    }
+
+    std::vector<SubjectsGrades::Diff> diffs(size);
+    measure(ctx, results, "SubjectsGrades::diff", size, size, [&] {
+        for (size_t i = 0; i < size; ++i) {
+            diffs[i] = cls->student(i).grades().diff(changed[i]);
+        }
+    });
+
+    // apply and revert, so that every run starts from the same grades
+    std::vector<SubjectsGrades::Diff> reversed;
+    for (const auto& d : diffs) {
+        reversed.push_back(grades::reverseDiff(d));
+    }
+    measure(ctx, results, "SubjectsGrades::applyDiff", size, 2 * size, [&] {
+        for (size_t i = 0; i < size; ++i) {
+            changed[i].applyDiff(reversed[i]);
+            changed[i].applyDiff(diffs[i]);
+        }
+    });
+
+    // per cell classification as done by pdf generation and validation
+    std::vector<grades::Value> values;
+    std::vector<grades::Code> codes;
+    for (size_t i = 0; i < size; ++i) {
+        for (const auto& id : subjectIds) {
+            const auto v = cls->student(i).grades().value(id);
+            if (v) {
+                values.push_back(*v);
+                codes.push_back(grades::code(*v));
+            }
+        }
+    }
+
+    measure(ctx, results, "grades::type(Value)", size, values.size(), [&] {
+        size_t marked = 0;
+        for (const auto& v : values) {
+            if (grades::isValid(v) && grades::type(v) == grades::Type::HasRepresentation) {
+                marked += grades::representation(v).size();
+            }
+        }
+        ATT_ASSERT(marked);
+    });
+
+    measure(ctx, results, "grades::type(Code)", size, codes.size(), [&] {
+        size_t marked = 0;
+        for (const auto c : codes) {
+            if (grades::isValid(c) && grades::type(c) == grades::Type::HasRepresentation) {
+                marked += grades::representation(c).size();
+            }
+        }
+        ATT_ASSERT(marked);
+    });
+
+    if (size <= 10000) {
+        subjectsPlanBench(ctx, size, results);
+    }
+}
+
+} // namespace bench
+} // namespace attestate
@@ -0,0 +1,136 @@
+#include "bench.h"
+
+#include <attestate/serialize.h>
+#include <attestate/snapshot.h>
+#include <attestate/db.h>
+#include <attestate/journal.h>
+#include <attestate/grades.h>
+#include <attestate/exception.h>
+
+#include <QFileInfo>
+#include <QFile>
+
+namespace attestate {
+namespace bench {
+
+void serializeBench(const Context& ctx, size_t size, Results& results)
+{
+    const csv::Params params{';', "dd.MM.yyyy"};
+    const QString path = ctx.workDir + "/attestate-bench-" + QString::number(size) + ".csv";
+
+    auto cls = syntheticClass(size, ctx.subjects, size);
+    csv::write(*cls, path, params);
+    const size_t bytes = QFileInfo(path).size();
+
+    measure(ctx, results, "csv::write", size, size, bytes, [&] {
+        csv::write(*cls, path, params);
+    });
+
+    measure(ctx, results, "csv::read", size, size, bytes, [&] {
+        auto c = csv::read(path, params);
+        ATT_ASSERT(c->studentsCount() == size);
+    });
+
+    measure(ctx, results, "csv::readStream", size, size, bytes, [&] {
+        auto c = csv::readStream(path, params);
+        ATT_ASSERT(c->studentsCount() == size);
+    });
+
+    QFile::remove(path);
+
+    const QString snapshotPath = ctx.workDir + "/attestate-bench-" + QString::number(size) + ".atts";
+    snapshot::write({cls.get()}, snapshotPath);
+    const size_t snapshotBytes = QFileInfo(snapshotPath).size();
+
+    measure(ctx, results, "snapshot::write", size, size, snapshotBytes, [&] {
+        snapshot::write({cls.get()}, snapshotPath);
+    });
+
+    measure(ctx, results, "snapshot::read", size, size, snapshotBytes, [&] {
+        auto classes = snapshot::read(snapshotPath);
+        ATT_ASSERT(classes.size() == 1 && classes[0]->studentsCount() == size);
+    });
+
+    QFile::remove(snapshotPath);
+
+    const QString dbPath = ctx.workDir + "/attestate-bench-" + QString::number(size) + ".sqlite";
+
+    measure(ctx, results, "db::save full", size, size, [&] {
+        QFile::remove(dbPath);
+        auto c = syntheticClass(size, ctx.subjects, size);
+        db::Database(dbPath).save(*c);
+    });
+
+    {
+        QFile::remove(dbPath);
+        db::Database database(dbPath);
+        database.save(*cls);
+        const ID subjectId = cls->subjectsPlan()->at(0).id();
+        size_t i = 0;
+        measure(ctx, results, "db::save one grade", size, 1, [&] {
+            Student& s = cls->student(i++ % size);
+            const grades::Value v = s.grades().value(subjectId) == grades::Value("5") ? "4" : "5";
+            s.grades().setValue(subjectId, v);
+            ATT_ASSERT(database.save(*cls) == 1);
+        });
+
+        measure(ctx, results, "db::load", size, size, QFileInfo(dbPath).size(), [&] {
+            auto c = database.load(cls->id().dbid());
+            ATT_ASSERT(c->studentsCount() == size);
+        });
+    }
+    QFile::remove(dbPath);
+
+    const QString basePath = ctx.workDir + "/attestate-bench-" + QString::number(size) + ".atts";
+    const QString journalPath = ctx.workDir + "/attestate-bench-" + QString::number(size) + ".attj";
+    {
+        journal::Journal j(basePath, journalPath);
+        j.load();
+        j.compact({cls.get()});
+        const ID subjectId = cls->subjectsPlan()->at(1).id();
+        size_t i = 0;
+        measure(ctx, results, "journal one grade", size, 1, [&] {
+            const Class::Index at = i++ % size;
+            Student& s = cls->student(at);
+            const grades::OptionalValue old = s.grades().value(subjectId);
+            const SubjectsGrades::Diff diff{
+                {subjectId, {old, grades::Value(old && *old == "5" ? "4" : "5")}}};
+            s.grades().applyDiff(diff);
+            j.gradesChanged(0, at, *cls, diff);
+        });
+
+        measure(ctx, results, "journal::load", size, size, [&] {
+            auto classes = journal::Journal(basePath, journalPath).load();
+            ATT_ASSERT(classes.size() == 1 && classes[0]->studentsCount() == size);
+        });
+    }
+    QFile::remove(basePath);
+    QFile::remove(journalPath);
+
+    // same students split into several class files
+    const size_t FILES = 8;
+    QStringList paths;
+    size_t totalBytes = 0;
+    for (size_t i = 0; i < FILES; ++i) {
+        const QString filePath = ctx.workDir + "/attestate-bench-" + QString::number(size)
+            + "-" + QString::number(i) + ".csv";
+        auto part = syntheticClass(std::max<size_t>(size / FILES, 1), ctx.subjects, size + i);
+        csv::write(*part, filePath, params);
+        totalBytes += QFileInfo(filePath).size();
+        paths.push_back(filePath);
+    }
+
+    measure(ctx, results, "csv::readMany", size, FILES, totalBytes, [&] {
+        auto res = csv::readMany(paths, params, ctx.workers);
+        for (const auto& r : res) {
+            ATT_REQUIRE(r.cls, "Could not read " << r.filename.toStdString() << ": " << r.error);
+        }
+    });
+
+    for (const auto& p : paths) {
+        QFile::remove(p);
+    }
+}
+
+} // namespace bench
+} // namespace attestate
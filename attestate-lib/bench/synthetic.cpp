@@ -0,0 +1,82 @@
+#include "bench.h"
+
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+#include <attestate/grades.h>
+
+#include <random>
+
+namespace attestate {
+namespace bench {
+
+namespace {
+
+const std::vector<const char*> FAMILY_NAMES = {
+    "Иванов", "Петров", "Сидоров", "Кузнецов", "Смирнов", "Попов", "Лебедев", "Козлов"
+};
+
+const std::vector<const char*> NAMES = {
+    "Иван", "Петр", "Сергей", "Алексей", "Дмитрий", "Андрей", "Михаил", "Николай"
+};
+
+const std::vector<const char*> PARENTAL_NAMES = {
+    "Иванович", "Петрович", "Сергеевич", "Алексеевич", "Дмитриевич", "Андреевич"
+};
+
+// mostly marks, some auxilliary and none grades
+const std::vector<const char*> GRADES = {
+    "5", "5", "4", "4", "4", "3", "3", "д", "+", "н"
+};
+
+template <class T>
+const T& pick(const std::vector<T>& v, std::mt19937& gen)
+{
+    return v.at(gen() % v.size());
+}
+
+} // namespace
+
+std::unique_ptr<Class> syntheticClass(size_t students, size_t subjects, uint32_t seed)
+{
+    std::mt19937 gen(seed);
+
+    SubjectPtrVector subjectsV;
+    for (size_t i = 0; i < subjects; ++i) {
+        subjectsV.push_back(std::make_shared<Subject>(
+            ID::gen(), QString::fromUtf8("Предмет ") + QString::number(i + 1)));
+    }
+    auto plan = std::make_shared<SubjectsPlan>(
+        ID::gen(), QString::fromUtf8("Учебный план"), subjectsV);
+
+    const auto& layout = plan->layout();
+
+    std::vector<Class::StudentPtr> studentsV;
+    studentsV.reserve(students);
+    for (size_t i = 0; i < students; ++i) {
+        std::map<ID, grades::Value> values;
+        for (const auto& s : subjectsV) {
+            values.emplace(s->id(), QString::fromUtf8(pick(GRADES, gen)));
+        }
+        studentsV.push_back(Class::StudentPtr(new Student(
+            ID::gen(),
+            QString::fromUtf8(pick(FAMILY_NAMES, gen)),
+            QString::fromUtf8(pick(NAMES, gen)),
+            QString::fromUtf8(pick(PARENTAL_NAMES, gen)),
+            QDate(1998 + gen() % 3, 1 + gen() % 12, 1 + gen() % 28),
+            SubjectsGrades(layout, values),
+            boost::none,
+            QString::number(i + 1).rightJustified(7, '0'),
+            boost::none)));
+    }
+
+    return std::unique_ptr<Class>(new Class(
+        ID::gen(),
+        QString::fromUtf8("11А"),
+        Year(2016),
+        QDate(2016, 6, 25),
+        std::move(studentsV),
+        plan));
+}
+
+} // namespace bench
+} // namespace attestate
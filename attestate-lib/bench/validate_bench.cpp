@@ -0,0 +1,69 @@
+#include "bench.h"
+
+#include <attestate/validate.h>
+#include <attestate/class_table.h>
+#include <attestate/grades.h>
+
+namespace attestate {
+namespace bench {
+
+void validateBench(const Context& ctx, size_t size, Results& results)
+{
+    auto cls = syntheticClass(size, ctx.subjects, size);
+
+    measure(ctx, results, "validation::validate(Class)", size, size, [&] {
+        volatile bool hasErrors = !!validation::validate(*cls);
+        (void)hasErrors;
+    });
+
+    measure(ctx, results, "ClassTable(Class)", size, size, [&] {
+        ClassTable table(*cls);
+        volatile size_t rows = table.rowsCount();
+        (void)rows;
+    });
+
+    const ClassTable table(*cls);
+    measure(ctx, results, "validation::validate(ClassTable)", size, size, [&] {
+        volatile bool hasErrors = !!validation::validate(table);
+        (void)hasErrors;
+    });
+
+    // district: one class of given size and several small ones
+    std::vector<std::unique_ptr<Class>> district;
+    std::vector<const Class*> classes{cls.get()};
+    size_t students = size;
+    for (size_t i = 0; i < 15; ++i) {
+        district.push_back(syntheticClass(25, ctx.subjects, size + i));
+        classes.push_back(district.back().get());
+        students += 25;
+    }
+    for (size_t workers : {size_t(1), ctx.workers}) {
+        const std::string name = "validation::validate(classes, workers="
+            + (workers ? std::to_string(workers) : std::string("auto")) + ")";
+        measure(ctx, results, name, size, students, [&] {
+            volatile size_t invalid = validation::validate(classes, workers).size();
+            (void)invalid;
+        });
+    }
+
+    // validation as you type: one grade edit followed by errors update
+    validation::Validator validator(*cls);
+    const auto subjectIds = cls->subjectsPlan()->subjectIds();
+    const size_t EDITS = 1000;
+    size_t edit = 0;
+    measure(ctx, results, "Validator::onGradeChanged", size, EDITS, [&] {
+        for (size_t i = 0; i < EDITS; ++i, ++edit) {
+            const Class::Index at = edit % size;
+            const ID& subjectId = subjectIds[edit % subjectIds.size()];
+            auto& g = cls->student(at).grades();
+            const grades::Value v = g.value(subjectId) == grades::Value("5") ? "4" : "5";
+            g.setValue(subjectId, v);
+            validator.onGradeChanged(at, subjectId);
+        }
+        volatile bool hasErrors = validator.hasErrors();
+        (void)hasErrors;
+    });
+}
+
+} // namespace bench
+} // namespace attestate
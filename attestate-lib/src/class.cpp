@@ -1,7 +1,9 @@
 #include <attestate/class.h>
 
 #include "helpers.h"
-#include "unique_vector.h"
+#include "unique_tree.h"
+#include "snapshot_io.h"
+#include "pool.h"
 
 #include <attestate/exception.h>
 
@@ -20,7 +22,27 @@ struct Data {
     ID subjectsPlanId;
 };
 
-typedef std::unique_ptr<Data> DataPtr;
+// original and current data are shared until first change after save
+typedef std::shared_ptr<Data> DataPtr;
+
+void writeData(SnapshotWriter& out, const Data& data)
+{
+    out.stream() << data.classId;
+    out.write(data.graduationYear);
+    out.write(data.issueDate);
+    out.write(data.subjectsPlanId);
+}
+
+DataPtr readData(SnapshotReader& in)
+{
+    auto data = std::make_shared<Data>(Data{"", boost::none, boost::none, ID::emptyID()});
+    in.stream() >> data->classId;
+    data->graduationYear = in.readOptional<Year>();
+    data->issueDate = in.readOptional<QDate>();
+    data->subjectsPlanId = in.readID();
+    in.check();
+    return data;
+}
 
 struct IsModified {
     explicit IsModified(bool v)
@@ -49,6 +71,7 @@ struct IsModified {
 
 struct StudentKey {
     explicit StudentKey(const Class::StudentPtr& s) : id_(s->id()) {}
+    explicit StudentKey(const ID& id) : id_(id) {}
 
     const ID& operator () () const { return id_; }
 
@@ -64,16 +87,14 @@ std::ostream& operator << (std::ostream& os, const StudentKey& k)
     return os;
 }
 
-typedef UniqueVector<Class::StudentPtr, StudentKey> StudentsVector;
+typedef UniqueTree<Class::StudentPtr, StudentKey> StudentsVector;
 
 struct StudentsDiff {
     StudentsDiff() {}
 
     explicit StudentsDiff(const StudentsVector& students)
     {
-        for (size_t i = 0; i < students.size(); ++i) {
-            original.insert(students.at(i)->id());
-        }
+        students.forEach([this] (const Class::StudentPtr& s) { original.insert(s->id()); });
     }
 
     void processAdded(const ID& id)
@@ -94,11 +115,46 @@ struct StudentsDiff {
 
     bool empty() const { return added.empty() && deleted.empty(); }
 
+    // current students become original, by changes only
+    void save()
+    {
+        original.insert(added.begin(), added.end());
+        for (const auto& id : deleted) {
+            original.erase(id);
+        }
+        added.clear();
+        deleted.clear();
+    }
+
     IDSet original;
     IDSet added;
     IDSet deleted;
 };
 
+// Layout to move grades to on plan change: plan layout is shared as is
+// if it has slots of all graded and modified subjects, otherwise grades
+// get own open copy of it, so plan layout keeps only plan subjects.
+SubjectsLayoutPtr layoutFor(const SubjectsLayoutPtr& planLayout, const SubjectsGrades& studentGrades)
+{
+    bool fits = true;
+    const auto& codes = studentGrades.codes();
+    for (SubjectsLayout::Slot slot = 0; slot < codes.size() && fits; ++slot) {
+        fits = codes[slot] == grades::NO_CODE ||
+            planLayout->find(studentGrades.layout()->subjectId(slot));
+    }
+    for (const auto& c : studentGrades.changes()) {
+        fits = fits && planLayout->find(c.first);
+    }
+    if (fits) {
+        return planLayout;
+    }
+    auto layout = std::make_shared<SubjectsLayout>();
+    for (SubjectsLayout::Slot slot = 0; slot < planLayout->size(); ++slot) {
+        layout->slot(planLayout->subjectId(slot));
+    }
+    return layout;
+}
+
 } // namespace
 
 // impl
@@ -122,8 +178,9 @@ public:
             StudentPtrVector studentsV,
             const SubjectsPlanPtr& subjectsPlan)
         : id(id)
-        , data(new Data{classId, graduationYear, issueDate, ID::emptyID()})
-        , originalData(new Data(*data))
+        , data(std::make_shared<Data>(Data{classId, graduationYear, issueDate,
+            subjectsPlan ? subjectsPlan->id() : ID::emptyID()}))
+        , originalData(data)
         , subjectsPlan(subjectsPlan)
         , isDeleted(false)
         , isModified_(false)
@@ -132,11 +189,10 @@ public:
             ATT_ASSERT(sp);
             ATT_REQUIRE(sp->state() == State::Existing, "Student " << sp->id() << " state is not allowed");
         }
-        students = StudentsVector(std::move(studentsV));
-        if (subjectsPlan) {
-            data->subjectsPlanId = subjectsPlan->id();
-            originalData->subjectsPlanId = subjectsPlan->id();
+        for (const auto& sp : studentsV) {
+            bindGrades(*sp);
         }
+        students = StudentsVector(std::move(studentsV));
         studentsDiff = StudentsDiff(students);
     }
 
@@ -158,6 +214,15 @@ public:
         return *this;
     }
 
+    // data to change, copied if shared with original
+    Data& mutableData()
+    {
+        if (data == originalData) {
+            data = std::make_shared<Data>(*originalData);
+        }
+        return *data;
+    }
+
     void calcModifiedClassId()
     {
         isModified_.classId = !originalData ||
@@ -187,12 +252,11 @@ public:
         if (!studentsDiff.empty()) {
             return true;
         }
-        for (size_t i = 0; i < students.size(); ++i) {
-            if (students.at(i)->state() != State::Existing) {
-                return true;
-            }
-        }
-        return false;
+        bool isModified = false;
+        students.forEach([&isModified] (const Class::StudentPtr& s) {
+            isModified = isModified || s->state() != State::Existing;
+        });
+        return isModified;
     }
 
     // own data
@@ -206,7 +270,25 @@ public:
 
     void resetModified() { isModified_.reset(false); }
 
-    void resetStudentsDiff() { studentsDiff = StudentsDiff(students); }
+    void calcModified()
+    {
+        calcModifiedClassId();
+        calcModifiedGraduationYear();
+        calcModifiedIssueDate();
+        calcModifiedSubjectsPlan();
+    }
+
+    void resetStudentsDiff() { studentsDiff.save(); }
+
+    // grades of added students move to plan layout, including grades
+    // bound to layout of other plan; grades of subjects absent from plan
+    // keep own layout
+    void bindGrades(Student& s) const
+    {
+        if (subjectsPlan && s.grades().layout() != subjectsPlan->layout()) {
+            s.grades().setLayout(layoutFor(subjectsPlan->layout(), s.grades()));
+        }
+    }
 
     ID id;
     DataPtr data;
@@ -288,7 +370,7 @@ void Class::setClassId(const ClassId& id)
     if (id == impl_->data->classId) {
         return;
     }
-    impl_->data->classId = id;
+    impl_->mutableData().classId = id;
     impl_->calcModifiedClassId();
 }
 
@@ -306,7 +388,7 @@ void Class::setGraduationYear(const OptionalYear& year)
     if (year == impl_->data->graduationYear) {
         return;
     }
-    impl_->data->graduationYear = year;
+    impl_->mutableData().graduationYear = year;
     impl_->calcModifiedGraduationYear();
 }
 
@@ -324,7 +406,7 @@ void Class::setIssueDate(const OptionalDate& issueDate)
     if (issueDate == impl_->data->issueDate) {
         return;
     }
-    impl_->data->issueDate = issueDate;
+    impl_->mutableData().issueDate = issueDate;
     impl_->calcModifiedIssueDate();
 }
 
@@ -353,20 +435,14 @@ Student& Class::student(Index at)
 Class::ConstStudentWeakPtrList Class::studentsList() const
 {
     ConstStudentWeakPtrList result;
-    size_t size = impl_->students.size();
-    for (size_t i = 0; i < size; ++i) {
-        result.push_back(impl_->students.at(i).get());
-    }
+    impl_->students.forEach([&result] (const StudentPtr& s) { result.push_back(s.get()); });
     return result;
 }
 
 Class::StudentWeakPtrList Class::studentsList()
 {
     StudentWeakPtrList result;
-    size_t size = impl_->students.size();
-    for (size_t i = 0; i < size; ++i) {
-        result.push_back(impl_->students.at(i).get());
-    }
+    impl_->students.forEach([&result] (const StudentPtr& s) { result.push_back(s.get()); });
     return result;
 }
 
@@ -375,6 +451,7 @@ void Class::insert(StudentPtr student, Index at)
     ATT_ASSERT(student);
     const ID id = student->id();
     ATT_REQUIRE(student->state() != State::Deleted, "Student " << id << " is deleted");
+    impl_->bindGrades(*student);
     impl_->students.insert(std::move(student), at);
     impl_->studentsDiff.processAdded(id);
 }
@@ -388,6 +465,9 @@ void Class::insert(std::map<Index, StudentPtr> students)
         ATT_REQUIRE(p.second->state() != State::Deleted, "Student " << id << " is deleted");
         ids.insert(id);
     }
+    for (const auto& p : students) {
+        impl_->bindGrades(*p.second);
+    }
     impl_->students.insert(std::move(students));
     for (const auto& id : ids) {
         impl_->studentsDiff.processAdded(id);
@@ -399,6 +479,7 @@ void Class::append(StudentPtr student)
     ATT_ASSERT(student);
     const ID id = student->id();
     ATT_REQUIRE(student->state() != State::Deleted, "Student " << id << " is deleted");
+    impl_->bindGrades(*student);
     impl_->students.append(std::move(student));
     impl_->studentsDiff.processAdded(id);
 }
@@ -429,6 +510,10 @@ bool Class::areStudentsModified() const
     return impl_->areStudentsModified();
 }
 
+const IDSet& Class::addedStudents() const { return impl_->studentsDiff.added; }
+
+const IDSet& Class::erasedStudents() const { return impl_->studentsDiff.deleted; }
+
 // subjects plan
 
 const SubjectsPlanPtr& Class::subjectsPlan() const
@@ -441,8 +526,23 @@ void Class::setSubjectsPlan(const SubjectsPlanPtr& subjectsPlan)
     if (byPointerCmp(subjectsPlan, impl_->subjectsPlan)) {
         return;
     }
+    // grades of students move to layout of new plan keeping all values,
+    // without plan they become standalone
+    if (subjectsPlan) {
+        const SubjectsLayoutPtr& planLayout = subjectsPlan->layout();
+        impl_->students.forEach([&planLayout] (const StudentPtr& s) {
+            if (s->grades().layout() != planLayout) {
+                s->grades().setLayout(layoutFor(planLayout, s->grades()));
+            }
+        });
+    } else {
+        const SubjectsLayoutPtr layout = std::make_shared<SubjectsLayout>();
+        impl_->students.forEach([&layout] (const StudentPtr& s) {
+            s->grades().setLayout(layout);
+        });
+    }
     impl_->subjectsPlan = subjectsPlan;
-    impl_->data->subjectsPlanId = subjectsPlan
+    impl_->mutableData().subjectsPlanId = subjectsPlan
         ? subjectsPlan->id()
         : ID::emptyID();
     impl_->calcModifiedSubjectsPlan();
@@ -458,16 +558,90 @@ bool Class::isSubjectsPlanModified() const
 void Class::save()
 {
     ATT_REQUIRE(!impl_->isDeleted, "Cannot save deleted class, id " << impl_->id);
-    impl_->originalData.reset(new Data(*impl_->data));
+    impl_->originalData = impl_->data;
 
-    const size_t size = impl_->students.size();
-    for (size_t i = 0; i < size; ++i) {
-        auto& s = student(i);
-        s.save();
-    }
+    impl_->students.forEach([] (const StudentPtr& s) { s->save(); });
     impl_->resetStudentsDiff();
     impl_->resetModified();
 }
 
+void Class::write(SnapshotWriter& out) const
+{
+    QDataStream& s = out.stream();
+    out.write(impl_->id);
+    s << impl_->isDeleted;
+    writeData(out, *impl_->data);
+    s << bool(impl_->originalData);
+    if (impl_->originalData) {
+        writeData(out, *impl_->originalData);
+    }
+
+    out.writeRef(impl_->subjectsPlan, [&out] (const SubjectsPlan& p) { p.write(out); });
+
+    s << quint32(impl_->students.size());
+    impl_->students.forEach([&out] (const StudentPtr& st) { st->write(out); });
+
+    // erased students are kept by id only
+    s << quint32(impl_->studentsDiff.original.size());
+    for (const auto& id : impl_->studentsDiff.original) {
+        out.write(id);
+    }
+}
+
+Class Class::read(SnapshotReader& in)
+{
+    QDataStream& s = in.stream();
+    Class res(in.readID());
+    Impl& impl = *res.impl_;
+    bool hasOriginal = false;
+    s >> impl.isDeleted;
+    impl.data = readData(in);
+    s >> hasOriginal;
+    in.check();
+    if (hasOriginal) {
+        impl.originalData = readData(in);
+    }
+
+    impl.subjectsPlan = in.readRef<SubjectsPlan>([&in] {
+        return std::make_shared<SubjectsPlan>(SubjectsPlan::read(in));
+    });
+    ATT_REQUIRE(
+        (impl.subjectsPlan ? impl.subjectsPlan->id() : ID::emptyID()) == impl.data->subjectsPlanId,
+        "Subjects plan id mismatch in snapshot of class " << impl.id);
+
+    quint32 size = 0;
+    s >> size;
+    in.check();
+    pool::ScopedPool studentsPool; // students of class share memory
+    StudentPtrVector students;
+    students.reserve(size);
+    for (quint32 i = 0; i < size; ++i) {
+        students.emplace_back(new Student(Student::read(in)));
+    }
+    impl.students = StudentsVector(std::move(students));
+
+    StudentsDiff diff;
+    s >> size;
+    for (quint32 i = 0; i < size; ++i) {
+        diff.original.insert(in.readID());
+    }
+    in.check();
+    impl.students.forEach([&diff] (const StudentPtr& st) { diff.processAdded(st->id()); });
+    for (const auto& id : diff.original) {
+        if (!impl.students.contains(StudentKey(id))) {
+            diff.processDeleted(id);
+        }
+    }
+    impl.studentsDiff = std::move(diff);
+
+    if (hasOriginal) {
+        impl.calcModified();
+        if (!impl.isModified()()) {
+            impl.originalData = impl.data;
+        }
+    }
+    return res;
+}
+
 } // namespace attestate
 
@@ -0,0 +1,112 @@
+#include <attestate/class_table.h>
+
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+#include <attestate/exception.h>
+
+namespace attestate {
+
+ClassTable::ClassTable(const Class& c)
+    : id_(c.id())
+    , classId_(c.classId())
+    , graduationYear_(c.graduationYear())
+    , issueDate_(c.issueDate())
+{
+    const size_t count = c.studentsCount();
+    studentIds_.reserve(count);
+    studentIndexes_.reserve(count);
+    familyNames_.reserve(count);
+    names_.reserve(count);
+    parentalNames_.reserve(count);
+    birthDates_.reserve(count);
+    graduationYears_.reserve(count);
+    attestateIds_.reserve(count);
+    issueDates_.reserve(count);
+
+    if (c.subjectsPlan()) {
+        subjectIds_ = c.subjectsPlan()->subjectIds();
+    }
+    gradeCodes_.resize(subjectIds_.size());
+    for (auto& column : gradeCodes_) {
+        column.reserve(count);
+    }
+
+    // students of a class usually share grades layout,
+    // plan positions are resolved to slots once per layout
+    const SubjectsLayout* layout = nullptr;
+    size_t layoutSize = 0;
+    std::vector<SubjectsLayout::OptionalSlot> slots(subjectIds_.size());
+
+    for (Class::Index i = 0; i < count; ++i) {
+        const Student& s = c.student(i);
+        if (s.state() == State::Deleted) {
+            continue;
+        }
+        studentIds_.push_back(s.id());
+        studentIndexes_.push_back(i);
+        familyNames_.push_back(s.familyName());
+        names_.push_back(s.name());
+        parentalNames_.push_back(s.parentalName());
+        birthDates_.push_back(s.birthDate());
+        graduationYears_.push_back(s.graduationYear());
+        attestateIds_.push_back(s.attestateId());
+        issueDates_.push_back(s.issueDate());
+
+        const SubjectsGrades& g = s.grades();
+        if (g.layout().get() != layout || g.layout()->size() != layoutSize) {
+            layout = g.layout().get();
+            layoutSize = layout->size();
+            for (size_t j = 0; j < subjectIds_.size(); ++j) {
+                slots[j] = layout->find(subjectIds_[j]);
+            }
+        }
+        const auto& codes = g.codes();
+        for (size_t j = 0; j < subjectIds_.size(); ++j) {
+            const auto& slot = slots[j];
+            gradeCodes_[j].push_back(
+                slot && *slot < codes.size() ? codes[*slot] : grades::NO_CODE);
+        }
+    }
+}
+
+size_t ClassTable::rowsCount() const { return studentIds_.size(); }
+
+size_t ClassTable::subjectsCount() const { return subjectIds_.size(); }
+
+const ID& ClassTable::id() const { return id_; }
+
+const ClassId& ClassTable::classId() const { return classId_; }
+
+const OptionalYear& ClassTable::graduationYear() const { return graduationYear_; }
+
+const OptionalDate& ClassTable::issueDate() const { return issueDate_; }
+
+const std::vector<ID>& ClassTable::studentIds() const { return studentIds_; }
+
+const std::vector<Class::Index>& ClassTable::studentIndexes() const { return studentIndexes_; }
+
+const std::vector<DataString>& ClassTable::familyNames() const { return familyNames_; }
+
+const std::vector<DataString>& ClassTable::names() const { return names_; }
+
+const std::vector<DataString>& ClassTable::parentalNames() const { return parentalNames_; }
+
+const std::vector<QDate>& ClassTable::birthDates() const { return birthDates_; }
+
+const std::vector<OptionalYear>& ClassTable::graduationYears() const { return graduationYears_; }
+
+const std::vector<AttestateId>& ClassTable::attestateIds() const { return attestateIds_; }
+
+const std::vector<OptionalDate>& ClassTable::issueDates() const { return issueDates_; }
+
+const std::vector<ID>& ClassTable::subjectIds() const { return subjectIds_; }
+
+const std::vector<grades::Code>& ClassTable::gradeCodes(size_t subject) const
+{
+    ATT_REQUIRE(
+        subject < gradeCodes_.size(),
+        "Subject position " << subject << " is out of range");
+    return gradeCodes_[subject];
+}
+
+} // namespace attestate
@@ -1,4 +1,8 @@
 #include <attestate/common.h>
+#include <attestate/exception.h>
+
+#include <atomic>
+#include <limits>
 
 namespace attestate {
 
@@ -7,6 +11,14 @@ namespace {
 const OID EMPTY_OID = 0;
 const DBID EMPTY_DBID = 0;
 
+// oids reserved by each thread at once, keeps threads off the shared counter
+const size_t THREAD_BLOCK_SIZE = 1024;
+
+std::atomic<OID> s_next(EMPTY_OID + 1);
+
+thread_local IDBlock s_threadBlock;
+thread_local IDBlock* s_scopedBlock = nullptr;
+
 } // namespace
 
 ID::ID() : id_(EMPTY_OID), dbid_(EMPTY_DBID) {}
@@ -32,9 +44,53 @@ const ID& ID::emptyID()
 
 ID ID::gen()
 {
-    static OID s_gen = 0;
+    if (s_scopedBlock) {
+        return s_scopedBlock->gen();
+    }
+    if (s_threadBlock.empty()) {
+        s_threadBlock = reserve(THREAD_BLOCK_SIZE);
+    }
+    return s_threadBlock.gen();
+}
+
+IDBlock ID::reserve(size_t count)
+{
+    ATT_REQUIRE(
+        count <= std::numeric_limits<OID>::max(),
+        "Too many ids requested: " << count);
+    // counter never moves past the last oid, so it does not wrap to EMPTY_OID
+    OID first = s_next.load(std::memory_order_relaxed);
+    do {
+        ATT_REQUIRE(
+            first <= std::numeric_limits<OID>::max() - count,
+            "Object ids are exhausted");
+    } while (!s_next.compare_exchange_weak(
+        first, first + static_cast<OID>(count), std::memory_order_relaxed));
+    return IDBlock(first, first + static_cast<OID>(count));
+}
+
+IDBlock::IDBlock() : next_(EMPTY_OID), end_(EMPTY_OID) {}
+
+IDBlock::IDBlock(OID first, OID end) : next_(first), end_(end) {}
+
+size_t IDBlock::size() const { return end_ - next_; }
+bool IDBlock::empty() const { return next_ == end_; }
+
+ID IDBlock::gen()
+{
+    ATT_REQUIRE(!empty(), "ID block is exhausted");
+    return ID(next_++, EMPTY_DBID);
+}
 
-    return ID(++s_gen, EMPTY_DBID);
+ScopedIDBlock::ScopedIDBlock(IDBlock& block)
+    : prev_(s_scopedBlock)
+{
+    s_scopedBlock = &block;
+}
+
+ScopedIDBlock::~ScopedIDBlock()
+{
+    s_scopedBlock = prev_;
 }
 
 std::ostream& operator << (std::ostream& os, const ID& id)
@@ -0,0 +1,534 @@
+#include <attestate/db.h>
+
+#include "pool.h"
+
+#include <attestate/grades.h>
+#include <attestate/exception.h>
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+
+#include <atomic>
+#include <initializer_list>
+#include <map>
+#include <unordered_map>
+
+namespace attestate {
+namespace db {
+
+namespace {
+
+const char* const SCHEMA[] = {
+    "CREATE TABLE IF NOT EXISTS subjects ("
+        "id INTEGER PRIMARY KEY, name TEXT NOT NULL, shortened_name TEXT NOT NULL)",
+    "CREATE TABLE IF NOT EXISTS subjects_plans ("
+        "id INTEGER PRIMARY KEY, name TEXT NOT NULL)",
+    "CREATE TABLE IF NOT EXISTS subjects_plan_subjects ("
+        "plan_id INTEGER NOT NULL, subject_id INTEGER NOT NULL, position INTEGER NOT NULL, "
+        "PRIMARY KEY (plan_id, subject_id))",
+    "CREATE TABLE IF NOT EXISTS classes ("
+        "id INTEGER PRIMARY KEY, title TEXT NOT NULL, graduation_year INTEGER, issue_date TEXT, "
+        "subjects_plan_id INTEGER)",
+    // position is index of student in class
+    "CREATE TABLE IF NOT EXISTS students ("
+        "id INTEGER PRIMARY KEY, class_id INTEGER NOT NULL, position INTEGER NOT NULL, "
+        "family_name TEXT NOT NULL, name TEXT NOT NULL, parental_name TEXT NOT NULL, "
+        "birth_date TEXT, graduation_year INTEGER, attestate_id TEXT NOT NULL, issue_date TEXT)",
+    "CREATE INDEX IF NOT EXISTS students_class_position ON students (class_id, position)",
+    "CREATE TABLE IF NOT EXISTS grades ("
+        "student_id INTEGER NOT NULL, subject_id INTEGER NOT NULL, value TEXT NOT NULL, "
+        "PRIMARY KEY (student_id, subject_id))"
+};
+
+const QString DATE_FORMAT = "yyyy-MM-dd";
+
+QVariant toVariant(const QDate& date)
+{
+    return date.isValid() ? QVariant(date.toString(DATE_FORMAT)) : QVariant();
+}
+
+QVariant toVariant(const OptionalDate& date)
+{
+    return date ? toVariant(*date) : QVariant();
+}
+
+QVariant toVariant(const OptionalYear& year)
+{
+    return year ? QVariant(uint(*year)) : QVariant();
+}
+
+QDate toDate(const QVariant& value)
+{
+    return value.isNull() ? QDate() : QDate::fromString(value.toString(), DATE_FORMAT);
+}
+
+OptionalDate toOptionalDate(const QVariant& value)
+{
+    return value.isNull() ? OptionalDate() : OptionalDate(toDate(value));
+}
+
+OptionalYear toOptionalYear(const QVariant& value)
+{
+    return value.isNull() ? OptionalYear() : OptionalYear(Year(value.toUInt()));
+}
+
+QString connectionName()
+{
+    static std::atomic<unsigned> s_counter(0);
+    return "attestate-db-" + QString::number(++s_counter);
+}
+
+// Statements are prepared on first use and reused for all rows of one save.
+class Writer {
+public:
+    explicit Writer(const QSqlDatabase& db) : db_(db), rows_(0) {}
+
+    void exec(const char* sql, std::initializer_list<QVariant> values)
+    {
+        auto& query = prepared(sql);
+        for (const auto& v : values) {
+            query.addBindValue(v);
+        }
+        ATT_REQUIRE(query.exec(),
+            "Query failed: " << sql << ": " << query.lastError().text().toStdString());
+        ++rows_;
+    }
+
+    DBID insert(const char* sql, std::initializer_list<QVariant> values)
+    {
+        exec(sql, values);
+        return DBID(prepared(sql).lastInsertId().toUInt());
+    }
+
+    size_t rows() const { return rows_; }
+
+private:
+    QSqlQuery& prepared(const char* sql)
+    {
+        auto it = queries_.find(sql);
+        if (it == queries_.end()) {
+            std::unique_ptr<QSqlQuery> query(new QSqlQuery(db_));
+            ATT_REQUIRE(query->prepare(sql),
+                "Could not prepare " << sql << ": " << query->lastError().text().toStdString());
+            it = queries_.emplace(sql, std::move(query)).first;
+        }
+        return *it->second;
+    }
+
+    QSqlDatabase db_;
+    std::map<const char*, std::unique_ptr<QSqlQuery>> queries_;
+    size_t rows_;
+};
+
+QSqlQuery select(const QSqlDatabase& db, const QString& sql, std::initializer_list<QVariant> values)
+{
+    QSqlQuery query(db);
+    ATT_REQUIRE(query.prepare(sql),
+        "Could not prepare " << sql.toStdString() << ": " << query.lastError().text().toStdString());
+    for (const auto& v : values) {
+        query.addBindValue(v);
+    }
+    ATT_REQUIRE(query.exec(),
+        "Query failed: " << sql.toStdString() << ": " << query.lastError().text().toStdString());
+    return query;
+}
+
+const char* const INSERT_SUBJECT =
+    "INSERT INTO subjects (name, shortened_name) VALUES (?, ?)";
+const char* const UPDATE_SUBJECT =
+    "UPDATE subjects SET name = ?, shortened_name = ? WHERE id = ?";
+
+const char* const INSERT_PLAN = "INSERT INTO subjects_plans (name) VALUES (?)";
+const char* const UPDATE_PLAN = "UPDATE subjects_plans SET name = ? WHERE id = ?";
+const char* const SET_PLAN_SUBJECT =
+    "INSERT OR REPLACE INTO subjects_plan_subjects (plan_id, subject_id, position) VALUES (?, ?, ?)";
+const char* const DELETE_PLAN_SUBJECT =
+    "DELETE FROM subjects_plan_subjects WHERE plan_id = ? AND subject_id = ?";
+
+const char* const INSERT_CLASS = "INSERT INTO classes (title) VALUES (?)";
+const char* const UPDATE_CLASS =
+    "UPDATE classes SET title = ?, graduation_year = ?, issue_date = ?, "
+    "subjects_plan_id = ? WHERE id = ?";
+const char* const DELETE_CLASS = "DELETE FROM classes WHERE id = ?";
+const char* const DELETE_CLASS_GRADES =
+    "DELETE FROM grades WHERE student_id IN (SELECT id FROM students WHERE class_id = ?)";
+const char* const DELETE_CLASS_STUDENTS = "DELETE FROM students WHERE class_id = ?";
+
+const char* const INSERT_STUDENT =
+    "INSERT INTO students (class_id, position, family_name, name, parental_name, birth_date, "
+    "graduation_year, attestate_id, issue_date) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+const char* const UPDATE_STUDENT =
+    "UPDATE students SET family_name = ?, name = ?, parental_name = ?, "
+    "birth_date = ?, graduation_year = ?, attestate_id = ?, issue_date = ? WHERE id = ?";
+const char* const SET_STUDENT_POSITION = "UPDATE students SET position = ? WHERE id = ?";
+const char* const DELETE_STUDENT = "DELETE FROM students WHERE id = ?";
+const char* const DELETE_STUDENT_GRADES = "DELETE FROM grades WHERE student_id = ?";
+// student moved to other class is rewritten there, its rows are kept if that class is saved first
+const char* const REPLACE_STUDENT =
+    "INSERT OR REPLACE INTO students (id, class_id, position, family_name, name, parental_name, "
+    "birth_date, graduation_year, attestate_id, issue_date) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+const char* const DELETE_ERASED_STUDENT_GRADES =
+    "DELETE FROM grades WHERE student_id IN (SELECT id FROM students WHERE id = ? AND class_id = ?)";
+const char* const DELETE_ERASED_STUDENT = "DELETE FROM students WHERE id = ? AND class_id = ?";
+
+const char* const SET_GRADE =
+    "INSERT OR REPLACE INTO grades (student_id, subject_id, value) VALUES (?, ?, ?)";
+const char* const DELETE_GRADE = "DELETE FROM grades WHERE student_id = ? AND subject_id = ?";
+
+bool isStudentDataModified(const Student& s)
+{
+    return s.isPersonalInfoModified() || s.isGraduationYearModified()
+        || s.isAttestateIdModified() || s.isIssueDateModified();
+}
+
+} // namespace
+
+class Database::Impl {
+public:
+    explicit Impl(const QString& filename)
+        : connection(connectionName())
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection);
+        db.setDatabaseName(filename);
+        ATT_REQUIRE(db.open(),
+            "Could not open " << filename.toStdString() << ": " << db.lastError().text().toStdString());
+        for (const char* sql : SCHEMA) {
+            QSqlQuery query(db);
+            ATT_REQUIRE(query.exec(sql),
+                "Could not create schema: " << query.lastError().text().toStdString());
+        }
+    }
+
+    ~Impl()
+    {
+        {
+            QSqlDatabase db = QSqlDatabase::database(connection, false);
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(connection);
+    }
+
+    QSqlDatabase database() const { return QSqlDatabase::database(connection, false); }
+
+    size_t save(Class& c);
+    std::unique_ptr<Class> load(DBID classId);
+
+    SubjectsPlanPtr loadPlan(DBID planId);
+
+    QString connection;
+
+    // loaded objects are shared while alive
+    std::unordered_map<DBID, std::weak_ptr<SubjectsPlan>> plans;
+    std::unordered_map<DBID, std::weak_ptr<Subject>> subjects;
+};
+
+size_t Database::Impl::save(Class& c)
+{
+    QSqlDatabase db = database();
+    ATT_REQUIRE(db.transaction(), "Could not start transaction: " << db.lastError().text().toStdString());
+
+    Writer w(db);
+
+    // db ids are assigned to objects after commit only
+    std::map<Subject*, DBID> newSubjects;
+    DBID newPlanId = 0;
+    DBID classDbid = c.id().dbid();
+    std::map<Student*, DBID> newStudents;
+    std::set<Class::Index> deletedStudents;
+
+    const SubjectsPlanPtr& plan = c.subjectsPlan();
+    const bool savePlan = plan && plan->state() != State::Deleted;
+
+    try {
+        if (c.state() == State::Deleted) {
+            if (classDbid) {
+                w.exec(DELETE_CLASS_GRADES, {classDbid});
+                w.exec(DELETE_CLASS_STUDENTS, {classDbid});
+                w.exec(DELETE_CLASS, {classDbid});
+            }
+            ATT_REQUIRE(db.commit(), "Could not commit: " << db.lastError().text().toStdString());
+            return w.rows();
+        }
+
+        // subject oid -> db id, grades of other subjects are not stored
+        std::map<ID, DBID> subjectDbids;
+        DBID planDbid = 0;
+
+        if (savePlan) {
+            for (size_t i = 0; i < plan->subjectsCount(); ++i) {
+                Subject& s = *plan->subject(i);
+                DBID dbid = s.id().dbid();
+                if (!dbid) {
+                    dbid = w.insert(INSERT_SUBJECT, {s.name(), s.shortenedName()});
+                    newSubjects[&s] = dbid;
+                } else if (s.state() == State::Modified) {
+                    w.exec(UPDATE_SUBJECT, {s.name(), s.shortenedName(), dbid});
+                }
+                subjectDbids[s.id()] = dbid;
+            }
+
+            planDbid = plan->id().dbid();
+            if (!planDbid) {
+                planDbid = newPlanId = w.insert(INSERT_PLAN, {plan->name()});
+                for (size_t i = 0; i < plan->subjectsCount(); ++i) {
+                    w.exec(SET_PLAN_SUBJECT, {planDbid, subjectDbids[plan->at(i).id()], uint(i)});
+                }
+            } else {
+                if (plan->isNameModified()) {
+                    w.exec(UPDATE_PLAN, {plan->name(), planDbid});
+                }
+                for (const auto& change : plan->changes()) {
+                    const auto& to = change.second.second;
+                    if (to) {
+                        w.exec(SET_PLAN_SUBJECT,
+                            {planDbid, subjectDbids[change.first->id()], uint(*to)});
+                    } else if (change.first->id().dbid()) {
+                        w.exec(DELETE_PLAN_SUBJECT, {planDbid, change.first->id().dbid()});
+                    }
+                }
+            }
+        }
+
+        bool writeClass = c.isClassIdModified() || c.isGraduationYearModified()
+            || c.isIssueDateModified() || c.isSubjectsPlanModified() || newPlanId;
+        // stored positions of class students, students moved in class
+        // keep their state, so order is compared with them on every save
+        std::map<DBID, uint> positions;
+        if (!classDbid) {
+            classDbid = w.insert(INSERT_CLASS, {c.classId()});
+            writeClass = true;
+        } else {
+            auto query = select(db, "SELECT id, position FROM students WHERE class_id = ?", {classDbid});
+            while (query.next()) {
+                positions[query.value(0).toUInt()] = query.value(1).toUInt();
+            }
+        }
+
+        uint position = 0;
+        for (size_t i = 0; i < c.studentsCount(); ++i) {
+            Student& s = c.student(i);
+            DBID dbid = s.id().dbid();
+
+            if (s.state() == State::Deleted) {
+                if (dbid) {
+                    w.exec(DELETE_STUDENT_GRADES, {dbid});
+                    w.exec(DELETE_STUDENT, {dbid});
+                }
+                deletedStudents.insert(i);
+                continue;
+            }
+
+            const SubjectsGrades& grades = s.grades();
+            const bool isAdded = dbid && c.addedStudents().count(s.id());
+            if (!dbid || isAdded) {
+                if (!dbid) {
+                    dbid = w.insert(INSERT_STUDENT, {classDbid, position,
+                        s.familyName(), s.name(), s.parentalName(), toVariant(s.birthDate()),
+                        toVariant(s.graduationYear()), s.attestateId(), toVariant(s.issueDate())});
+                    newStudents[&s] = dbid;
+                } else {
+                    w.exec(REPLACE_STUDENT, {dbid, classDbid, position,
+                        s.familyName(), s.name(), s.parentalName(), toVariant(s.birthDate()),
+                        toVariant(s.graduationYear()), s.attestateId(), toVariant(s.issueDate())});
+                    w.exec(DELETE_STUDENT_GRADES, {dbid});
+                }
+                for (const auto& subject : subjectDbids) {
+                    auto value = grades.value(subject.first);
+                    if (value) {
+                        w.exec(SET_GRADE, {dbid, subject.second, *value});
+                    }
+                }
+            } else {
+                if (isStudentDataModified(s)) {
+                    w.exec(UPDATE_STUDENT, {
+                        s.familyName(), s.name(), s.parentalName(), toVariant(s.birthDate()),
+                        toVariant(s.graduationYear()), s.attestateId(), toVariant(s.issueDate()),
+                        dbid});
+                }
+                auto stored = positions.find(dbid);
+                if (stored == positions.end() || stored->second != position) {
+                    w.exec(SET_STUDENT_POSITION, {position, dbid});
+                }
+                for (const auto& change : grades.changes()) {
+                    auto subject = subjectDbids.find(change.first);
+                    if (subject == subjectDbids.end()) {
+                        continue;
+                    }
+                    const auto& value = change.second.second;
+                    if (value) {
+                        w.exec(SET_GRADE, {dbid, subject->second, *value});
+                    } else {
+                        w.exec(DELETE_GRADE, {dbid, subject->second});
+                    }
+                }
+            }
+            ++position;
+        }
+
+        for (const auto& id : c.erasedStudents()) {
+            if (id.dbid()) {
+                w.exec(DELETE_ERASED_STUDENT_GRADES, {id.dbid(), classDbid});
+                w.exec(DELETE_ERASED_STUDENT, {id.dbid(), classDbid});
+            }
+        }
+
+        if (writeClass) {
+            w.exec(UPDATE_CLASS, {c.classId(), toVariant(c.graduationYear()), toVariant(c.issueDate()),
+                planDbid ? QVariant(planDbid) : QVariant(), classDbid});
+        }
+
+        ATT_REQUIRE(db.commit(), "Could not commit: " << db.lastError().text().toStdString());
+    } catch (...) {
+        db.rollback();
+        throw;
+    }
+
+    for (const auto& s : newSubjects) {
+        s.first->setDBID(s.second);
+    }
+    for (const auto& s : newStudents) {
+        s.first->setDBID(s.second);
+    }
+    if (!c.id().dbid()) {
+        c.setDBID(classDbid);
+    }
+    if (savePlan) {
+        if (newPlanId) {
+            plan->setDBID(newPlanId);
+            plans[newPlanId] = plan;
+        }
+        for (size_t i = 0; i < plan->subjectsCount(); ++i) {
+            const SubjectPtr& s = plan->subject(i);
+            subjects[s->id().dbid()] = s;
+            s->save();
+        }
+        plan->save();
+    }
+    c.erase(deletedStudents);
+    c.save();
+
+    return w.rows();
+}
+
+SubjectsPlanPtr Database::Impl::loadPlan(DBID planId)
+{
+    auto cached = plans[planId].lock();
+    if (cached) {
+        return cached;
+    }
+
+    QSqlDatabase db = database();
+    auto planQuery = select(db, "SELECT name FROM subjects_plans WHERE id = ?", {planId});
+    ATT_REQUIRE(planQuery.next(), "Subjects plan " << planId << " not found");
+    const DataString name = planQuery.value(0).toString();
+
+    SubjectPtrVector planSubjects;
+    auto query = select(db,
+        "SELECT s.id, s.name, s.shortened_name FROM subjects_plan_subjects ps "
+        "JOIN subjects s ON s.id = ps.subject_id WHERE ps.plan_id = ? ORDER BY ps.position",
+        {planId});
+    while (query.next()) {
+        const DBID dbid = query.value(0).toUInt();
+        auto subject = subjects[dbid].lock();
+        if (!subject) {
+            subject = std::make_shared<Subject>(
+                ID::setDBID(ID::gen(), dbid), query.value(1).toString(), query.value(2).toString());
+            subjects[dbid] = subject;
+        }
+        planSubjects.push_back(subject);
+    }
+
+    auto plan = std::make_shared<SubjectsPlan>(
+        ID::setDBID(ID::gen(), planId), name, std::move(planSubjects));
+    plans[planId] = plan;
+    return plan;
+}
+
+std::unique_ptr<Class> Database::Impl::load(DBID classId)
+{
+    QSqlDatabase db = database();
+
+    auto classQuery = select(db,
+        "SELECT title, graduation_year, issue_date, subjects_plan_id "
+        "FROM classes WHERE id = ?", {classId});
+    ATT_REQUIRE(classQuery.next(), "Class " << classId << " not found");
+
+    SubjectsPlanPtr plan;
+    std::map<DBID, ID> subjectIds;
+    if (!classQuery.value(3).isNull()) {
+        plan = loadPlan(classQuery.value(3).toUInt());
+        for (const auto& id : plan->subjectIds()) {
+            subjectIds.emplace(id.dbid(), id);
+        }
+    }
+
+    std::map<DBID, std::map<ID, grades::Value>> grades;
+    auto gradesQuery = select(db,
+        "SELECT g.student_id, g.subject_id, g.value FROM grades g "
+        "JOIN students s ON s.id = g.student_id WHERE s.class_id = ?", {classId});
+    while (gradesQuery.next()) {
+        auto subject = subjectIds.find(gradesQuery.value(1).toUInt());
+        if (subject != subjectIds.end()) {
+            grades[gradesQuery.value(0).toUInt()][subject->second] = gradesQuery.value(2).toString();
+        }
+    }
+
+    // grades of all students share plan order storage
+    auto layout = plan
+        ? plan->layout()
+        : std::make_shared<SubjectsLayout>(SubjectsPlan::SubjectIdVector());
+
+    pool::ScopedPool studentsPool; // students of class share memory
+    std::vector<Class::StudentPtr> students;
+    auto studentsQuery = select(db,
+        "SELECT id, family_name, name, parental_name, birth_date, graduation_year, "
+        "attestate_id, issue_date FROM students WHERE class_id = ? ORDER BY position, id", {classId});
+    while (studentsQuery.next()) {
+        const DBID dbid = studentsQuery.value(0).toUInt();
+        students.emplace_back(new Student(
+            ID::setDBID(ID::gen(), dbid),
+            studentsQuery.value(1).toString(),
+            studentsQuery.value(2).toString(),
+            studentsQuery.value(3).toString(),
+            toDate(studentsQuery.value(4)),
+            SubjectsGrades(layout, grades[dbid]),
+            toOptionalYear(studentsQuery.value(5)),
+            studentsQuery.value(6).toString(),
+            toOptionalDate(studentsQuery.value(7))));
+    }
+
+    return std::unique_ptr<Class>(new Class(
+        ID::setDBID(ID::gen(), classId),
+        classQuery.value(0).toString(),
+        toOptionalYear(classQuery.value(1)),
+        toOptionalDate(classQuery.value(2)),
+        std::move(students),
+        plan));
+}
+
+
+Database::Database(const QString& filename)
+    : impl_(new Impl(filename))
+{}
+
+Database::~Database()
+{}
+
+size_t Database::save(Class& c) { return impl_->save(c); }
+
+std::vector<DBID> Database::classIds()
+{
+    std::vector<DBID> res;
+    auto query = select(impl_->database(), "SELECT id FROM classes ORDER BY id", {});
+    while (query.next()) {
+        res.push_back(query.value(0).toUInt());
+    }
+    return res;
+}
+
+std::unique_ptr<Class> Database::load(DBID classId) { return impl_->load(classId); }
+
+} // namespace db
+} // namespace attestate
@@ -1,14 +1,24 @@
 #include <attestate/generate.h>
 
 #include "magic_strings.h"
+#include "parallel.h"
 
 #include <attestate/student.h>
 #include <attestate/grades.h>
+#include <attestate/exception.h>
 
 #include <doctpl/table_field.h>
 #include <doctpl/text_field.h>
+#include <doctpl/serialize.h>
 
+#include <QDir>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
 
 namespace attestate {
 
@@ -34,107 +44,477 @@ QString formatDate(const QDate& date)
     return date.toString(cfg::attestateDateFormat());
 }
 
-void fillCommonInfo(const Student& s, const Class& c, doctpl::Template& doc)
-{
-    auto tf = doc.fields()->as<doctpl::TextField>();
+} // namespace
+
+class BoundTemplate::Impl {
+public:
+    explicit Impl(doctpl::Template& doc)
+        : doc(doc)
+    {
+        namespace f = cfg::tags::fields;
+
+        QStringList missing;
+        auto tf = doc.fields()->as<doctpl::TextField>();
+        auto text = [&tf, &missing] (const QString& name)
+        {
+            auto field = tf->find(name);
+            if (!field) {
+                missing.push_back(name);
+            }
+            return field;
+        };
+        auto tbf = doc.fields()->as<doctpl::TableField>();
+        auto table = [&tbf, &missing] (const QString& name)
+        {
+            auto field = tbf->find(name);
+            if (!field) {
+                missing.push_back(name);
+            }
+            return field;
+        };
+
+        familyName1 = text(f::FAMILY_NAME_1);
+        familyName2 = text(f::FAMILY_NAME_2);
+        namePName1 = text(f::NAME_PNAME_1);
+        namePName2 = text(f::NAME_PNAME_2);
+        birthDate = text(f::BIRTH_DATE);
+        graduationYear = text(f::GRADUATION_YEAR);
+        issueDate1 = text(f::ISSUE_DATE_1);
+        issueDate2 = text(f::ISSUE_DATE_2);
+        attestateId = text(f::ATTESTATE_ID);
+
+        marked1 = table(f::GRADES_1);
+        marked2 = table(f::GRADES_2);
+        aux = table(f::AUX);
+
+        ATT_REQUIRE(missing.isEmpty(),
+            "Template has no fields: " << missing.join(", ").toStdString());
+
+        // rows of marked subjects continue from first table to second one
+        for (auto t : {marked1, marked2}) {
+            for (size_t row = 0; row < t->rowsCount(); ++row) {
+                markedRows.emplace_back(t, row);
+            }
+        }
+    }
+
+    void fillCommonInfo(const Student& s, const Class& c)
+    {
+        familyName1->setText(s.familyName());
+        familyName2->setText(s.familyName());
+        const QString n = s.name() + " " + s.parentalName();
+        namePName1->setText(n);
+        namePName2->setText(n);
+        birthDate->setText(formatDate(s.birthDate()));
+
+        graduationYear->setText(s.graduationYear()
+            ? formatYear(*s.graduationYear())
+            : c.graduationYear() ? formatYear(*c.graduationYear()) : QString());
+
+        const QString issueDate = s.issueDate()
+            ? formatDate(*s.issueDate())
+            : c.issueDate() ? formatDate(*c.issueDate()) : QString();
+        issueDate1->setText(issueDate);
+        issueDate2->setText(issueDate);
+
+        attestateId->setText(s.attestateId());
+    }
+
+    void fillGrades(const Student& s, const Class& c)
+    {
+        marked1->clear();
+        marked2->clear();
+        aux->clear();
+
+        size_t markedCounter = 0;
+        size_t auxCounter = 0;
+
+        const auto& sp = c.subjectsPlan();
+        for (size_t j = 0; sp && j < sp->subjectsCount(); ++j) {
+            const auto& subj = sp->at(j);
+            const grades::Code gc = s.grades().code(subj.id());
+            if (!grades::isValid(gc)) {
+                continue;
+            }
+
+            const grades::Type type = grades::type(gc);
+            if (type == grades::Type::HasRepresentation) {
+                ATT_REQUIRE(
+                    markedCounter < markedRows.size(),
+                    "Too many marked subjects count: " << markedCounter);
+                const auto& row = markedRows[markedCounter++];
+                row.first->setText(row.second, 0, subj.name());
+                row.first->setText(row.second, 1, grades::representation(gc));
+            } else if (type == grades::Type::Auxilliary) {
+                ATT_REQUIRE(
+                    auxCounter < aux->rowsCount(),
+                    "Too many auxilliary subjects count: " << auxCounter);
+                aux->setText(auxCounter++, 0, subj.name());
+            }
+        }
+    }
+
+    doctpl::Template& doc;
 
-    tf->find(cfg::tags::fields::FAMILY_NAME_1)->setText(s.familyName());
-    tf->find(cfg::tags::fields::FAMILY_NAME_2)->setText(s.familyName());
-    QString n = s.name() + " " + s.parentalName();
-    tf->find(cfg::tags::fields::NAME_PNAME_1)->setText(n);
-    tf->find(cfg::tags::fields::NAME_PNAME_2)->setText(n);
-    tf->find(cfg::tags::fields::BIRTH_DATE)->setText(formatDate(s.birthDate()));
+    doctpl::TextField* familyName1;
+    doctpl::TextField* familyName2;
+    doctpl::TextField* namePName1;
+    doctpl::TextField* namePName2;
+    doctpl::TextField* birthDate;
+    doctpl::TextField* graduationYear;
+    doctpl::TextField* issueDate1;
+    doctpl::TextField* issueDate2;
+    doctpl::TextField* attestateId;
 
-    QString gradYear = s.graduationYear()
-        ? formatYear(*s.graduationYear())
-        : c.graduationYear() ? formatYear(*c.graduationYear()) : QString();
+    doctpl::TableField* marked1;
+    doctpl::TableField* marked2;
+    doctpl::TableField* aux;
 
-    tf->find(cfg::tags::fields::GRADUATION_YEAR)->setText(gradYear);
+    std::vector<std::pair<doctpl::TableField*, size_t>> markedRows; // table, row
+};
 
-    QString issueDate = s.issueDate()
-        ? formatDate(*s.issueDate())
-        : c.issueDate() ? formatDate(*c.issueDate()) : QString();
+BoundTemplate::BoundTemplate(doctpl::Template& doc)
+    : impl_(new Impl(doc))
+{}
 
-    tf->find(cfg::tags::fields::ISSUE_DATE_1)->setText(issueDate);
-    tf->find(cfg::tags::fields::ISSUE_DATE_2)->setText(issueDate);
+BoundTemplate::~BoundTemplate()
+{}
 
-    tf->find(cfg::tags::fields::ATTESTATE_ID)->setText(s.attestateId());
+doctpl::Template& BoundTemplate::doc() { return impl_->doc; }
+
+void BoundTemplate::fill(const Class& cls, Class::Index studentIndex)
+{
+    const auto& s = cls.student(studentIndex);
+
+    impl_->fillCommonInfo(s, cls);
+    impl_->fillGrades(s, cls);
 }
 
-void fillGrades(const Student& s, const Class& c, doctpl::Template& doc)
+void fillTemplate(
+    const Class& cls,
+    Class::Index studentIndex,
+    doctpl::Template& doc)
 {
-    std::string n = (s.familyName() + " " + s.name()).toStdString();
+    BoundTemplate(doc).fill(cls, studentIndex);
+}
 
-    auto tbf = doc.fields()->as<doctpl::TableField>();
+QString pdfFileName(const Student& s)
+{
+    return s.familyName() + " " + s.name() + ".pdf";
+}
 
-    auto marked1 = tbf->find(cfg::tags::fields::GRADES_1);
-    auto marked2 = tbf->find(cfg::tags::fields::GRADES_2);
+namespace {
 
-    auto aux = tbf->find(cfg::tags::fields::AUX);
+// students with the same names get numbered files,
+// so that workers never print to one file
+std::vector<QString> uniqueFileNames(
+    const Class& cls, const std::vector<Class::Index>& students)
+{
+    const QString ext = ".pdf";
+
+    std::map<QString, size_t> used;
+    std::vector<QString> res;
+    res.reserve(students.size());
+    for (auto i : students) {
+        QString name = pdfFileName(cls.student(i));
+        const size_t n = ++used[name];
+        if (n > 1) {
+            name = name.left(name.size() - ext.size())
+                + " (" + QString::number(n) + ")" + ext;
+        }
+        res.push_back(name);
+    }
+    return res;
+}
 
-    marked1->clear();
-    marked2->clear();
-    aux->clear();
+} // namespace
 
-    size_t markedCounter = 0;
-    size_t auxCounter = 0;
+namespace {
 
-    auto markedIt = [=] (size_t markedCounter)
-        -> std::pair<doctpl::TableField*, size_t> // field, row
+std::vector<Class::Index> activeStudents(const Class& cls)
+{
+    std::vector<Class::Index> res;
+    for (Class::Index i = 0; i < cls.studentsCount(); ++i) {
+        if (cls.student(i).state() != State::Deleted) {
+            res.push_back(i);
+        }
+    }
+    return res;
+}
+
+// called from worker threads after each student
+typedef std::function<void(Class::Index student, bool isGenerated)> StudentCallback;
+
+// checked before each student, may block while generation is paused
+typedef std::function<bool()> StopCheck;
+
+BatchResult runBatch(
+    const Class& cls,
+    const std::vector<Class::Index>& students,
+    const BatchParams& params,
+    const StudentCallback& onStudent,
+    const StopCheck& isStopped)
+{
+    const QDir dir(params.outputDir);
+    ATT_REQUIRE(dir.exists(), "Output directory does not exist: " << params.outputDir.toStdString());
+
+    const auto fileNames = uniqueFileNames(cls, students);
+
+    const size_t workers = parallel::workersCount(params.workers, students.size());
+
+    parallel::TaskCounter tasks(students.size());
+    std::atomic<bool> isCancelled(false);
+    std::vector<std::map<Class::Index, std::string>> errors(workers); // by worker
+    std::vector<std::vector<Class::Index>> generated(workers); // by worker
+
+    // template of each worker is read and bound in calling thread,
+    // so a bad template fails before any file is written
+    std::vector<std::unique_ptr<doctpl::Template>> docs;
+    std::vector<std::unique_ptr<BoundTemplate>> bound;
+    docs.reserve(workers);
+    bound.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        docs.push_back(doctpl::xml::read(params.templatePath));
+        ATT_REQUIRE(docs.back(), "Could not read template " << params.templatePath.toStdString());
+        bound.emplace_back(new BoundTemplate(*docs.back()));
+    }
+
+    parallel::runWorkers(workers, [&] (size_t worker)
     {
-        auto c = markedCounter;
-        for (auto f : {marked1, marked2}) {
-            if (c < f->rowsCount()) {
-                return {f, c};
+        size_t task;
+        while (tasks.next(task)) {
+            if (isStopped && isStopped()) {
+                isCancelled = true;
+                return;
+            }
+            const auto i = students[task];
+            bool isGenerated = false;
+            try {
+                bound[worker]->fill(cls, i);
+                docs[worker]->print(dir.filePath(fileNames[task]));
+                generated[worker].push_back(i);
+                isGenerated = true;
+            } catch (const std::exception& ex) {
+                errors[worker].emplace(i, ex.what());
+            }
+            if (onStudent) {
+                onStudent(i, isGenerated);
             }
-            c -= f->rowsCount();
         }
-        ATT_ERROR("Too many marked subjects count: " << markedCounter);
-    };
+    });
 
-    const auto& sp = c.subjectsPlan();
+    BatchResult res{0, {}, isCancelled, {}};
+    for (auto& e : errors) {
+        res.errors.insert(e.begin(), e.end());
+    }
+    for (const auto& g : generated) {
+        res.generatedStudents.insert(g.begin(), g.end());
+    }
+    res.generated = res.generatedStudents.size();
+    return res;
+}
 
-    for (size_t j = 0; sp && j < sp->subjectsCount(); ++j) {
-        const auto& subj = sp->at(j);
-        auto gv = s.grades().value(subj.id());
-        if (!gv || !grades::isValid(*gv)) {
-            continue;
+} // namespace
+
+BatchResult generate(
+    const Class& cls,
+    const BatchParams& params,
+    const ProgressCallback& progress,
+    const std::atomic<bool>* cancel)
+{
+    const auto students = activeStudents(cls);
+    const size_t total = students.size();
+    std::atomic<size_t> done(0);
+
+    return runBatch(
+        cls,
+        students,
+        params,
+        [&] (Class::Index, bool)
+        {
+            const size_t d = ++done;
+            if (progress) {
+                progress(d, total);
+            }
+        },
+        [cancel] { return cancel && *cancel; });
+}
+
+
+// GenerationJob
+
+class GenerationJob::Impl {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    Impl(const Class& cls, const BatchParams& params, const JobProgressCallback& callback)
+        : cls(cls)
+        , params(params)
+        , callback(callback)
+        , students(activeStudents(cls))
+        , done(0)
+        , failed(0)
+        , isStarted(false)
+        , isFinished(false)
+        , isPaused(false)
+        , isCancelled(false)
+        , pausedTime(Clock::duration::zero())
+    {}
+
+    // blocks while paused
+    bool isStopped()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        resumed.wait(lock, [this] { return !isPaused || isCancelled; });
+        return isCancelled;
+    }
+
+    void onStudent(bool isGenerated)
+    {
+        if (!isGenerated) {
+            ++failed;
         }
-        //ATT_REQUIRE(
-        //    gv,
-        //    "Grade not set for subject: " << subj.name().toStdString() << ", student: " << n);
-        auto value = *gv;
-        //ATT_REQUIRE(
-        //    grades::isValid(value),
-        //    "Invalid grade value: " << value.toStdString()
-        //        << ", subject: " << subj.name().toStdString()
-        //        << ", student: " << n);
-
-        if (grades::type(value) == grades::Type::HasRepresentation) {
-            auto it = markedIt(markedCounter);
-            it.first->setText(it.second, 0, subj.name());
-            it.first->setText(it.second, 1, grades::representation(value));
-            ++markedCounter;
-        } else if (grades::type(value) == grades::Type::Auxilliary) {
-            ATT_REQUIRE(
-                auxCounter < aux->rowsCount(),
-                "Too many auxilliary subjects count: " << auxCounter);
-            aux->setText(auxCounter++, 0, subj.name());
+        ++done;
+        if (callback) {
+            callback(progress());
         }
     }
+
+    JobProgress progress() const
+    {
+        JobProgress res{done, failed, students.size(), 0, -1};
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!isStarted) {
+            return res;
+        }
+        const auto now = Clock::now();
+        auto active = now - startTime - pausedTime;
+        if (isPaused) {
+            active -= now - pauseStart;
+        }
+        const double seconds = std::chrono::duration<double>(active).count();
+        if (seconds > 0 && res.done > 0) {
+            res.studentsPerSecond = res.done / seconds;
+            res.etaSeconds = (res.total - res.done) / res.studentsPerSecond;
+        }
+        return res;
+    }
+
+    void run()
+    {
+        try {
+            result = runBatch(
+                cls,
+                students,
+                params,
+                [this] (Class::Index, bool isGenerated) { onStudent(isGenerated); },
+                [this] { return isStopped(); });
+        } catch (...) {
+            error = std::current_exception();
+        }
+        isFinished = true;
+    }
+
+    const Class& cls;
+    const BatchParams params;
+    const JobProgressCallback callback;
+    const std::vector<Class::Index> students;
+
+    std::atomic<size_t> done;
+    std::atomic<size_t> failed;
+    std::atomic<bool> isStarted;
+    std::atomic<bool> isFinished;
+
+    mutable std::mutex mutex;
+    std::condition_variable resumed;
+    bool isPaused;
+    bool isCancelled;
+    Clock::time_point startTime;
+    Clock::time_point pauseStart;
+    Clock::duration pausedTime;
+
+    std::thread thread;
+    BatchResult result;
+    std::exception_ptr error;
+};
+
+GenerationJob::GenerationJob(
+        const Class& cls,
+        const BatchParams& params,
+        const JobProgressCallback& progress)
+    : impl_(new Impl(cls, params, progress))
+{}
+
+GenerationJob::~GenerationJob()
+{
+    cancel();
+    if (impl_->thread.joinable()) {
+        impl_->thread.join();
+    }
 }
 
-} // namespace
+void GenerationJob::start()
+{
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        ATT_REQUIRE(!impl_->isStarted, "Generation job is already started");
+        impl_->startTime = Impl::Clock::now();
+        // paused before start, pause counts from start
+        impl_->pauseStart = impl_->startTime;
+        impl_->isStarted = true;
+    }
+    impl_->thread = std::thread([this] { impl_->run(); });
+}
 
-void fillTemplate(
-    const Class& cls,
-    Class::Index studentIndex,
-    doctpl::Template& doc)
+void GenerationJob::pause()
 {
-    const auto& s = cls.student(studentIndex);
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (!impl_->isPaused) {
+        impl_->isPaused = true;
+        impl_->pauseStart = Impl::Clock::now();
+    }
+}
 
-    fillCommonInfo(s, cls, doc);
-    fillGrades(s, cls, doc);
+void GenerationJob::resume()
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (impl_->isPaused) {
+        impl_->isPaused = false;
+        if (impl_->isStarted) {
+            impl_->pausedTime += Impl::Clock::now() - impl_->pauseStart;
+        }
+        impl_->resumed.notify_all();
+    }
+}
+
+bool GenerationJob::isPaused() const
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->isPaused;
+}
+
+void GenerationJob::cancel()
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->isCancelled = true;
+    impl_->resumed.notify_all();
+}
+
+bool GenerationJob::isFinished() const { return impl_->isFinished; }
+
+JobProgress GenerationJob::progress() const { return impl_->progress(); }
+
+BatchResult GenerationJob::wait()
+{
+    ATT_REQUIRE(impl_->isStarted, "Generation job is not started");
+    if (impl_->thread.joinable()) {
+        impl_->thread.join();
+    }
+    if (impl_->error) {
+        std::rethrow_exception(impl_->error);
+    }
+    return impl_->result;
 }
 
 } // namespace gen
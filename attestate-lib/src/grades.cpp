@@ -1,6 +1,8 @@
 #include <attestate/grades.h>
 
 #include "diff.h"
+#include "pool.h"
+#include "snapshot_io.h"
 
 #include <attestate/exception.h>
 
@@ -14,97 +16,468 @@ namespace grades {
 
 namespace {
 
-const ValuesSet s_reprValues = { "5", "4", "3" };
+// Every grade is a single symbol, its code is position in table + 1
 
-const ValuesSet s_auxValues = {
-    QString::fromUtf8("д"), QString::fromUtf8("Д"), "+"
+struct GradeInfo {
+    char16_t symbol;
+    Type type;
+    int8_t representation; // index in representations(), -1 if none
 };
 
-const ValuesSet s_noneValues = {
-    QString::fromUtf8("н"), QString::fromUtf8("Н"), "-"
+constexpr GradeInfo GRADE_TABLE[] = {
+    {u'5', Type::HasRepresentation, 0},
+    {u'4', Type::HasRepresentation, 1},
+    {u'3', Type::HasRepresentation, 2},
+    {u'д', Type::Auxilliary, -1},
+    {u'Д', Type::Auxilliary, -1},
+    {u'+', Type::Auxilliary, -1},
+    {u'н', Type::None, -1},
+    {u'Н', Type::None, -1},
+    {u'-', Type::None, -1}
 };
 
+constexpr size_t GRADES_COUNT = sizeof(GRADE_TABLE) / sizeof(GRADE_TABLE[0]);
+
+static_assert(GRADES_COUNT < INVALID_CODE, "Grade codes must fit Code");
+
+const GradeInfo& info(Code code)
+{
+    ATT_REQUIRE(isValid(code), "Invalid grade code: " << size_t(code));
+    return GRADE_TABLE[code - 1];
+}
+
+const std::vector<Representation>& representations()
+{
+    static const std::vector<Representation> s_repr = {
+        QString::fromUtf8("5 (отлично)"),
+        QString::fromUtf8("4 (хорошо)"),
+        QString::fromUtf8("3 (удовл.)")
+    };
+    return s_repr;
+}
+
+// index is code - 1
+const std::vector<Value>& codeValues()
+{
+    static const std::vector<Value> s_values = [] {
+        std::vector<Value> values;
+        for (const auto& g : GRADE_TABLE) {
+            values.push_back(QString(QChar(g.symbol)));
+        }
+        return values;
+    }();
+    return s_values;
+}
+
 } // namespace
 
 // TODO maybe customized ? DB?
 ValuesSet validValues()
 {
-    ValuesSet all(s_reprValues.begin(), s_reprValues.end());
-    all.insert(s_auxValues.begin(), s_auxValues.end());
-    all.insert(s_noneValues.begin(), s_noneValues.end());
-    return all;
+    const auto& values = codeValues();
+    return ValuesSet(values.begin(), values.end());
 }
 
-bool isValid(const Value& value)
+bool isValid(const Value& value) { return code(value) != INVALID_CODE; }
+
+bool isValid(Code code) { return code != NO_CODE && code <= GRADES_COUNT; }
+
+const Representation& representation(const Value& value)
 {
-    return validValues().count(value) != 0;
+    const Code c = code(value);
+    ATT_REQUIRE(isValid(c), "Invalid grade value: " << value.toStdString());
+    return representation(c);
 }
 
-//FIXME tests
+const Representation& representation(Code code)
+{
+    const int8_t repr = info(code).representation;
+    ATT_REQUIRE(repr >= 0, "No representation for grade code: " << size_t(code));
+    return representations()[repr];
+}
 
-namespace {
+Type type(const Value& value)
+{
+    const Code c = code(value);
+    if (!isValid(c)) {
+        ATT_ERROR("Invalid grade value: " << value.toStdString());
+    }
+    return type(c);
+}
 
-typedef std::map<Value, Representation> RepresentationMap;
+Type type(Code code) { return info(code).type; }
 
-const RepresentationMap& representationsImpl()
+Code code(const Value& value)
 {
-    static const RepresentationMap s_repr = {
-        {"5", QString::fromUtf8("5 (отлично)")},
-        {"4", QString::fromUtf8("4 (хорошо)")},
-        {"3", QString::fromUtf8("3 (удовл.)")}
-    };
+    if (value.size() != 1) {
+        return INVALID_CODE;
+    }
+    const char16_t symbol = value.at(0).unicode();
+    for (size_t i = 0; i < GRADES_COUNT; ++i) {
+        if (GRADE_TABLE[i].symbol == symbol) {
+            return i + 1;
+        }
+    }
+    return INVALID_CODE;
+}
 
-    return s_repr;
+const Value& value(Code code)
+{
+    ATT_REQUIRE(isValid(code), "Invalid grade code: " << size_t(code));
+    return codeValues()[code - 1];
 }
 
-} // namespace
+} // namespace grades
 
-const Representation& representation(const Value& value)
+
+// class SubjectsLayout
+
+SubjectsLayout::SubjectsLayout()
+    : isOpen_(true)
+{}
+
+SubjectsLayout::SubjectsLayout(const std::vector<ID>& subjectIds)
+    : isOpen_(false)
 {
-    return representationsImpl().at(value);
+    ids_.reserve(subjectIds.size());
+    for (const auto& id : subjectIds) {
+        slot(id);
+    }
 }
 
-Type type(const Value& value)
+SubjectsLayout::OptionalSlot SubjectsLayout::find(const ID& subjectId) const
 {
-    Type res;
-    if (s_reprValues.count(value)) {
-        res = Type::HasRepresentation;
-    } else if (s_auxValues.count(value)) {
-        res = Type::Auxilliary;
-    } else if (s_noneValues.count(value)) {
-        res =  Type::None;
-    } else {
-        ATT_ERROR("Invalid grade value: " << value.toStdString());
+    auto it = slots_.find(subjectId);
+    if (it == slots_.end()) {
+        return boost::none;
     }
-    return res;
+    return it->second;
 }
 
-} // namespace grades
+SubjectsLayout::Slot SubjectsLayout::slot(const ID& subjectId)
+{
+    auto res = slots_.insert({subjectId, ids_.size()});
+    if (res.second) {
+        ids_.push_back(subjectId);
+    }
+    return res.first->second;
+}
+
+const ID& SubjectsLayout::subjectId(Slot slot) const
+{
+    ATT_REQUIRE(slot < ids_.size(), "Slot " << slot << " is out of range");
+    return ids_[slot];
+}
+
+size_t SubjectsLayout::size() const { return ids_.size(); }
+
+bool SubjectsLayout::isOpen() const { return isOpen_; }
+
+void SubjectsLayout::write(SnapshotWriter& out) const
+{
+    out.stream() << isOpen_ << quint32(ids_.size());
+    for (const auto& id : ids_) {
+        out.write(id);
+    }
+}
+
+SubjectsLayout SubjectsLayout::read(SnapshotReader& in)
+{
+    QDataStream& s = in.stream();
+    bool isOpen = false;
+    quint32 size = 0;
+    s >> isOpen >> size;
+    in.check();
+    std::vector<ID> ids;
+    for (quint32 i = 0; i < size && s.status() == QDataStream::Ok; ++i) {
+        ids.push_back(in.readID());
+    }
+    in.check();
+    SubjectsLayout res(ids);
+    res.isOpen_ = isOpen;
+    return res;
+}
 
 
 // class SubjectsGrades
 
-class SubjectsGrades::Impl {
+class SubjectsGrades::Impl : public pool::Pooled {
 public:
-    std::map<ID, grades::Value> values; // subject id -> grade value
+    typedef SubjectsLayout::Slot Slot;
+    typedef std::map<ID, grades::Value> Values;
+
+    explicit Impl(const SubjectsLayoutPtr& layout)
+        : layout(layout)
+    {
+        ATT_ASSERT(layout);
+    }
+
+    grades::Code codeAt(Slot slot) const
+    {
+        return slot < codes.size() ? codes[slot] : grades::NO_CODE;
+    }
+
+    // slot to store grade of subject, adds subject to open layout only,
+    // open layout shared with other grades is copied first
+    Slot slotFor(const ID& subjectId)
+    {
+        if (auto slot = layout->find(subjectId)) {
+            return *slot;
+        }
+        ATT_REQUIRE(layout->isOpen(), "Subject " << subjectId << " is not in subjects plan of grades");
+        if (layout.use_count() > 1) {
+            layout = std::make_shared<SubjectsLayout>(*layout);
+        }
+        return layout->slot(subjectId);
+    }
+
+    bool isEmpty() const
+    {
+        return original.empty() &&
+            std::all_of(codes.begin(), codes.end(),
+                [] (grades::Code c) { return c == grades::NO_CODE; });
+    }
+
+    void rebind(const SubjectsLayoutPtr& to)
+    {
+        ATT_ASSERT(to);
+        if (to == layout) {
+            return;
+        }
+        auto target = [this, &to] (Slot slot)
+        {
+            const ID& id = layout->subjectId(slot);
+            if (auto res = to->find(id)) {
+                return *res;
+            }
+            ATT_REQUIRE(to->isOpen(), "Subject " << id << " is not in subjects plan of grades");
+            return to->slot(id);
+        };
+        // all slots are checked before changes
+        std::vector<std::pair<Slot, Slot>> moved;
+        for (Slot slot = 0; slot < codes.size(); ++slot) {
+            if (codes[slot] != grades::NO_CODE) {
+                moved.emplace_back(slot, target(slot));
+            }
+        }
+
+        std::vector<grades::Code> newCodes;
+        std::map<Slot, grades::Value> newInvalid;
+        std::map<Slot, grades::OptionalValue> newOriginal;
+        std::vector<bool> newModified;
+        for (const auto& m : moved) {
+            if (m.second >= newCodes.size()) {
+                newCodes.reserve(std::max(m.second + 1, to->size()));
+                newCodes.resize(m.second + 1, grades::NO_CODE);
+            }
+            newCodes[m.second] = codes[m.first];
+            if (codes[m.first] == grades::INVALID_CODE) {
+                newInvalid[m.second] = invalid.at(m.first);
+            }
+        }
+        // removed grades are kept in original only
+        for (const auto& o : original) {
+            const Slot slot = target(o.first);
+            newOriginal.emplace(slot, o.second);
+            if (slot >= newModified.size()) {
+                newModified.resize(slot + 1, false);
+            }
+            newModified[slot] = true;
+        }
+        layout = to;
+        codes = std::move(newCodes);
+        invalid = std::move(newInvalid);
+        original = std::move(newOriginal);
+        modified = std::move(newModified);
+    }
+
+    grades::OptionalValue valueAt(Slot slot) const
+    {
+        const grades::Code c = codeAt(slot);
+        if (c == grades::NO_CODE) {
+            return boost::none;
+        }
+        if (c == grades::INVALID_CODE) {
+            return invalid.at(slot);
+        }
+        return grades::value(c);
+    }
+
+    grades::OptionalValue value(const ID& subjectId) const
+    {
+        auto slot = layout->find(subjectId);
+        return slot ? valueAt(*slot) : grades::OptionalValue();
+    }
+
+    // without modification tracking
+    void setAt(Slot slot, const grades::OptionalValue& value)
+    {
+        if (codeAt(slot) == grades::INVALID_CODE) {
+            invalid.erase(slot);
+        }
+        if (!value) {
+            if (slot < codes.size()) {
+                codes[slot] = grades::NO_CODE;
+            }
+            return;
+        }
+        if (slot >= codes.size()) {
+            // one allocation for all subjects of layout
+            codes.reserve(std::max(slot + 1, layout->size()));
+            codes.resize(slot + 1, grades::NO_CODE);
+        }
+        codes[slot] = grades::code(*value);
+        if (codes[slot] == grades::INVALID_CODE) {
+            invalid[slot] = *value;
+        }
+    }
+
+    // must be called on every value change
+    void track(
+        Slot slot,
+        const grades::OptionalValue& oldValue,
+        const grades::OptionalValue& newValue)
+    {
+        auto it = original.find(slot);
+        if (it == original.end()) {
+            if (oldValue != newValue) {
+                original.emplace(slot, oldValue);
+                setModifiedAt(slot, true);
+            }
+        } else if (it->second == newValue) {
+            original.erase(it);
+            setModifiedAt(slot, false);
+        }
+    }
+
+    void setModifiedAt(Slot slot, bool isModified)
+    {
+        if (slot >= modified.size()) {
+            if (!isModified) {
+                return;
+            }
+            modified.resize(slot + 1, false);
+        }
+        modified[slot] = isModified;
+    }
+
+    bool isModifiedAt(Slot slot) const
+    {
+        return slot < modified.size() && modified[slot];
+    }
+
+    void clearModified()
+    {
+        original.clear();
+        modified.clear();
+    }
+
+    void set(Slot slot, const grades::OptionalValue& value)
+    {
+        track(slot, valueAt(slot), value);
+        setAt(slot, value);
+    }
+
+    Values toValues() const
+    {
+        Values res;
+        for (Slot slot = 0; slot < codes.size(); ++slot) {
+            if (codes[slot] != grades::NO_CODE) {
+                res.emplace(layout->subjectId(slot), *valueAt(slot));
+            }
+        }
+        return res;
+    }
+
+    void assign(const Impl& o)
+    {
+        if (layout != o.layout && layout->isOpen() && isEmpty()) {
+            // standalone grades without values take layout of source
+            layout = o.layout;
+            codes.clear();
+            invalid.clear();
+            modified.clear();
+        }
+        if (layout == o.layout) {
+            const Slot size = std::max(codes.size(), o.codes.size());
+            for (Slot slot = 0; slot < size; ++slot) {
+                if (codeAt(slot) != o.codeAt(slot) || codeAt(slot) == grades::INVALID_CODE) {
+                    set(slot, o.valueAt(slot));
+                }
+            }
+            return;
+        }
+        const Values values = o.toValues();
+        for (Slot slot = 0; slot < codes.size(); ++slot) {
+            if (codes[slot] != grades::NO_CODE && !values.count(layout->subjectId(slot))) {
+                set(slot, boost::none);
+            }
+        }
+        for (const auto& v : values) {
+            set(slotFor(v.first), v.second);
+        }
+    }
+
+    SubjectsLayoutPtr layout;
+    std::vector<grades::Code> codes; // by slot
+    std::map<Slot, grades::Value> invalid; // values of slots with INVALID_CODE
+    std::map<Slot, grades::OptionalValue> original; // modified slots only
+    std::vector<bool> modified; // by slot, set for slots kept in original
 };
 
 
+namespace {
+
+// shared by standalone grades until first value
+const SubjectsLayoutPtr& emptyLayout()
+{
+    static const SubjectsLayoutPtr layout = std::make_shared<SubjectsLayout>();
+    return layout;
+}
+
+} // namespace
+
 SubjectsGrades::SubjectsGrades()
-    : impl_(new Impl())
+    : impl_(new Impl(emptyLayout()))
 {}
 
 SubjectsGrades::SubjectsGrades(const std::map<ID, grades::Value>& values)
-    : impl_(new Impl{values})
+    : SubjectsGrades(std::make_shared<SubjectsLayout>(), values)
+{}
+
+SubjectsGrades::SubjectsGrades(const SubjectsLayoutPtr& layout)
+    : impl_(new Impl(layout))
 {}
 
+SubjectsGrades::SubjectsGrades(
+        const SubjectsLayoutPtr& layout,
+        const std::map<ID, grades::Value>& values)
+    : impl_(new Impl(layout))
+{
+    for (const auto& v : values) {
+        if (!v.second.isEmpty()) {
+            impl_->setAt(impl_->slotFor(v.first), v.second);
+        }
+    }
+}
+
 SubjectsGrades::SubjectsGrades(const SubjectsGrades& o)
     : impl_(new Impl(*o.impl_))
 {}
 
 SubjectsGrades& SubjectsGrades::operator = (const SubjectsGrades& o)
 {
-    *impl_ = *o.impl_;
+    if (this == &o) {
+        return *this;
+    }
+    if (!o.impl_) {
+        impl_.reset();
+    } else if (!impl_) {
+        // moved-from object
+        impl_.reset(new Impl(*o.impl_));
+    } else {
+        impl_->assign(*o.impl_);
+    }
     return *this;
 }
 
@@ -124,55 +497,200 @@ SubjectsGrades::~SubjectsGrades()
 
 grades::OptionalValue SubjectsGrades::value(const ID& subjectId) const
 {
-    auto it = impl_->values.find(subjectId);
-    if (it == impl_->values.end()) {
-        return boost::none;
-    }
-    return it->second;
+    return impl_->value(subjectId);
 }
 
 void SubjectsGrades::setValue(
     const ID& subjectId, const grades::OptionalValue& value)
 {
     if (!value || value->isEmpty()) {
-        auto it = impl_->values.find(subjectId);
-        ATT_REQUIRE(it != impl_->values.end(), "No subject with id " << subjectId); // TODO test
-        impl_->values.erase(it);
+        auto slot = impl_->layout->find(subjectId);
+        ATT_REQUIRE(
+            slot && impl_->codeAt(*slot) != grades::NO_CODE,
+            "No subject with id " << subjectId); // TODO test
+        impl_->set(*slot, boost::none);
         return;
     }
-    auto res = impl_->values.insert({subjectId, *value});
-    if (!res.second) {
-        res.first->second = *value;
+    const auto slot = impl_->slotFor(subjectId);
+    if (impl_->valueAt(slot) != value) {
+        impl_->set(slot, value);
     }
 }
 
 SubjectsGrades::Diff
 SubjectsGrades::diff(const SubjectsGrades& otherGrades) const
 {
-    return attestate::Diff<ID, grades::Value>::compute(
-        impl_->values, otherGrades.impl_->values);
+    const Impl& o = *otherGrades.impl_;
+    if (impl_->layout != o.layout) {
+        return attestate::Diff<ID, grades::Value>::compute(
+            impl_->toValues(), o.toValues());
+    }
+
+    Diff res;
+    const auto size = std::max(impl_->codes.size(), o.codes.size());
+    for (Impl::Slot slot = 0; slot < size; ++slot) {
+        const grades::Code c = impl_->codeAt(slot);
+        const grades::Code oc = o.codeAt(slot);
+        if (c == oc && c != grades::INVALID_CODE) {
+            continue;
+        }
+        auto v = impl_->valueAt(slot);
+        auto ov = o.valueAt(slot);
+        if (v != ov) {
+            res.emplace(impl_->layout->subjectId(slot), std::make_pair(v, ov));
+        }
+    }
+    return res;
 }
 
 void SubjectsGrades::applyDiff(const Diff& diff)
 {
-    attestate::Diff<ID, grades::Value>::apply(impl_->values, diff);
+    // check
+    for (const auto& d : diff) {
+        const auto& p = d.second;
+        const auto v = impl_->value(d.first);
+        if (p.first) {
+            ATT_REQUIRE(v, "Key " << d.first << " not found");
+            ATT_REQUIRE(*v == *p.first,
+                "Diff and map values for key " << d.first << " mismatch, "
+                << " expected " << *v << ", got " << *p.first);
+            if (p.second) {
+                ATT_REQUIRE(*p.second != *p.first,
+                    "Equal values " << *p.first << " in diff for key " << d.first);
+            }
+        } else {
+            ATT_REQUIRE(!v, "Key " << d.first << " is not expected");
+            ATT_REQUIRE(p.second, "Both diff values are none for key " << d.first);
+            ATT_REQUIRE(impl_->layout->isOpen() || impl_->layout->find(d.first),
+                "Subject " << d.first << " is not in subjects plan of grades");
+        }
+    }
+    // apply
+    for (const auto& d : diff) {
+        impl_->set(impl_->slotFor(d.first), d.second.second);
+    }
 }
 
 std::list<grades::OptionalValue>
 SubjectsGrades::values(const std::list<ID>& subjectIds) const
 {
     std::list<grades::OptionalValue> res;
-    for (auto id : subjectIds) {
-        auto it = impl_->values.find(id);
-        if (it == impl_->values.end()) {
-            res.push_back(boost::none);
-        } else {
-            res.push_back(it->second);
-        }
+    for (const auto& id : subjectIds) {
+        res.push_back(impl_->value(id));
     }
     return res;
 }
 
+grades::Code SubjectsGrades::code(const ID& subjectId) const
+{
+    auto slot = impl_->layout->find(subjectId);
+    return slot ? impl_->codeAt(*slot) : grades::NO_CODE;
+}
+
+const SubjectsLayoutPtr& SubjectsGrades::layout() const { return impl_->layout; }
+
+void SubjectsGrades::setLayout(const SubjectsLayoutPtr& layout) { impl_->rebind(layout); }
+
+const std::vector<grades::Code>& SubjectsGrades::codes() const { return impl_->codes; }
+
+bool SubjectsGrades::isModified() const { return !impl_->original.empty(); }
+
+bool SubjectsGrades::isModified(const ID& subjectId) const
+{
+    auto slot = impl_->layout->find(subjectId);
+    return slot && impl_->isModifiedAt(*slot);
+}
+
+bool SubjectsGrades::isModifiedAt(SubjectsLayout::Slot slot) const
+{
+    return impl_->isModifiedAt(slot);
+}
+
+SubjectsGrades::Diff SubjectsGrades::changes() const
+{
+    Diff res;
+    for (const auto& o : impl_->original) {
+        res.emplace(
+            impl_->layout->subjectId(o.first),
+            std::make_pair(o.second, impl_->valueAt(o.first)));
+    }
+    return res;
+}
+
+void SubjectsGrades::save() { impl_->clearModified(); }
+
+void SubjectsGrades::write(SnapshotWriter& out) const
+{
+    QDataStream& s = out.stream();
+    out.writeRef(impl_->layout, [&out] (const SubjectsLayout& layout) { layout.write(out); });
+
+    s << quint32(impl_->codes.size());
+    s.writeRawData(
+        reinterpret_cast<const char*>(impl_->codes.data()), impl_->codes.size());
+    s << quint32(impl_->invalid.size());
+    for (const auto& v : impl_->invalid) {
+        s << quint32(v.first) << v.second;
+    }
+    s << quint32(impl_->original.size());
+    for (const auto& v : impl_->original) {
+        s << quint32(v.first);
+        out.write(v.second);
+    }
+}
+
+SubjectsGrades SubjectsGrades::read(SnapshotReader& in)
+{
+    QDataStream& s = in.stream();
+    auto layout = in.readRef<SubjectsLayout>([&in] {
+        return std::make_shared<SubjectsLayout>(SubjectsLayout::read(in));
+    });
+    ATT_REQUIRE(layout, "No grades layout in snapshot");
+
+    SubjectsGrades res(layout);
+    Impl& impl = *res.impl_;
+
+    quint32 size = 0;
+    s >> size;
+    in.check();
+    ATT_REQUIRE(size <= layout->size(), "Grades count " << size << " exceeds layout size");
+    impl.codes.resize(size);
+    s.readRawData(reinterpret_cast<char*>(impl.codes.data()), size);
+    in.check();
+    size_t invalidCount = 0;
+    for (const auto c : impl.codes) {
+        ATT_REQUIRE(
+            c == grades::INVALID_CODE || c == grades::NO_CODE || grades::isValid(c),
+            "Unknown grade code " << size_t(c) << " in snapshot");
+        invalidCount += c == grades::INVALID_CODE ? 1 : 0;
+    }
+
+    auto readSlot = [&s, &in, &impl] ()
+    {
+        quint32 slot = 0;
+        s >> slot;
+        in.check();
+        ATT_REQUIRE(slot < impl.layout->size(), "Grade slot " << slot << " is out of range");
+        return Impl::Slot(slot);
+    };
+
+    s >> size;
+    for (quint32 i = 0; i < size; ++i) {
+        const Impl::Slot slot = readSlot();
+        s >> impl.invalid[slot];
+        ATT_REQUIRE(impl.codeAt(slot) == grades::INVALID_CODE, "Unexpected invalid grade in snapshot");
+    }
+    ATT_REQUIRE(impl.invalid.size() == invalidCount, "Invalid grades are missing in snapshot");
+
+    s >> size;
+    for (quint32 i = 0; i < size; ++i) {
+        const Impl::Slot slot = readSlot();
+        impl.original[slot] = in.readOptional<grades::Value>();
+        impl.setModifiedAt(slot, true);
+    }
+    in.check();
+    return res;
+}
+
 namespace grades {
 
 SubjectsGrades::Diff reverseDiff(const SubjectsGrades::Diff& diff)
@@ -183,4 +701,3 @@ SubjectsGrades::Diff reverseDiff(const SubjectsGrades::Diff& diff)
 } // namespace grades
 
 } // namespace attestate
-
@@ -67,7 +67,7 @@ public:
     typedef const Student* ConstStudentWeakPtr;
     typedef std::list<ConstStudentWeakPtr> ConstStudentWeakPtrList;
 
-    typedef uint8_t Index;
+    typedef size_t Index;
 
     const Student& student(Index at) const;
     Student& student(Index at);
@@ -89,6 +89,10 @@ public:
 
     bool areStudentsModified() const;
 
+    // since load or last save, ids of erased students keep their db ids
+    const IDSet& addedStudents() const;
+    const IDSet& erasedStudents() const;
+
     // subjects plan
     // shared with other classes
 
@@ -101,6 +105,10 @@ public:
     // in class itself and students
     void save();
 
+    // binary snapshot with students, subjects plan and original data
+    void write(SnapshotWriter& out) const;
+    static Class read(SnapshotReader& in);
+
 private:
     class Impl;
 
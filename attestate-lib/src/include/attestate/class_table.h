@@ -0,0 +1,73 @@
+#pragma once
+
+#include <attestate/common.h>
+#include <attestate/class.h>
+#include <attestate/grades.h>
+
+#include <vector>
+
+namespace attestate {
+
+// Read-only columnar snapshot of a class for bulk processing:
+// one contiguous column per student property and one column
+// of grade codes per subject of the plan.
+// Deleted students are omitted. Snapshot is not updated
+// on class changes and should be rebuilt after editing.
+
+class ClassTable {
+public:
+    explicit ClassTable(const Class& c);
+
+    typedef size_t Row;
+
+    size_t rowsCount() const;
+    size_t subjectsCount() const;
+
+    // class properties
+
+    const ID& id() const;
+    const ClassId& classId() const;
+    const OptionalYear& graduationYear() const;
+    const OptionalDate& issueDate() const;
+
+    // student columns, indexed by row
+
+    const std::vector<ID>& studentIds() const;
+    const std::vector<Class::Index>& studentIndexes() const; // position in class
+
+    const std::vector<DataString>& familyNames() const;
+    const std::vector<DataString>& names() const;
+    const std::vector<DataString>& parentalNames() const;
+    const std::vector<QDate>& birthDates() const;
+    const std::vector<OptionalYear>& graduationYears() const;
+    const std::vector<AttestateId>& attestateIds() const;
+    const std::vector<OptionalDate>& issueDates() const;
+
+    // grades
+
+    const std::vector<ID>& subjectIds() const; // subjects plan order
+
+    // codes of subject at plan position, indexed by row
+    const std::vector<grades::Code>& gradeCodes(size_t subject) const;
+
+private:
+    ID id_;
+    ClassId classId_;
+    OptionalYear graduationYear_;
+    OptionalDate issueDate_;
+
+    std::vector<ID> studentIds_;
+    std::vector<Class::Index> studentIndexes_;
+    std::vector<DataString> familyNames_;
+    std::vector<DataString> names_;
+    std::vector<DataString> parentalNames_;
+    std::vector<QDate> birthDates_;
+    std::vector<OptionalYear> graduationYears_;
+    std::vector<AttestateId> attestateIds_;
+    std::vector<OptionalDate> issueDates_;
+
+    std::vector<ID> subjectIds_;
+    std::vector<std::vector<grades::Code>> gradeCodes_; // by subject
+};
+
+} // namespace attestate
@@ -26,6 +26,8 @@ typedef QString DataString;
 // TODO maybe be able to construct complex ids like dd AA ddddd
 typedef DataString AttestateId;
 
+class IDBlock;
+
 class ID {
 public:
     explicit ID(DBID dbid);
@@ -41,9 +43,16 @@ public:
 
     static const ID& emptyID();
 
+    // Thread-safe, takes oids from calling thread's block
+    // or from the block of innermost ScopedIDBlock if any
     static ID gen();
 
+    // Reserves count consecutive oids
+    static IDBlock reserve(size_t count);
+
 private:
+    friend class IDBlock;
+
     ID(); // empty
     ID(const OID& oid, const DBID& dbid);
 
@@ -51,6 +60,40 @@ private:
     DBID dbid_;
 };
 
+// Range of reserved oids, given out in increasing order
+class IDBlock {
+public:
+    IDBlock(); // empty
+
+    size_t size() const;
+    bool empty() const;
+
+    // throws if block is exhausted
+    ID gen();
+
+private:
+    friend class ID;
+
+    IDBlock(OID first, OID end);
+
+    OID next_;
+    OID end_;
+};
+
+// While alive, ID::gen() in this thread takes oids from given block only,
+// so ids depend just on the block and the order of creation.
+class ScopedIDBlock {
+public:
+    explicit ScopedIDBlock(IDBlock& block);
+    ~ScopedIDBlock();
+
+    ScopedIDBlock(const ScopedIDBlock&) = delete;
+    ScopedIDBlock& operator = (const ScopedIDBlock&) = delete;
+
+private:
+    IDBlock* prev_;
+};
+
 typedef std::set<ID> IDSet;
 
 std::ostream& operator << (std::ostream& os, const ID& id);
@@ -58,5 +101,9 @@ std::ostream& operator << (std::ostream& os, const ID& id);
 
 enum class State {New, Existing, Modified, Deleted};
 
+// binary snapshot streams, see snapshot.h
+class SnapshotWriter;
+class SnapshotReader;
+
 } // namespace attestate
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <attestate/class.h>
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+namespace attestate {
+namespace db {
+
+// Workspace in a local SQLite file.
+// Only changed objects are written, grades row by row,
+// objects without db id are written completely.
+class Database {
+public:
+    // schema is created if file is new
+    explicit Database(const QString& filename);
+    ~Database();
+
+    Database(const Database&) = delete;
+    Database& operator = (const Database&) = delete;
+
+    // Writes changes of class, its subjects plan and students in one transaction,
+    // then assigns db ids to new objects and saves all of them.
+    // Class marked as deleted is removed from database and is not saved,
+    // students marked as deleted are removed from database and from class.
+    // Grades of subjects out of subjects plan are not stored.
+    // Returns count of written rows.
+    size_t save(Class& c);
+
+    std::vector<DBID> classIds();
+
+    // subjects plans shared by loaded classes are loaded once
+    std::unique_ptr<Class> load(DBID classId);
+
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace db
+} // namespace attestate
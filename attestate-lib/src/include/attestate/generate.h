@@ -3,6 +3,15 @@
 #include <attestate/class.h>
 #include <doctpl/template.h>
 
+#include <QString>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
 namespace attestate {
 
 namespace cfg {
@@ -37,10 +46,117 @@ const QString AUX = QString::fromUtf8("Дополнительные");
 
 namespace gen {
 
+// Template with fields of cfg::tags::fields and capacities of grades tables
+// resolved once, so that filling a student is a sequence of setters.
+// Template must outlive bound template and its fields must not be
+// added, removed or resized while it is bound.
+class BoundTemplate {
+public:
+    // throws listing all missing fields
+    explicit BoundTemplate(doctpl::Template& doc);
+    ~BoundTemplate();
+
+    BoundTemplate(const BoundTemplate&) = delete;
+    BoundTemplate& operator = (const BoundTemplate&) = delete;
+
+    doctpl::Template& doc();
+
+    void fill(const Class& cls, Class::Index studentIndex);
+
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
+
+// binds template on each call, BoundTemplate should be used for many students
 void fillTemplate(
     const Class& cls,
     Class::Index studentIndex,
     doctpl::Template& doc);
 
+
+// Batch generation of pdf files for all not deleted students of a class.
+// Students are distributed between workers, each worker prints to pdf
+// independently with its own template instance. All instances are read
+// before printing starts, so a bad template fails before any file is written.
+
+struct BatchParams {
+    QString templatePath;
+    QString outputDir;
+    size_t workers; // 0 means hardware threads count
+};
+
+struct BatchResult {
+    size_t generated;
+    std::map<Class::Index, std::string> errors; // student index -> error message
+    bool isCancelled;
+    std::set<Class::Index> generatedStudents; // not listed students failed or were cancelled
+};
+
+// called from worker threads, done counts both generated and failed students
+typedef std::function<void(size_t done, size_t total)> ProgressCallback;
+
+// class must not be modified until generation is finished,
+// cancel flag is checked before each student
+BatchResult generate(
+    const Class& cls,
+    const BatchParams& params,
+    const ProgressCallback& progress = nullptr,
+    const std::atomic<bool>* cancel = nullptr);
+
+// "<family name> <name>.pdf"
+QString pdfFileName(const Student& s);
+
+
+// Batch generation of a class in background, same as generate() gives.
+// Progress can be polled or reported by callback, generation can be paused,
+// resumed and cancelled, workers check these before each student.
+
+struct JobProgress {
+    size_t done; // generated and failed
+    size_t failed;
+    size_t total;
+    double studentsPerSecond; // pauses excluded, 0 until first student is done
+    double etaSeconds; // negative if unknown
+};
+
+// called from worker threads after each student
+typedef std::function<void(const JobProgress&)> JobProgressCallback;
+
+class GenerationJob {
+public:
+    // class must not be modified until job is finished
+    GenerationJob(
+        const Class& cls,
+        const BatchParams& params,
+        const JobProgressCallback& progress = nullptr);
+    // cancels and waits for workers
+    ~GenerationJob();
+
+    GenerationJob(const GenerationJob&) = delete;
+    GenerationJob& operator = (const GenerationJob&) = delete;
+
+    void start(); // once
+
+    void pause();
+    void resume();
+    bool isPaused() const;
+
+    void cancel(); // also wakes paused workers
+
+    bool isFinished() const;
+    JobProgress progress() const;
+
+    // waits for job to finish, rethrows error which stopped it
+    // e.g. missing output directory or unreadable template
+    BatchResult wait();
+
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
+
 } // namespace gen
 } // namespace attestate
@@ -9,6 +9,9 @@
 
 #include <set>
 #include <map>
+#include <list>
+#include <vector>
+#include <memory>
 
 namespace attestate {
 
@@ -20,27 +23,90 @@ typedef boost::optional<Value> OptionalValue;
 typedef std::set<Value> ValuesSet;
 
 ValuesSet validValues();
-bool isValid(const Value& value);
 
 enum class Type {HasRepresentation, Auxilliary, None};
 
-Type type(const Value& value);
-
 typedef QString Representation;
 
+// compact storage code of a grade value
+
+typedef uint8_t Code;
+
+const Code NO_CODE = 0; // no grade
+const Code INVALID_CODE = 0xFF; // stored value is not a valid grade
+
+// INVALID_CODE for values which are not valid, no allocations
+Code code(const Value& value);
+
+// for valid codes only
+const Value& value(Code code);
+
+bool isValid(const Value& value);
+bool isValid(Code code);
+
+// throw for invalid grades
+Type type(const Value& value);
+Type type(Code code);
+
+// for grades of HasRepresentation type only
 const Representation& representation(const Value& value);
+const Representation& representation(Code code);
 
 } // namespace grades
 
+
+// Positions of subjects in compact grades storage.
+// Plan layouts are built in subjects plan order and shared by grades of all
+// students of a class, grades reject subjects absent from them and only
+// the plan adds subjects. Open layouts belong to standalone grades, which
+// append unknown subjects on first use.
+
+class SubjectsLayout {
+public:
+    SubjectsLayout(); // open
+    explicit SubjectsLayout(const std::vector<ID>& subjectIds); // plan layout
+
+    typedef size_t Slot;
+    typedef boost::optional<Slot> OptionalSlot;
+
+    OptionalSlot find(const ID& subjectId) const;
+    Slot slot(const ID& subjectId); // adds subject if absent
+
+    const ID& subjectId(Slot slot) const;
+    size_t size() const;
+
+    bool isOpen() const;
+
+    // binary snapshot, open layouts stay open
+    void write(SnapshotWriter& out) const;
+    static SubjectsLayout read(SnapshotReader& in);
+
+private:
+    std::map<ID, Slot> slots_;
+    std::vector<ID> ids_;
+    bool isOpen_;
+};
+
+typedef std::shared_ptr<SubjectsLayout> SubjectsLayoutPtr;
+
+
 class SubjectsGrades {
 public:
+    // standalone grades, empty open layout is shared until first value
     SubjectsGrades();
     SubjectsGrades(const std::map<ID, grades::Value>& values); // subject id -> grade value
 
-    SubjectsGrades(const SubjectsGrades&);
-    SubjectsGrades& operator = (const SubjectsGrades&);
+    // throw for values of subjects absent from plan layout
+    explicit SubjectsGrades(const SubjectsLayoutPtr& layout);
+    SubjectsGrades(const SubjectsLayoutPtr& layout, const std::map<ID, grades::Value>& values);
 
+    SubjectsGrades(const SubjectsGrades&);
     SubjectsGrades(SubjectsGrades&&);
+
+    // copy assignment replaces values, it is tracked as modification
+    // of every changed subject; move assignment takes values together
+    // with their modifications
+    SubjectsGrades& operator = (const SubjectsGrades&);
     SubjectsGrades& operator = (SubjectsGrades&&);
 
     ~SubjectsGrades();
@@ -49,7 +115,8 @@ public:
     // none if there is no grade for subject
     grades::OptionalValue value(const ID& subjectId) const;
 
-    // setting empty value will remove subject
+    // setting empty value will remove subject,
+    // throws for subjects absent from plan layout
     void setValue(
         const ID& subjectId, const grades::OptionalValue& value);
 
@@ -66,6 +133,35 @@ public:
     // grades list according to subjects plan
     std::list<grades::OptionalValue> values(const std::list<ID>& subjectIds) const;
 
+    // compact access, no allocations
+
+    grades::Code code(const ID& subjectId) const;
+
+    const SubjectsLayoutPtr& layout() const;
+    // moves values and modifications to layout, e.g. of class plan,
+    // throws if some graded subject is absent from plan layout
+    void setLayout(const SubjectsLayoutPtr& layout);
+    // by layout slot, slots past the end have no grade
+    const std::vector<grades::Code>& codes() const;
+
+    // modifications since construction or last save,
+    // setting a value back to the saved one clears modification
+
+    bool isModified() const;
+    bool isModified(const ID& subjectId) const;
+    // by layout slot, no lookups
+    bool isModifiedAt(SubjectsLayout::Slot slot) const;
+
+    // modified subjects only, {original grade, current grade}
+    Diff changes() const;
+
+    // set current values as original
+    void save();
+
+    // binary snapshot with modifications, layout is shared by reference
+    void write(SnapshotWriter& out) const;
+    static SubjectsGrades read(SnapshotReader& in);
+
 private:
     class Impl;
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <attestate/class.h>
+#include <attestate/grades.h>
+#include <attestate/snapshot.h>
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+namespace attestate {
+namespace journal {
+
+// Append-only log of edits made since base snapshot was written, see snapshot.h.
+// Records refer to classes, students and subjects by positions,
+// so they stay valid after snapshot reading reassigns object ids.
+// Every record is flushed when written, edits survive application crash.
+class Journal {
+public:
+    // files are not touched until load() or compact()
+    Journal(const QString& basePath, const QString& journalPath);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator = (const Journal&) = delete;
+
+    // Reads base snapshot and replays journal records over it, empty if there is no base.
+    // Journal of other base, left by interrupted compaction, is discarded,
+    // incomplete last record is dropped. Next records are appended.
+    snapshot::ClassPtrVector load();
+
+    // Writes classes as new base and starts empty journal.
+    void compact(const std::vector<const Class*>& classes);
+
+    // records since base
+    size_t recordsCount() const;
+
+    // Edits are recorded after they are applied.
+    // Classes are indexed as in last load() or compact(),
+    // students and subjects by positions before the edit.
+
+    // class id, graduation year and issue date
+    void classChanged(size_t cls, const Class& c);
+    void studentChanged(size_t cls, Class::Index at, const Student& s, student::Field field);
+    // subjects which are not in class subjects plan are not recorded
+    void gradesChanged(size_t cls, Class::Index at, const Class& c, const SubjectsGrades::Diff& diff);
+    // diff of class subjects plan, a plan shared by classes is recorded once
+    void planChanged(size_t cls, const SubjectsPlan::Diff& diff);
+    // student at given position after insertion
+    void studentInserted(size_t cls, Class::Index at, const Class& c);
+    void studentErased(size_t cls, Class::Index at);
+
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace journal
+} // namespace attestate
@@ -3,8 +3,11 @@
 #include <attestate/class.h>
 
 #include <QString>
+#include <QStringList>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace attestate {
 
@@ -36,9 +39,31 @@ struct Params {
     QString dateFormat;
 };
 
+// file is mapped, decoded once and tokenized in place
 std::unique_ptr<Class> read(const QString& filename, const Params& params);
 
+// same result as read, line by line through QTextStream
+std::unique_ptr<Class> readStream(const QString& filename, const Params& params);
+
 void write(const Class& cls, const QString& filename, const Params& params);
 
+// Reading of many files, e.g. all classes of a school.
+// Files are read concurrently, largest first, errors are reported per file.
+
+struct FileResult {
+    QString filename;
+    std::unique_ptr<Class> cls; // null if reading failed
+    std::string error;
+};
+
+typedef std::vector<FileResult> FileResults;
+
+// results are in filenames order, workers 0 means hardware threads count;
+// ids of read objects depend on filenames order only
+FileResults readMany(const QStringList& filenames, const Params& params, size_t workers = 0);
+
+// all *.csv files of directory in name order
+FileResults readDir(const QString& dirname, const Params& params, size_t workers = 0);
+
 } // namespace csv
 } // namespace attestate
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <attestate/class.h>
+
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+namespace attestate {
+namespace snapshot {
+
+// Versioned binary workspace file.
+// Keeps current and original data of classes, students and subjects plans,
+// so states and modifications survive reopening.
+// Plans and subjects shared by classes stay shared after reading.
+// Object ids are reassigned on reading, database ids are kept.
+
+typedef std::vector<std::unique_ptr<Class>> ClassPtrVector;
+
+void write(const std::vector<const Class*>& classes, const QString& filename);
+
+// throws on unknown format version or corrupted data
+ClassPtrVector read(const QString& filename);
+
+} // namespace snapshot
+} // namespace attestate
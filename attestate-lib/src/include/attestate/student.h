@@ -10,19 +10,41 @@ namespace attestate {
 
 class SubjectsGrades;
 
+namespace student {
+
+// data fields, grades are tracked by subjects
+enum class Field : uint8_t {
+    FamilyName,
+    Name,
+    ParentalName,
+    BirthDate,
+    GraduationYear,
+    AttestateId,
+    IssueDate
+};
+
+// set of fields, one bit per field
+typedef uint8_t FieldMask;
+
+inline FieldMask fieldBit(Field field) { return FieldMask(1) << static_cast<uint8_t>(field); }
+
+const FieldMask ALL_FIELDS = (FieldMask(1) << (static_cast<uint8_t>(Field::IssueDate) + 1)) - 1;
+
+} // namespace student
+
 class Student {
 public:
     // create new
     explicit Student(const ID& id);
 
-    // load existing
+    // load existing, grades are moved in by loaders
     Student(
         const ID& id,
         const DataString& familyName,
         const DataString& name,
         const DataString& parentalName,
         const QDate& birthDate,
-        const SubjectsGrades& grades,
+        SubjectsGrades grades,
         OptionalYear graduationYear,
         const AttestateId& attestateId,
         const OptionalDate& issueDate);
@@ -32,6 +54,10 @@ public:
 
     ~Student();
 
+    // students created by loaders share memory of their class
+    static void* operator new(size_t size);
+    static void operator delete(void* p) noexcept;
+
     const ID& id() const;
     void setDBID(const DBID& dbid); // if saved to DB
 
@@ -65,6 +91,7 @@ public:
     const SubjectsGrades& grades() const;
     SubjectsGrades& grades();
     bool areGradesModified() const;
+    bool isGradeModified(const ID& subjectId) const;
 
     // graduation year
 
@@ -84,12 +111,23 @@ public:
 
     bool isModified() const;
 
+    // data fields modified since last save, all fields for new student;
+    // modified grades are kept by SubjectsGrades::isModifiedAt
+    student::FieldMask modifiedFields() const;
+    bool isFieldModified(student::Field field) const;
+
     // set current state as original and discard cached changes
     void save();
 
+    // binary snapshot with original data
+    void write(SnapshotWriter& out) const;
+    static Student read(SnapshotReader& in);
+
 private:
     class Impl;
 
+    explicit Student(Impl* impl);
+
     std::unique_ptr<Impl> impl_;
 };
 
@@ -2,6 +2,7 @@
 
 #include <attestate/common.h>
 #include <attestate/exception.h>
+#include <attestate/grades.h>
 
 #include <vector>
 #include <set>
@@ -44,6 +45,10 @@ public:
     // set current state as original and discard cached changes
     void save();
 
+    // binary snapshot with original data
+    void write(SnapshotWriter& out) const;
+    static Subject read(SnapshotReader& in);
+
 private:
     class Impl;
 
@@ -87,7 +92,7 @@ public:
     void setName(const DataString& name);
     bool isNameModified() const;
 
-    typedef uint8_t Index;
+    typedef size_t Index;
 
     void insert(const SubjectPtr& subject, Index at);
     void append(const SubjectPtr& subject);
@@ -116,6 +121,8 @@ public:
     > Diff;
 
     Diff diff(const SubjectsPlan& o) const;
+    // original subjects against current ones, all subjects are added for new plan
+    Diff changes() const;
     void applyDiff(const Diff& diff); // check that it is valid diff of current plan
 
     static SubjectsPlan::Diff reverseDiff(const SubjectsPlan::Diff& diff);
@@ -123,18 +130,30 @@ public:
     // RO access
 
     const Subject& at(Index at) const;
+    const SubjectPtr& subject(Index at) const; // shared with other plans
     bool hasSubject(const ID& id) const;
 
     size_t subjectsCount() const;
 
     SubjectIdVector subjectIds() const;
 
+    // grades storage order shared by students of classes with this plan,
+    // added subjects are appended to it, slots of erased ones are kept
+    const SubjectsLayoutPtr& layout() const;
+    // layout read from snapshot, shared with grades of read students;
+    // plan subjects absent from it are appended
+    void setLayout(const SubjectsLayoutPtr& layout);
+
     // by id
     bool operator == (const SubjectsPlan& other) const;
 
     // set current state as original and discard cached changes
     void save();
 
+    // binary snapshot with original data, subjects are shared by reference
+    void write(SnapshotWriter& out) const;
+    static SubjectsPlan read(SnapshotReader& in);
+
 private:
     class Impl;
 
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <attestate/class.h>
+#include <attestate/grades.h>
+#include <attestate/student.h>
+
+#include <boost/variant.hpp>
+
+#include <memory>
+#include <set>
+
+namespace attestate {
+namespace undo {
+
+// value of student::Field: DataString, QDate for birth date,
+// OptionalYear for graduation year and OptionalDate for issue date
+typedef boost::variant<DataString, QDate, OptionalYear, OptionalDate> FieldValue;
+
+FieldValue fieldValue(const Student& s, student::Field field);
+// throws if value type does not match field
+void setFieldValue(Student& s, student::Field field, const FieldValue& value);
+
+// touched by undo or redo
+struct Changes {
+    Changes() : isClassChanged(false), isStructureChanged(false) {}
+
+    std::set<Class::Index> students;
+    bool isClassChanged; // class id, graduation year or issue date
+    bool isStructureChanged; // students inserted or erased, subjects plan changed
+};
+
+// Edits of a class made through the stack can be undone and redone.
+// Steps keep diffs of edits, so undo and redo cost is proportional to the change.
+// Oldest steps are dropped when steps take more memory than the ceiling,
+// the last step is kept even if it alone takes more.
+class Stack {
+public:
+    static const size_t DEFAULT_MAX_BYTES = 16 << 20;
+
+    explicit Stack(Class& c, size_t maxBytes = DEFAULT_MAX_BYTES);
+    ~Stack();
+
+    Stack(const Stack&) = delete;
+    Stack& operator = (const Stack&) = delete;
+
+    // Edits are applied to class, each is a step unless made in a group.
+    // Edits which change nothing are not recorded. Redo steps are discarded.
+
+    void setGrades(Class::Index at, const SubjectsGrades::Diff& diff);
+    void setGrade(Class::Index at, const ID& subjectId, const grades::OptionalValue& value);
+    void setField(Class::Index at, student::Field field, const FieldValue& value);
+
+    void setClassId(const ClassId& classId);
+    void setGraduationYear(const OptionalYear& year);
+    void setIssueDate(const OptionalDate& issueDate);
+
+    void insert(Class::StudentPtr student, Class::Index at);
+    void erase(Class::Index at);
+
+    // diff of class subjects plan
+    void changeSubjectsPlan(const SubjectsPlan::Diff& diff);
+
+    // edits between begin and end make one step, groups can be nested
+    void beginGroup();
+    void endGroup();
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    size_t undoCount() const;
+    size_t redoCount() const;
+
+    Changes undo();
+    Changes redo();
+
+    // approximate memory taken by undo and redo steps,
+    // exceeds ceiling if the last step does
+    size_t bytes() const;
+    size_t maxBytes() const;
+    void setMaxBytes(size_t maxBytes);
+
+    void clear();
+
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
+
+// makes one step of edits done while alive
+class Group {
+public:
+    explicit Group(Stack& stack) : stack_(stack) { stack_.beginGroup(); }
+    ~Group() { stack_.endGroup(); }
+
+    Group(const Group&) = delete;
+    Group& operator = (const Group&) = delete;
+
+private:
+    Stack& stack_;
+};
+
+} // namespace undo
+} // namespace attestate
@@ -2,10 +2,13 @@
 
 #include <attestate/common.h>
 #include <attestate/class.h>
+#include <attestate/class_table.h>
 
 #include <boost/optional.hpp>
 
 #include <map>
+#include <memory>
+#include <vector>
 
 namespace attestate {
 
@@ -54,5 +57,51 @@ boost::optional<StudentErrors> validate(const Class& c, Class::Index studentIdx)
 // deleted students are omitted
 boost::optional<ClassErrors> validate(const Class& c);
 
+// same result as for the class the table is built from,
+// checks are done column by column
+boost::optional<ClassErrors> validate(const ClassTable& table);
+
+typedef std::map<ID, ClassErrors> ClassErrorsMap; // class id -> errors
+
+// Same results as validate(c) for each class, classes without errors are omitted.
+// Students are checked in ranges by all workers, so a big class is shared among them,
+// workers 0 means hardware threads count.
+ClassErrorsMap validate(const std::vector<const Class*>& classes, size_t workers = 0);
+
+
+// Keeps errors of a class up to date while it is edited.
+// Caller reports edits, only touched values are checked again.
+// Class must outlive validator.
+class Validator {
+public:
+    explicit Validator(const Class& c);
+    ~Validator();
+
+    Validator(const Validator&) = delete;
+    Validator& operator = (const Validator&) = delete;
+
+    // same as validate(c) gives, empty if there are no errors
+    const ClassErrors& errors() const;
+    bool hasErrors() const;
+
+    // any data of student including deleted state
+    void onStudentChanged(Class::Index at);
+    // property tag from cfg::tags::property
+    void onPropertyChanged(Class::Index at, const QString& propertyTag);
+    void onGradeChanged(Class::Index at, const ID& subjectId);
+    // issue date or graduation year of class
+    void onClassChanged();
+    // students inserted, erased or moved
+    void onStudentsChanged();
+
+    // everything from scratch, e.g. after subjects plan change
+    void revalidate();
+
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
+
 } // namespace validation
 } // namespace attestate
@@ -0,0 +1,471 @@
+#include <attestate/journal.h>
+
+#include "snapshot_io.h"
+
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+#include <attestate/exception.h>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+
+#include <vector>
+
+namespace attestate {
+namespace journal {
+
+namespace {
+
+const quint32 MAGIC = 0x4154544A; // "ATTJ"
+const quint16 VERSION = 1;
+
+enum class RecordType : quint8 {
+    Class,
+    StudentField,
+    Grades,
+    Plan,
+    StudentInserted,
+    StudentErased
+};
+
+const student::Field ALL_FIELDS[] = {
+    student::Field::FamilyName,
+    student::Field::Name,
+    student::Field::ParentalName,
+    student::Field::BirthDate,
+    student::Field::GraduationYear,
+    student::Field::AttestateId,
+    student::Field::IssueDate
+};
+
+// journal belongs to the base it was started for
+quint64 contentHash(const QByteArray& bytes)
+{
+    // FNV-1a
+    quint64 hash = 14695981039346656037ULL;
+    for (int i = 0; i < bytes.size(); ++i) {
+        hash ^= static_cast<unsigned char>(bytes.constData()[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+QByteArray readFile(const QString& filename)
+{
+    QFile file(filename);
+    ATT_REQUIRE(file.open(QIODevice::ReadOnly), "Could not open " << filename.toStdString());
+    return file.readAll();
+}
+
+void writeField(SnapshotWriter& out, const Student& s, student::Field field)
+{
+    QDataStream& st = out.stream();
+    st << quint8(field);
+    switch (field) {
+        case student::Field::FamilyName: st << s.familyName(); break;
+        case student::Field::Name: st << s.name(); break;
+        case student::Field::ParentalName: st << s.parentalName(); break;
+        case student::Field::BirthDate: st << s.birthDate(); break;
+        case student::Field::GraduationYear: out.write(s.graduationYear()); break;
+        case student::Field::AttestateId: st << s.attestateId(); break;
+        case student::Field::IssueDate: out.write(s.issueDate()); break;
+    }
+}
+
+void readField(SnapshotReader& in, Student& s)
+{
+    QDataStream& st = in.stream();
+    quint8 field = 0;
+    st >> field;
+    DataString str;
+    QDate date;
+    switch (student::Field(field)) {
+        case student::Field::FamilyName: st >> str; s.setFamilyName(str); break;
+        case student::Field::Name: st >> str; s.setName(str); break;
+        case student::Field::ParentalName: st >> str; s.setParentalName(str); break;
+        case student::Field::BirthDate: st >> date; s.setBirthDate(date); break;
+        case student::Field::GraduationYear: s.setGraduationYear(in.readOptional<Year>()); break;
+        case student::Field::AttestateId: st >> str; s.setAttestateId(str); break;
+        case student::Field::IssueDate: s.setIssueDate(in.readOptional<QDate>()); break;
+        default: ATT_ERROR("Unknown student field " << int(field) << " in journal");
+    }
+}
+
+// position of subject in class subjects plan
+boost::optional<quint32> subjectIndex(const Class& c, const ID& subjectId)
+{
+    const auto& plan = c.subjectsPlan();
+    if (plan) {
+        for (size_t i = 0; i < plan->subjectsCount(); ++i) {
+            if (plan->at(i).id() == subjectId) {
+                return quint32(i);
+            }
+        }
+    }
+    return boost::none;
+}
+
+const ID& subjectAt(const Class& c, quint32 index)
+{
+    const auto& plan = c.subjectsPlan();
+    ATT_REQUIRE(plan && index < plan->subjectsCount(),
+        "Journal refers to unknown subject " << index);
+    return plan->at(index).id();
+}
+
+Class::Index studentIndex(QDataStream& s, const Class& c, bool isInsertion)
+{
+    quint32 at = 0;
+    s >> at;
+    ATT_REQUIRE(at < c.studentsCount() + (isInsertion ? 1 : 0),
+        "Journal refers to unknown student " << at);
+    return at;
+}
+
+void replay(SnapshotReader& in, snapshot::ClassPtrVector& classes)
+{
+    QDataStream& s = in.stream();
+    quint8 type = 0;
+    quint32 cls = 0;
+    s >> type >> cls;
+    in.check();
+    ATT_REQUIRE(cls < classes.size(), "Journal refers to unknown class " << cls);
+    Class& c = *classes[cls];
+
+    switch (RecordType(type)) {
+        case RecordType::Class: {
+            ClassId classId;
+            s >> classId;
+            c.setClassId(classId);
+            c.setGraduationYear(in.readOptional<Year>());
+            c.setIssueDate(in.readOptional<QDate>());
+            break;
+        }
+        case RecordType::StudentField: {
+            readField(in, c.student(studentIndex(s, c, false)));
+            break;
+        }
+        case RecordType::Grades: {
+            Student& student = c.student(studentIndex(s, c, false));
+            quint32 count = 0;
+            s >> count;
+            SubjectsGrades::Diff diff;
+            for (quint32 i = 0; i < count; ++i) {
+                quint32 subject = 0;
+                s >> subject;
+                auto from = in.readOptional<grades::Value>();
+                auto to = in.readOptional<grades::Value>();
+                in.check();
+                diff.emplace(subjectAt(c, subject), std::make_pair(from, to));
+            }
+            student.grades().applyDiff(diff);
+            break;
+        }
+        case RecordType::Plan: {
+            const auto& plan = c.subjectsPlan();
+            ATT_REQUIRE(plan, "Journal refers to subjects plan of class " << cls << " which has none");
+            quint32 count = 0;
+            s >> count;
+            SubjectsPlan::Diff diff;
+            for (quint32 i = 0; i < count; ++i) {
+                bool isExisting = false;
+                s >> isExisting;
+                SubjectPtr subject;
+                SubjectsPlan::OptionalIndex from;
+                if (isExisting) {
+                    quint32 index = 0;
+                    s >> index;
+                    ATT_REQUIRE(index < plan->subjectsCount(),
+                        "Journal refers to unknown subject " << index);
+                    subject = plan->subject(index);
+                    from = index;
+                } else {
+                    DataString name;
+                    DataString shortenedName;
+                    s >> name >> shortenedName;
+                    subject = std::make_shared<Subject>(ID::gen());
+                    subject->setName(name);
+                    subject->setShortenedName(shortenedName);
+                }
+                auto to = in.readOptional<quint32>();
+                in.check();
+                diff.emplace(subject, std::make_pair(
+                    from, to ? SubjectsPlan::OptionalIndex(*to) : SubjectsPlan::OptionalIndex()));
+            }
+            plan->applyDiff(diff);
+            break;
+        }
+        case RecordType::StudentInserted: {
+            const Class::Index at = studentIndex(s, c, true);
+            Class::StudentPtr student(new Student(ID::gen()));
+            for (size_t i = 0; i < sizeof(ALL_FIELDS) / sizeof(ALL_FIELDS[0]); ++i) {
+                readField(in, *student);
+            }
+            quint32 count = 0;
+            s >> count;
+            for (quint32 i = 0; i < count; ++i) {
+                quint32 subject = 0;
+                grades::Value value;
+                s >> subject >> value;
+                in.check();
+                student->grades().setValue(subjectAt(c, subject), value);
+            }
+            c.insert(std::move(student), at);
+            break;
+        }
+        case RecordType::StudentErased: {
+            c.erase(studentIndex(s, c, false));
+            break;
+        }
+        default:
+            ATT_ERROR("Unknown journal record type " << int(type));
+    }
+    in.check();
+}
+
+} // namespace
+
+class Journal::Impl {
+public:
+    Impl(const QString& basePath, const QString& journalPath)
+        : basePath(basePath)
+        , journalPath(journalPath)
+        , file(journalPath)
+        , records(0)
+    {}
+
+    QString newBasePath() const { return basePath + ".new"; }
+
+    // empty journal of base with given content hash
+    void start(quint64 baseHash)
+    {
+        file.close();
+        ATT_REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Truncate),
+            "Could not open journal " << journalPath.toStdString());
+        QDataStream s(&file);
+        s.setVersion(QDataStream::Qt_5_0);
+        s << MAGIC << VERSION << baseHash;
+        ATT_REQUIRE(s.status() == QDataStream::Ok && file.flush(),
+            "Could not write journal " << journalPath.toStdString());
+        records = 0;
+    }
+
+    // returns records count, drops incomplete tail
+    size_t replayJournal(quint64 baseHash, snapshot::ClassPtrVector& classes);
+
+    template <class F>
+    void append(RecordType type, size_t cls, F writePayload)
+    {
+        ATT_REQUIRE(file.isOpen(), "Journal " << journalPath.toStdString() << " is not loaded");
+        QByteArray payload;
+        {
+            QDataStream s(&payload, QIODevice::WriteOnly);
+            s.setVersion(QDataStream::Qt_5_0);
+            s << quint8(type) << quint32(cls);
+            SnapshotWriter out(s);
+            writePayload(out);
+        }
+        QDataStream s(&file);
+        s.setVersion(QDataStream::Qt_5_0);
+        s << quint32(payload.size());
+        s.writeRawData(payload.constData(), payload.size());
+        ATT_REQUIRE(s.status() == QDataStream::Ok && file.flush(),
+            "Could not write journal " << journalPath.toStdString());
+        ++records;
+    }
+
+    QString basePath;
+    QString journalPath;
+    QFile file;
+    size_t records;
+};
+
+size_t Journal::Impl::replayJournal(quint64 baseHash, snapshot::ClassPtrVector& classes)
+{
+    const QByteArray bytes = readFile(journalPath);
+    QDataStream s(bytes);
+    s.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint64 hash = 0;
+    s >> magic >> version >> hash;
+    ATT_REQUIRE(s.status() != QDataStream::Ok || magic == MAGIC,
+        "Not a journal file: " << journalPath.toStdString());
+    ATT_REQUIRE(s.status() != QDataStream::Ok || version == VERSION,
+        "Unsupported journal version " << version << " in file: " << journalPath.toStdString());
+    if (s.status() != QDataStream::Ok || hash != baseHash) {
+        return 0;
+    }
+
+    qint64 pos = sizeof(magic) + sizeof(version) + sizeof(hash);
+    size_t count = 0;
+    std::vector<char> payload;
+    while (bytes.size() - pos >= qint64(sizeof(quint32))) {
+        quint32 size = 0;
+        s >> size;
+        if (bytes.size() - pos - qint64(sizeof(size)) < qint64(size)) {
+            break;
+        }
+        payload.resize(size);
+        s.readRawData(payload.data(), size);
+        const QByteArray recordBytes = QByteArray::fromRawData(payload.data(), size);
+        QDataStream record(recordBytes);
+        record.setVersion(QDataStream::Qt_5_0);
+        SnapshotReader in(record);
+        replay(in, classes);
+        pos += sizeof(size) + size;
+        ++count;
+    }
+    if (pos < bytes.size()) {
+        ATT_REQUIRE(QFile::resize(journalPath, pos),
+            "Could not drop incomplete record of journal " << journalPath.toStdString());
+    }
+    return count;
+}
+
+
+Journal::Journal(const QString& basePath, const QString& journalPath)
+    : impl_(new Impl(basePath, journalPath))
+{}
+
+Journal::~Journal()
+{}
+
+snapshot::ClassPtrVector Journal::load()
+{
+    // base replacement could be interrupted before renaming
+    if (QFile::exists(impl_->basePath)) {
+        QFile::remove(impl_->newBasePath());
+    } else if (QFile::exists(impl_->newBasePath())) {
+        ATT_REQUIRE(QFile::rename(impl_->newBasePath(), impl_->basePath),
+            "Could not restore base " << impl_->basePath.toStdString());
+    }
+
+    impl_->file.close();
+    impl_->records = 0;
+    if (!QFile::exists(impl_->basePath)) {
+        return {};
+    }
+
+    auto classes = snapshot::read(impl_->basePath);
+    const quint64 baseHash = contentHash(readFile(impl_->basePath));
+
+    size_t records = 0;
+    if (QFile::exists(impl_->journalPath)) {
+        records = impl_->replayJournal(baseHash, classes);
+    }
+    if (records) {
+        ATT_REQUIRE(impl_->file.open(QIODevice::WriteOnly | QIODevice::Append),
+            "Could not open journal " << impl_->journalPath.toStdString());
+        impl_->records = records;
+    } else {
+        impl_->start(baseHash);
+    }
+    return classes;
+}
+
+void Journal::compact(const std::vector<const Class*>& classes)
+{
+    const QString newBase = impl_->newBasePath();
+    snapshot::write(classes, newBase);
+    QFile::remove(impl_->basePath);
+    ATT_REQUIRE(QFile::rename(newBase, impl_->basePath),
+        "Could not replace base " << impl_->basePath.toStdString());
+    // journal of previous base is discarded on loading if this is interrupted
+    impl_->start(contentHash(readFile(impl_->basePath)));
+}
+
+size_t Journal::recordsCount() const { return impl_->records; }
+
+void Journal::classChanged(size_t cls, const Class& c)
+{
+    impl_->append(RecordType::Class, cls, [&c] (SnapshotWriter& out) {
+        out.stream() << c.classId();
+        out.write(c.graduationYear());
+        out.write(c.issueDate());
+    });
+}
+
+void Journal::studentChanged(size_t cls, Class::Index at, const Student& s, student::Field field)
+{
+    impl_->append(RecordType::StudentField, cls, [&] (SnapshotWriter& out) {
+        out.stream() << quint32(at);
+        writeField(out, s, field);
+    });
+}
+
+void Journal::gradesChanged(
+    size_t cls, Class::Index at, const Class& c, const SubjectsGrades::Diff& diff)
+{
+    std::vector<std::pair<quint32, const SubjectsGrades::Diff::mapped_type*>> changes;
+    for (const auto& d : diff) {
+        auto index = subjectIndex(c, d.first);
+        if (index) {
+            changes.emplace_back(*index, &d.second);
+        }
+    }
+    if (changes.empty()) {
+        return;
+    }
+    impl_->append(RecordType::Grades, cls, [&] (SnapshotWriter& out) {
+        out.stream() << quint32(at) << quint32(changes.size());
+        for (const auto& change : changes) {
+            out.stream() << change.first;
+            out.write(change.second->first);
+            out.write(change.second->second);
+        }
+    });
+}
+
+void Journal::planChanged(size_t cls, const SubjectsPlan::Diff& diff)
+{
+    impl_->append(RecordType::Plan, cls, [&diff] (SnapshotWriter& out) {
+        QDataStream& s = out.stream();
+        s << quint32(diff.size());
+        for (const auto& d : diff) {
+            const auto& from = d.second.first;
+            const auto& to = d.second.second;
+            s << bool(from);
+            if (from) {
+                s << quint32(*from);
+            } else {
+                s << d.first->name() << d.first->shortenedName();
+            }
+            out.write(to ? boost::optional<quint32>(*to) : boost::optional<quint32>());
+        }
+    });
+}
+
+void Journal::studentInserted(size_t cls, Class::Index at, const Class& c)
+{
+    const Student& student = c.student(at);
+    impl_->append(RecordType::StudentInserted, cls, [&] (SnapshotWriter& out) {
+        out.stream() << quint32(at);
+        for (auto field : ALL_FIELDS) {
+            writeField(out, student, field);
+        }
+        std::vector<std::pair<quint32, grades::Value>> values;
+        const auto& plan = c.subjectsPlan();
+        for (size_t i = 0; plan && i < plan->subjectsCount(); ++i) {
+            auto value = student.grades().value(plan->at(i).id());
+            if (value) {
+                values.emplace_back(quint32(i), *value);
+            }
+        }
+        out.stream() << quint32(values.size());
+        for (const auto& v : values) {
+            out.stream() << v.first << v.second;
+        }
+    });
+}
+
+void Journal::studentErased(size_t cls, Class::Index at)
+{
+    impl_->append(RecordType::StudentErased, cls, [at] (SnapshotWriter& out) {
+        out.stream() << quint32(at);
+    });
+}
+
+} // namespace journal
+} // namespace attestate
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+namespace attestate {
+namespace parallel {
+
+// requested 0 means hardware threads count,
+// result is at least 1 and not greater than tasks count
+inline size_t workersCount(size_t requested, size_t tasks)
+{
+    size_t workers = requested;
+    if (!workers) {
+        workers = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    return std::max<size_t>(std::min(workers, tasks), 1);
+}
+
+// Hands out task indexes [0, count) to workers, each index once
+class TaskCounter {
+public:
+    explicit TaskCounter(size_t count)
+        : next_(0)
+        , count_(count)
+    {}
+
+    // false if all tasks are taken
+    bool next(size_t& task)
+    {
+        task = next_.fetch_add(1, std::memory_order_relaxed);
+        return task < count_;
+    }
+
+private:
+    std::atomic<size_t> next_;
+    const size_t count_;
+};
+
+// Runs f(worker) for worker in [0, workers), workers > 0, first one in calling thread,
+// and waits for all of them.
+// First exception thrown by f is rethrown after all workers are finished.
+template <class F>
+void runWorkers(size_t workers, F f)
+{
+    std::vector<std::exception_ptr> errors(workers);
+    auto run = [&f, &errors] (size_t worker)
+    {
+        try {
+            f(worker);
+        } catch (...) {
+            errors[worker] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t w = 1; w < workers; ++w) {
+        threads.emplace_back(run, w);
+    }
+    run(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (const auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+} // namespace parallel
+} // namespace attestate
@@ -0,0 +1,123 @@
+#include "pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <new>
+
+namespace attestate {
+namespace pool {
+
+namespace {
+
+// each block starts with its pool, null for heap blocks
+const size_t HEADER_SIZE = alignof(std::max_align_t) > sizeof(Pool*)
+    ? alignof(std::max_align_t)
+    : sizeof(Pool*);
+
+const size_t CHUNK_SIZE = 64 * 1024;
+// larger blocks go to heap, so that chunks are not left mostly unused
+const size_t MAX_POOLED_SIZE = CHUNK_SIZE / 8;
+
+size_t aligned(size_t size)
+{
+    return (size + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+}
+
+std::atomic<size_t> s_chunksCount(0);
+
+} // namespace
+
+class Pool {
+public:
+    Pool()
+        : refs_(1)
+        , next_(nullptr)
+        , end_(nullptr)
+    {}
+
+    ~Pool()
+    {
+        for (auto chunk : chunks_) {
+            ::operator delete(chunk);
+        }
+        s_chunksCount.fetch_sub(chunks_.size(), std::memory_order_relaxed);
+    }
+
+    // size includes header, holds pool until the block is freed
+    char* take(size_t size)
+    {
+        if (static_cast<size_t>(end_ - next_) < size) {
+            chunks_.push_back(nullptr);
+            next_ = chunks_.back() = static_cast<char*>(::operator new(CHUNK_SIZE));
+            end_ = next_ + CHUNK_SIZE;
+            s_chunksCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        char* block = next_;
+        next_ += size;
+        refs_.fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+
+    void release()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+private:
+    std::atomic<size_t> refs_;
+    std::vector<char*> chunks_;
+    char* next_;
+    char* end_;
+};
+
+namespace {
+
+thread_local Pool* s_scopedPool = nullptr;
+
+} // namespace
+
+ScopedPool::ScopedPool()
+    : pool_(new Pool)
+    , prev_(s_scopedPool)
+{
+    s_scopedPool = pool_;
+}
+
+ScopedPool::~ScopedPool()
+{
+    s_scopedPool = prev_;
+    pool_->release();
+}
+
+void* allocate(size_t size)
+{
+    const size_t blockSize = HEADER_SIZE + aligned(size ? size : 1);
+    Pool* pool = blockSize <= MAX_POOLED_SIZE ? s_scopedPool : nullptr;
+    char* block = pool
+        ? pool->take(blockSize)
+        : static_cast<char*>(::operator new(blockSize));
+    *reinterpret_cast<Pool**>(block) = pool;
+    return block + HEADER_SIZE;
+}
+
+void deallocate(void* p) noexcept
+{
+    if (!p) {
+        return;
+    }
+    char* block = static_cast<char*>(p) - HEADER_SIZE;
+    Pool* pool = *reinterpret_cast<Pool**>(block);
+    if (pool) {
+        pool->release();
+    } else {
+        ::operator delete(block);
+    }
+}
+
+size_t chunksCount() { return s_chunksCount.load(std::memory_order_relaxed); }
+
+} // namespace pool
+} // namespace attestate
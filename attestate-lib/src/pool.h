@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <cstddef>
+
+namespace attestate {
+namespace pool {
+
+// Memory for objects loaded together, e.g. students of one class.
+// Blocks are cut from large chunks by moving a pointer and are not reused,
+// all chunks are released at once when the last block of the pool is freed.
+// So any surviving object keeps memory of the whole load: a student erased
+// from its class and held by undo history, moved to another class, or
+// original data kept after changes pins chunks of the class it was loaded
+// with. This is bounded by size of one loaded class and is accepted since
+// such students are few and are usually freed with their new owner.
+class Pool;
+
+// While alive, pooled objects created in this thread take memory from a new pool,
+// objects created without a scope use the heap.
+class ScopedPool {
+public:
+    ScopedPool();
+    ~ScopedPool();
+
+    ScopedPool(const ScopedPool&) = delete;
+    ScopedPool& operator = (const ScopedPool&) = delete;
+
+private:
+    Pool* pool_;
+    Pool* prev_;
+};
+
+// from pool of innermost scope of calling thread, from heap if there is none
+void* allocate(size_t size);
+// any block of allocate, may be called from any thread
+void deallocate(void* p) noexcept;
+
+// chunks of all pools not released yet, for diagnostics
+size_t chunksCount();
+
+// Base of pooled Impl classes
+struct Pooled {
+    static void* operator new(size_t size) { return allocate(size); }
+    static void operator delete(void* p) noexcept { deallocate(p); }
+};
+
+// for objects and control blocks of pooled shared data
+template <class T>
+struct Allocator {
+    typedef T value_type;
+
+    Allocator() {}
+    template <class U> Allocator(const Allocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(pool::allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t) noexcept { pool::deallocate(p); }
+};
+
+template <class T, class U>
+bool operator == (const Allocator<T>&, const Allocator<U>&) { return true; }
+template <class T, class U>
+bool operator != (const Allocator<T>&, const Allocator<U>&) { return false; }
+
+template <class T, class... Args>
+std::shared_ptr<T> makeShared(Args&&... args)
+{
+    return std::allocate_shared<T>(Allocator<T>(), std::forward<Args>(args)...);
+}
+
+} // namespace pool
+} // namespace attestate
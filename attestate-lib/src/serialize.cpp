@@ -1,6 +1,8 @@
 #include <attestate/serialize.h>
 
 #include "magic_strings.h"
+#include "parallel.h"
+#include "pool.h"
 
 #include <attestate/subjects.h>
 #include <attestate/student.h>
@@ -8,8 +10,13 @@
 
 #include <QFile>
 #include <QTextStream>
+#include <QTextCodec>
+#include <QFileInfo>
+#include <QDir>
 
 #include <map>
+#include <vector>
+#include <algorithm>
 
 namespace attestate {
 
@@ -69,7 +76,8 @@ SubjectsPlanPtr parseHeader(
 Class::StudentPtr parseStudent(
     const QString& line, const Params& params,
     const char* fn, size_t lineNo,
-    const SubjectsPlanPtr& subjectsPlan)
+    const SubjectsPlanPtr& subjectsPlan,
+    const SubjectsLayoutPtr& layout)
 {
     QStringList separated = line.split(params.delimiter);
     ATT_REQUIRE(
@@ -93,9 +101,11 @@ Class::StudentPtr parseStudent(
 
     QStringList::const_iterator markIt = separated.begin();
     std::advance(markIt, minSectionsCount());
-    SubjectsGrades grades;
+    SubjectsGrades grades(layout);
     for (size_t subj = 0; markIt != separated.end(); ++subj, ++markIt) {
-        grades.setValue(subjectsPlan->at(subj).id(), *markIt);
+        if (!markIt->isEmpty()) {
+            grades.setValue(subjectsPlan->at(subj).id(), *markIt);
+        }
     }
 
     return Class::StudentPtr(new Student(
@@ -104,39 +114,109 @@ Class::StudentPtr parseStudent(
         separated.at(sectionPos(tags::NAME)),
         separated.at(sectionPos(tags::PARENTAL_NAME)),
         birthDate,
-        grades,
+        std::move(grades),
         /* graduationYear */ boost::none,
         id,
         issueDate));
 }
 
-} // namespace
+// Fast path parsing, fields refer to decoded file text
 
-std::unique_ptr<Class> read(const QString& filename, const Params& params)
+struct Field {
+    const QChar* data;
+    int size;
+
+    QString copy() const { return QString(data, size); }
+    // shares file text, must not outlive it or be stored
+    QString view() const { return QString::fromRawData(data, size); }
+};
+
+// same as split and trim of every part, fields vector is reused between lines
+void splitFields(
+    const QChar* begin, const QChar* end, QChar delimiter,
+    std::vector<Field>& fields)
+{
+    fields.clear();
+    for (const QChar* p = begin; ; ) {
+        const QChar* e = std::find(p, end, delimiter);
+        const QChar* fb = p;
+        const QChar* fe = e;
+        while (fb != fe && fb->isSpace()) {
+            ++fb;
+        }
+        while (fe != fb && (fe - 1)->isSpace()) {
+            --fe;
+        }
+        fields.push_back({fb, static_cast<int>(fe - fb)});
+        if (e == end) {
+            break;
+        }
+        p = e + 1;
+    }
+}
+
+struct Sections {
+    size_t attestateId;
+    size_t issueDate;
+    size_t familyName;
+    size_t name;
+    size_t parentalName;
+    size_t birthDate;
+};
+
+Class::StudentPtr parseStudent(
+    const std::vector<Field>& fields, const Params& params,
+    const char* fn, size_t lineNo,
+    const Sections& sections,
+    const SubjectsPlan::SubjectIdVector& subjectIds,
+    const SubjectsLayoutPtr& layout)
 {
-    const char* fn = filename.toStdString().c_str();
-    QFile classData(filename);
     ATT_REQUIRE(
-        classData.open(QIODevice::ReadOnly),
-        "Could not open file " << fn);
+        fields.size() == minSectionsCount() + subjectIds.size(),
+        "Columns count mismatch: " << lineNo << " line in csv file: " << fn);
 
-    QTextStream stream(&classData);
+    OptionalDate issueDate = QDate::fromString(
+        fields[sections.issueDate].view(), params.dateFormat);
+    if (!issueDate->isValid()) {
+        issueDate.reset();
+    }
+    QDate birthDate = QDate::fromString(
+        fields[sections.birthDate].view(), params.dateFormat);
 
-    QString line = stream.readLine();
-    ATT_REQUIRE(!line.isNull(), "No header in csv file: " << fn);
+    SubjectsGrades grades(layout);
+    for (size_t subj = 0; subj < subjectIds.size(); ++subj) {
+        const Field& f = fields[minSectionsCount() + subj];
+        if (!f.size) {
+            continue;
+        }
+        const grades::Code code = grades::code(f.view());
+        grades.setValue(
+            subjectIds[subj],
+            code == grades::INVALID_CODE ? f.copy() : grades::value(code));
+    }
 
-    SubjectsPlanPtr subjectsPlan = parseHeader(line, params, fn);
+    return Class::StudentPtr(new Student(
+        ID::gen(),
+        fields[sections.familyName].copy(),
+        fields[sections.name].copy(),
+        fields[sections.parentalName].copy(),
+        birthDate,
+        std::move(grades),
+        /* graduationYear */ boost::none,
+        fields[sections.attestateId].copy(),
+        issueDate));
+}
 
-    std::vector<Class::StudentPtr> students;
+// most frequent students issue date becomes class one
+std::unique_ptr<Class> makeClass(
+    std::vector<Class::StudentPtr> students, const SubjectsPlanPtr& subjectsPlan)
+{
     typedef std::map<QDate, size_t> Dates;
     Dates dates;
-    size_t lineNo = 1;
-    while (!(line = stream.readLine()).isNull()) {
-        students.push_back(parseStudent(line, params, fn, lineNo, subjectsPlan));
-        if (students.back()->issueDate()) {
-            ++dates[*students.back()->issueDate()];
+    for (const auto& sp : students) {
+        if (sp->issueDate()) {
+            ++dates[*sp->issueDate()];
         }
-        ++lineNo;
     }
 
     typedef Dates::value_type Dp;
@@ -165,6 +245,107 @@ std::unique_ptr<Class> read(const QString& filename, const Params& params)
         subjectsPlan));
 }
 
+} // namespace
+
+std::unique_ptr<Class> read(const QString& filename, const Params& params)
+{
+    const std::string fn = filename.toStdString();
+    QFile classData(filename);
+    ATT_REQUIRE(
+        classData.open(QIODevice::ReadOnly),
+        "Could not open file " << fn);
+
+    // decoded once, as QTextStream would do
+    QString text;
+    const qint64 size = classData.size();
+    if (size > 0) {
+        uchar* data = classData.map(0, size);
+        ATT_REQUIRE(data, "Could not map file " << fn);
+        text = QTextCodec::codecForLocale()->toUnicode(
+            reinterpret_cast<const char*>(data), size);
+        classData.unmap(data);
+    }
+    classData.close();
+
+    const QChar* pos = text.constData();
+    const QChar* const end = pos + text.size();
+    // same lines as QTextStream::readLine returns
+    auto nextLine = [&pos, end] (const QChar*& lb, const QChar*& le) -> bool
+    {
+        if (pos == end) {
+            return false;
+        }
+        lb = pos;
+        le = std::find(pos, end, QChar('\n'));
+        pos = le == end ? end : le + 1;
+        if (le != lb && *(le - 1) == QChar('\r')) {
+            --le;
+        }
+        return true;
+    };
+
+    const QChar* lb;
+    const QChar* le;
+    ATT_REQUIRE(nextLine(lb, le), "No header in csv file: " << fn);
+
+    SubjectsPlanPtr subjectsPlan = parseHeader(QString(lb, le - lb), params, fn.c_str());
+    const auto subjectIds = subjectsPlan->subjectIds();
+    // grades of all students share plan order storage
+    const SubjectsLayoutPtr& layout = subjectsPlan->layout();
+
+    const Sections sections{
+        sectionPos(tags::ATTESTATE_ID),
+        sectionPos(tags::ISSUE_DATE),
+        sectionPos(tags::FAMILY_NAME),
+        sectionPos(tags::NAME),
+        sectionPos(tags::PARENTAL_NAME),
+        sectionPos(tags::BIRTH_DATE)
+    };
+
+    pool::ScopedPool studentsPool; // students of class share memory
+    std::vector<Class::StudentPtr> students;
+    std::vector<Field> fields;
+    fields.reserve(minSectionsCount() + subjectIds.size());
+    size_t lineNo = 1;
+    while (nextLine(lb, le)) {
+        splitFields(lb, le, params.delimiter, fields);
+        students.push_back(parseStudent(
+            fields, params, fn.c_str(), lineNo, sections, subjectIds, layout));
+        ++lineNo;
+    }
+
+    return makeClass(std::move(students), subjectsPlan);
+}
+
+std::unique_ptr<Class> readStream(const QString& filename, const Params& params)
+{
+    const std::string fn = filename.toStdString();
+    QFile classData(filename);
+    ATT_REQUIRE(
+        classData.open(QIODevice::ReadOnly),
+        "Could not open file " << fn);
+
+    QTextStream stream(&classData);
+
+    QString line = stream.readLine();
+    ATT_REQUIRE(!line.isNull(), "No header in csv file: " << fn);
+
+    SubjectsPlanPtr subjectsPlan = parseHeader(line, params, fn.c_str());
+    // grades of all students share plan order storage
+    const SubjectsLayoutPtr& layout = subjectsPlan->layout();
+
+    pool::ScopedPool studentsPool; // students of class share memory
+    std::vector<Class::StudentPtr> students;
+    size_t lineNo = 1;
+    while (!(line = stream.readLine()).isNull()) {
+        students.push_back(parseStudent(
+            line, params, fn.c_str(), lineNo, subjectsPlan, layout));
+        ++lineNo;
+    }
+
+    return makeClass(std::move(students), subjectsPlan);
+}
+
 namespace {
 
 void writeHeader(QTextStream& stream, const SubjectsPlanPtr& subjectsPlan,
@@ -217,7 +398,7 @@ void writeStudent(
 
 void write(const Class& cls, const QString& filename, const Params& params)
 {
-    const char* fn = filename.toStdString().c_str();
+    const std::string fn = filename.toStdString();
     QFile classData(filename);
     ATT_REQUIRE(
         classData.open(QIODevice::WriteOnly),
@@ -233,5 +414,71 @@ void write(const Class& cls, const QString& filename, const Params& params)
     classData.close();
 }
 
+FileResults readMany(const QStringList& filenames, const Params& params, size_t workers)
+{
+    FileResults results;
+    results.reserve(filenames.size());
+    for (const auto& f : filenames) {
+        results.push_back(FileResult{f, nullptr, {}});
+    }
+
+    // ids are reserved in filenames order before reading, so they do not
+    // depend on workers; a file takes at most one id per byte (a student
+    // per line, a subject per header field) and ids of its class and plan
+    std::vector<IDBlock> idBlocks(results.size());
+    // largest files are started first, so that they do not finish last
+    std::vector<std::pair<qint64, size_t>> order; // size, index
+    order.reserve(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const qint64 size = QFileInfo(results[i].filename).size();
+        try {
+            idBlocks[i] = ID::reserve(size_t(std::max<qint64>(size, 0)) + 2);
+        } catch (const std::exception& ex) {
+            results[i].error = ex.what();
+        }
+        order.emplace_back(size, i);
+    }
+    std::stable_sort(
+        order.begin(), order.end(),
+        [] (const std::pair<qint64, size_t>& l, const std::pair<qint64, size_t>& r)
+        { return l.first > r.first; });
+
+    parallel::TaskCounter tasks(order.size());
+    parallel::runWorkers(
+        parallel::workersCount(workers, order.size()),
+        [&] (size_t /* worker */)
+        {
+            size_t task;
+            while (tasks.next(task)) {
+                auto& res = results[order[task].second];
+                if (!res.error.empty()) {
+                    continue;
+                }
+                ScopedIDBlock ids(idBlocks[order[task].second]);
+                try {
+                    res.cls = read(res.filename, params);
+                } catch (const std::exception& ex) {
+                    res.error = ex.what();
+                }
+            }
+        });
+
+    return results;
+}
+
+FileResults readDir(const QString& dirname, const Params& params, size_t workers)
+{
+    QDir dir(dirname);
+    ATT_REQUIRE(dir.exists(), "Directory does not exist: " << dirname.toStdString());
+
+    QStringList filenames;
+    for (const auto& name :
+        dir.entryList(QStringList{"*.csv"}, QDir::Files | QDir::Readable, QDir::Name))
+    {
+        filenames.push_back(dir.filePath(name));
+    }
+    return readMany(filenames, params, workers);
+}
+
 } // namespace csv
 } // namespace attestate
@@ -0,0 +1,77 @@
+#include <attestate/snapshot.h>
+
+#include "snapshot_io.h"
+
+#include <attestate/exception.h>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+
+namespace attestate {
+namespace snapshot {
+
+namespace {
+
+const quint32 MAGIC = 0x41545453; // "ATTS"
+const quint16 VERSION = 1;
+
+} // namespace
+
+void write(const std::vector<const Class*>& classes, const QString& filename)
+{
+    const std::string fn = filename.toStdString();
+    QFile file(filename);
+    ATT_REQUIRE(
+        file.open(QIODevice::WriteOnly | QIODevice::Truncate),
+        "Could not open snapshot file for writing: " << fn);
+
+    QDataStream s(&file);
+    s.setVersion(QDataStream::Qt_5_0);
+    s << MAGIC << VERSION << quint32(classes.size());
+
+    SnapshotWriter out(s);
+    for (const auto* c : classes) {
+        ATT_ASSERT(c);
+        c->write(out);
+    }
+    ATT_REQUIRE(s.status() == QDataStream::Ok, "Could not write snapshot file: " << fn);
+}
+
+ClassPtrVector read(const QString& filename)
+{
+    const std::string fn = filename.toStdString();
+    QFile file(filename);
+    ATT_REQUIRE(file.open(QIODevice::ReadOnly), "Could not open snapshot file: " << fn);
+
+    const qint64 size = file.size();
+    const uchar* data = size ? file.map(0, size) : nullptr;
+    ATT_REQUIRE(data || !size, "Could not map snapshot file: " << fn);
+    const QByteArray bytes = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(data), static_cast<int>(size));
+
+    QDataStream s(bytes);
+    s.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    s >> magic >> version >> count;
+    ATT_REQUIRE(
+        s.status() == QDataStream::Ok && magic == MAGIC,
+        "Not a snapshot file: " << fn);
+    ATT_REQUIRE(
+        version == VERSION,
+        "Unsupported snapshot version " << version << " in file: " << fn);
+
+    ClassPtrVector classes;
+    SnapshotReader in(s);
+    for (quint32 i = 0; i < count; ++i) {
+        classes.emplace_back(new Class(Class::read(in)));
+    }
+    in.check();
+    ATT_REQUIRE(s.atEnd(), "Unexpected data at the end of snapshot file: " << fn);
+    return classes;
+}
+
+} // namespace snapshot
+} // namespace attestate
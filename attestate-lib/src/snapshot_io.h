@@ -0,0 +1,141 @@
+#pragma once
+
+#include <attestate/common.h>
+#include <attestate/exception.h>
+
+#include <QDataStream>
+#include <QDate>
+#include <QString>
+
+#include <boost/optional.hpp>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace attestate {
+
+// Binary snapshot streams, see attestate/snapshot.h.
+// Objects shared by pointer (subjects, plans, grades layouts) are written
+// once, next occurrences refer to them by index.
+
+namespace snapshot {
+
+const quint32 NULL_REF = 0xFFFFFFFF;
+
+} // namespace snapshot
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(QDataStream& out) : out_(out) {}
+
+    QDataStream& stream() { return out_; }
+
+    void write(const ID& id)
+    {
+        out_ << quint32(id.oid()) << quint32(id.dbid());
+    }
+
+    template <class T>
+    void write(const boost::optional<T>& value)
+    {
+        out_ << bool(value);
+        if (value) {
+            out_ << *value;
+        }
+    }
+
+    // writeObject(const T&) is called on first occurrence only
+    template <class T, class F>
+    void writeRef(const std::shared_ptr<T>& ptr, F writeObject)
+    {
+        if (!ptr) {
+            out_ << snapshot::NULL_REF;
+            return;
+        }
+        auto res = refs_.insert({ptr.get(), quint32(refs_.size())});
+        out_ << res.first->second;
+        if (res.second) {
+            writeObject(*ptr);
+        }
+    }
+
+private:
+    QDataStream& out_;
+    std::map<const void*, quint32> refs_;
+};
+
+
+// Object ids are reassigned on reading, so snapshot objects never clash
+// with objects of current session, database ids are kept.
+class SnapshotReader {
+public:
+    explicit SnapshotReader(QDataStream& in) : in_(in) {}
+
+    QDataStream& stream() { return in_; }
+
+    ID readID()
+    {
+        quint32 oid = 0;
+        quint32 dbid = 0;
+        in_ >> oid >> dbid;
+        if (!oid) {
+            return ID(dbid);
+        }
+        auto it = ids_.find(oid);
+        if (it == ids_.end()) {
+            it = ids_.emplace(oid, ID::setDBID(ID::gen(), dbid)).first;
+        }
+        return it->second;
+    }
+
+    template <class T>
+    boost::optional<T> readOptional()
+    {
+        bool has = false;
+        in_ >> has;
+        if (!has) {
+            return boost::none;
+        }
+        T value;
+        in_ >> value;
+        return value;
+    }
+
+    // readObject() returns std::shared_ptr<T>, called on first occurrence only
+    template <class T, class F>
+    std::shared_ptr<T> readRef(F readObject)
+    {
+        quint32 ref = snapshot::NULL_REF;
+        in_ >> ref;
+        check();
+        if (ref == snapshot::NULL_REF) {
+            return nullptr;
+        }
+        if (ref < refs_.size()) {
+            auto ptr = std::static_pointer_cast<T>(refs_[ref]);
+            ATT_REQUIRE(ptr, "Snapshot object " << ref << " is referenced before it is read");
+            return ptr;
+        }
+        ATT_REQUIRE(ref == refs_.size(), "Unexpected snapshot object reference " << ref);
+        // nested objects are numbered after this one
+        refs_.push_back(nullptr);
+        std::shared_ptr<T> ptr = readObject();
+        refs_[ref] = ptr;
+        return ptr;
+    }
+
+    // throws if data is truncated or corrupted
+    void check() const
+    {
+        ATT_REQUIRE(in_.status() == QDataStream::Ok, "Snapshot data is corrupted");
+    }
+
+private:
+    QDataStream& in_;
+    std::unordered_map<OID, ID> ids_;
+    std::vector<std::shared_ptr<void>> refs_;
+};
+
+} // namespace attestate
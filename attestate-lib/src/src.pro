@@ -1,12 +1,14 @@
 include(../defaults.pri)
 
-#QT       += sql
+QT       += sql
 
 TARGET = attestate
 TEMPLATE = lib
 
 DEFINES += ATTESTATELIB_LIBRARY
 
+CONFIG += thread
+
 SOURCES += \
     class.cpp \
     subjects.cpp \
@@ -15,7 +17,13 @@ SOURCES += \
     grades.cpp \
     serialize.cpp \
     generate.cpp \
-    validate.cpp
+    validate.cpp \
+    class_table.cpp \
+    snapshot.cpp \
+    db.cpp \
+    journal.cpp \
+    undo.cpp \
+    pool.cpp
 
 HEADERS += \
     include/attestate/class.h \
@@ -27,10 +35,19 @@ HEADERS += \
     include/attestate/serialize.h \
     include/attestate/generate.h \
     include/attestate/validate.h \
+    include/attestate/class_table.h \
+    include/attestate/snapshot.h \
+    include/attestate/db.h \
+    include/attestate/journal.h \
+    include/attestate/undo.h \
     diff.h \
     magic_strings.h \
     helpers.h \
-    unique_vector.h
+    unique_vector.h \
+    unique_tree.h \
+    parallel.h \
+    pool.h \
+    snapshot_io.h
 
 OTHER_FILES += \
     todo.txt
@@ -1,6 +1,8 @@
 #include <attestate/student.h>
 
 #include "helpers.h"
+#include "pool.h"
+#include "snapshot_io.h"
 
 #include <attestate/grades.h>
 #include <attestate/exception.h>
@@ -11,56 +13,62 @@ namespace attestate {
 
 namespace {
 
+// grades keep their own original values and are not shared
 struct Data {
     DataString familyName;
     DataString name;
     DataString parentalName;
     QDate birthDate;
-    SubjectsGrades grades;
     OptionalYear graduationYear;
     AttestateId attestateId;
     OptionalDate issueDate;
 };
 
-struct IsModified {
-    explicit IsModified(bool val)
-        : familyName(val)
-        , name(val)
-        , parentalName(val)
-        , birthDate(val)
-        , graduationYear(val)
-        , attestateId(val)
-        , issueDate(val)
-    {}
+// original and current data are shared until first change after save
+typedef std::shared_ptr<Data> DataPtr;
 
-    bool operator () () const
-    {
-        return familyName || name || parentalName ||
-            birthDate || graduationYear ||
-            attestateId || issueDate;
+// grades are written after birth date, none for original data
+void writeData(SnapshotWriter& out, const Data& data, const SubjectsGrades* grades)
+{
+    out.stream() << data.familyName << data.name << data.parentalName << data.birthDate;
+    if (grades) {
+        grades->write(out);
     }
+    out.write(data.graduationYear);
+    out.stream() << data.attestateId;
+    out.write(data.issueDate);
+}
 
-    bool familyName;
-    bool name;
-    bool parentalName;
-    bool birthDate;
-    bool graduationYear;
-    bool attestateId;
-    bool issueDate;
-};
-
-typedef std::unique_ptr<Data> DataPtr;
+// reads grades if given
+DataPtr readData(SnapshotReader& in, boost::optional<SubjectsGrades>* grades)
+{
+    QDataStream& s = in.stream();
+    DataString familyName, name, parentalName;
+    QDate birthDate;
+    s >> familyName >> name >> parentalName >> birthDate;
+    in.check();
+    if (grades) {
+        grades->emplace(SubjectsGrades::read(in));
+    }
+    OptionalYear graduationYear = in.readOptional<Year>();
+    AttestateId attestateId;
+    s >> attestateId;
+    OptionalDate issueDate = in.readOptional<QDate>();
+    in.check();
+    return pool::makeShared<Data>(Data{familyName, name, parentalName, birthDate,
+        graduationYear, attestateId, issueDate});
+}
 
 } // namespace
 
-class Student::Impl {
+class Student::Impl : public pool::Pooled {
 public:
     explicit Impl(const ID& id)
         : id(id)
-        , data(new Data{"", "", "", QDate(), std::move(SubjectsGrades()), boost::none, "", nullptr})
+        , data(pool::makeShared<Data>(Data{"", "", "", QDate(), boost::none, "", boost::none}))
         , originalData(nullptr)
         , isDeleted(false)
-        , isModified_(true)
+        , modified_(student::ALL_FIELDS)
     {}
 
     Impl(
@@ -69,81 +77,134 @@ public:
             const DataString& name,
             const DataString& pName,
             const QDate& birthDate = {},
-            const SubjectsGrades& grades = {},
+            SubjectsGrades grades = {},
             OptionalYear graduationYear = boost::none,
             const AttestateId& attestateId = {},
             const OptionalDate& issueDate = boost::none)
         : id(id)
-        , data(new Data{fName, name, pName, birthDate, grades, graduationYear,
-            attestateId, issueDate})
-        , originalData(new Data(*data))
+        , data(pool::makeShared<Data>(Data{fName, name, pName, birthDate, graduationYear,
+            attestateId, issueDate}))
+        , originalData(data)
+        , grades(std::move(grades))
         , isDeleted(false)
-        , isModified_(false)
+        , modified_(0)
+    {
+        this->grades.save();
+    }
+
+    // read from snapshot, keeps modifications of grades
+    Impl(const ID& id, DataPtr data, SubjectsGrades&& grades)
+        : id(id)
+        , data(std::move(data))
+        , originalData(nullptr)
+        , grades(std::move(grades))
+        , isDeleted(false)
+        , modified_(student::ALL_FIELDS)
     {}
 
+    // data to change, copied if shared with original
+    Data& mutableData()
+    {
+        if (data == originalData) {
+            data = pool::makeShared<Data>(*originalData);
+        }
+        return *data;
+    }
+
     void calcModifiedFamilyName()
     {
-        isModified_.familyName = !originalData ||
-            data->familyName != originalData->familyName;
+        setModified(student::Field::FamilyName, !originalData ||
+            data->familyName != originalData->familyName);
     }
 
     void calcModifiedName()
     {
-        isModified_.name = !originalData ||
-            data->name != originalData->name;
+        setModified(student::Field::Name, !originalData ||
+            data->name != originalData->name);
     }
 
     void calcModifiedParentalName()
     {
-        isModified_.parentalName = !originalData ||
-            data->parentalName != originalData->parentalName;
+        setModified(student::Field::ParentalName, !originalData ||
+            data->parentalName != originalData->parentalName);
     }
 
     void calcModifiedBirthDate()
     {
-        isModified_.birthDate = !originalData ||
-            data->birthDate != originalData->birthDate;
+        setModified(student::Field::BirthDate, !originalData ||
+            data->birthDate != originalData->birthDate);
     }
 
     void calcModifiedGraduationYear()
     {
-        isModified_.graduationYear = !originalData ||
-            data->graduationYear != originalData->graduationYear;
+        setModified(student::Field::GraduationYear, !originalData ||
+            data->graduationYear != originalData->graduationYear);
     }
 
     void calcModifiedAttestateId()
     {
-        isModified_.attestateId = !originalData ||
-            data->attestateId != originalData->attestateId;
+        setModified(student::Field::AttestateId, !originalData ||
+            data->attestateId != originalData->attestateId);
     }
 
     void calcModifiedIssueDate()
     {
-        isModified_.issueDate = !originalData ||
-            data->issueDate != originalData->issueDate;
+        setModified(student::Field::IssueDate, !originalData ||
+            data->issueDate != originalData->issueDate);
     }
 
     bool areGradesModified() const
     {
-        return !originalData || !data->grades.diff(originalData->grades).empty();
+        return !originalData || grades.isModified();
+    }
+
+    bool isGradeModified(const ID& subjectId) const
+    {
+        return !originalData || grades.isModified(subjectId);
     }
 
-    const IsModified& isModified() const { return isModified_; }
+    student::FieldMask modified() const { return modified_; }
+
+    bool isModified(student::Field field) const
+    {
+        return modified_ & student::fieldBit(field);
+    }
 
     bool isModifiedState() const
     {
-        return isModified_() || areGradesModified();
+        return modified_ || areGradesModified();
     }
 
-    void resetModified() { isModified_ = IsModified(originalData ? false : true); }
+    void resetModified() { modified_ = originalData ? 0 : student::ALL_FIELDS; }
+
+    void calcModified()
+    {
+        calcModifiedFamilyName();
+        calcModifiedName();
+        calcModifiedParentalName();
+        calcModifiedBirthDate();
+        calcModifiedGraduationYear();
+        calcModifiedAttestateId();
+        calcModifiedIssueDate();
+    }
 
     ID id;
     DataPtr data;
     DataPtr originalData;
+    SubjectsGrades grades;
     bool isDeleted;
 
 private:
-    IsModified isModified_;
+    void setModified(student::Field field, bool isModified)
+    {
+        if (isModified) {
+            modified_ |= student::fieldBit(field);
+        } else {
+            modified_ &= ~student::fieldBit(field);
+        }
+    }
+
+    student::FieldMask modified_;
 };
 
 
@@ -159,20 +220,27 @@ Student::Student(
         const DataString& name,
         const DataString& pName,
         const QDate& birthDate,
-        const SubjectsGrades& grades,
+        SubjectsGrades grades,
         OptionalYear graduationYear,
         const AttestateId& attestateId,
         const OptionalDate& issueDate)
-    : impl_(new Impl(id, fName, name, pName, birthDate, grades, graduationYear,
+    : impl_(new Impl(id, fName, name, pName, birthDate, std::move(grades), graduationYear,
         attestateId, issueDate))
 {}
 
+Student::Student(Impl* impl)
+    : impl_(impl)
+{}
+
 Student::Student(Student&&) = default;
 Student& Student::operator = (Student&&) = default;
 
 Student::~Student()
 {}
 
+void* Student::operator new(size_t size) { return pool::allocate(size); }
+void Student::operator delete(void* p) noexcept { pool::deallocate(p); }
+
 const ID& Student::id() const { return impl_->id; }
 
 void Student::setDBID(const DBID& dbid)
@@ -202,44 +270,56 @@ const DataString& Student::familyName() const { return impl_->data->familyName;
 
 void Student::setFamilyName(const DataString& familyName)
 {
-    impl_->data->familyName = familyName;
+    if (familyName == impl_->data->familyName) {
+        return;
+    }
+    impl_->mutableData().familyName = familyName;
     impl_->calcModifiedFamilyName();
 }
 
-bool Student::isFamilyNameModified() const { return impl_->isModified().familyName; }
+bool Student::isFamilyNameModified() const { return impl_->isModified(student::Field::FamilyName); }
 
 
 const DataString& Student::name() const { return impl_->data->name; }
 
 void Student::setName(const DataString& name)
 {
-    impl_->data->name = name;
+    if (name == impl_->data->name) {
+        return;
+    }
+    impl_->mutableData().name = name;
     impl_->calcModifiedName();
 }
 
-bool Student::isNameModified() const { return impl_->isModified().name; }
+bool Student::isNameModified() const { return impl_->isModified(student::Field::Name); }
 
 
 const DataString& Student::parentalName() const { return impl_->data->parentalName; }
 
 void Student::setParentalName(const DataString& parentalName)
 {
-    impl_->data->parentalName = parentalName;
+    if (parentalName == impl_->data->parentalName) {
+        return;
+    }
+    impl_->mutableData().parentalName = parentalName;
     impl_->calcModifiedParentalName();
 }
 
-bool Student::isParentalNameModified() const { return impl_->isModified().parentalName; }
+bool Student::isParentalNameModified() const { return impl_->isModified(student::Field::ParentalName); }
 
 
 const QDate& Student::birthDate() const { return impl_->data->birthDate; }
 
 void Student::setBirthDate(const QDate& birthDate)
 {
-    impl_->data->birthDate = birthDate;
+    if (birthDate == impl_->data->birthDate) {
+        return;
+    }
+    impl_->mutableData().birthDate = birthDate;
     impl_->calcModifiedBirthDate();
 }
 
-bool Student::isBirthDateModified() const { return impl_->isModified().birthDate; }
+bool Student::isBirthDateModified() const { return impl_->isModified(student::Field::BirthDate); }
 
 bool Student::isPersonalInfoModified() const
 {
@@ -251,15 +331,20 @@ bool Student::isPersonalInfoModified() const
 
 // subject grades
 
-const SubjectsGrades& Student::grades() const { return impl_->data->grades; }
+const SubjectsGrades& Student::grades() const { return impl_->grades; }
 
-SubjectsGrades& Student::grades() { return impl_->data->grades; }
+SubjectsGrades& Student::grades() { return impl_->grades; }
 
 bool Student::areGradesModified() const
 {
     return impl_->areGradesModified();
 }
 
+bool Student::isGradeModified(const ID& subjectId) const
+{
+    return impl_->isGradeModified(subjectId);
+}
+
 // graduation year
 
 OptionalYear Student::graduationYear() const
@@ -269,13 +354,16 @@ OptionalYear Student::graduationYear() const
 
 void Student::setGraduationYear(OptionalYear graduationYear)
 {
-    impl_->data->graduationYear = graduationYear;
+    if (graduationYear == impl_->data->graduationYear) {
+        return;
+    }
+    impl_->mutableData().graduationYear = graduationYear;
     impl_->calcModifiedGraduationYear();
 }
 
 bool Student::isGraduationYearModified() const
 {
-    return impl_->isModified().graduationYear;
+    return impl_->isModified(student::Field::GraduationYear);
 }
 
 
@@ -285,11 +373,14 @@ const AttestateId& Student::attestateId() const { return impl_->data->attestateI
 
 void Student::setAttestateId(const AttestateId& attestateId)
 {
-    impl_->data->attestateId = attestateId;
+    if (attestateId == impl_->data->attestateId) {
+        return;
+    }
+    impl_->mutableData().attestateId = attestateId;
     impl_->calcModifiedAttestateId();
 }
 
-bool Student::isAttestateIdModified() const {return impl_->isModified().attestateId; }
+bool Student::isAttestateIdModified() const {return impl_->isModified(student::Field::AttestateId); }
 
 const OptionalDate& Student::issueDate() const
 {
@@ -298,20 +389,63 @@ const OptionalDate& Student::issueDate() const
 
 void Student::setIssueDate(const OptionalDate& issueDate)
 {
-    impl_->data->issueDate = issueDate;
+    if (issueDate == impl_->data->issueDate) {
+        return;
+    }
+    impl_->mutableData().issueDate = issueDate;
     impl_->calcModifiedIssueDate();
 }
 
-bool Student::isIssueDateModified() const { return impl_->isModified().issueDate; }
+bool Student::isIssueDateModified() const { return impl_->isModified(student::Field::IssueDate); }
 
 bool Student::isModified() const { return state() == State::Modified; }
 
+student::FieldMask Student::modifiedFields() const { return impl_->modified(); }
+
+bool Student::isFieldModified(student::Field field) const { return impl_->isModified(field); }
+
 void Student::save()
 {
     ATT_REQUIRE(!impl_->isDeleted, "Cannot save deleted student, id " << impl_->id);
-    impl_->originalData.reset(new Data(*impl_->data));
+    impl_->grades.save();
+    impl_->originalData = impl_->data;
     impl_->resetModified();
 }
 
+void Student::write(SnapshotWriter& out) const
+{
+    out.write(impl_->id);
+    out.stream() << impl_->isDeleted;
+    writeData(out, *impl_->data, &impl_->grades);
+    out.stream() << bool(impl_->originalData);
+    if (impl_->originalData) {
+        writeData(out, *impl_->originalData, nullptr);
+    }
+}
+
+Student Student::read(SnapshotReader& in)
+{
+    const ID id = in.readID();
+    bool isDeleted = false;
+    bool hasOriginal = false;
+    in.stream() >> isDeleted;
+    boost::optional<SubjectsGrades> grades;
+    DataPtr data = readData(in, &grades);
+    in.stream() >> hasOriginal;
+    in.check();
+
+    Student res(new Impl(id, std::move(data), std::move(*grades)));
+    Impl& impl = *res.impl_;
+    impl.isDeleted = isDeleted;
+    if (hasOriginal) {
+        impl.originalData = readData(in, nullptr);
+        impl.calcModified();
+        if (!impl.modified()) {
+            impl.originalData = impl.data;
+        }
+    }
+    return res;
+}
+
 } // namespace attestate
 
@@ -1,7 +1,8 @@
 #include "include/attestate/subjects.h"
 
-#include "unique_vector.h"
+#include "unique_tree.h"
 #include "diff.h"
+#include "snapshot_io.h"
 
 #include <vector>
 #include <algorithm>
@@ -17,7 +18,8 @@ struct SubjectData {
     DataString shortenedName;
 };
 
-typedef std::unique_ptr<SubjectData> SubjectDataPtr;
+// original and current data are shared until first change after save
+typedef std::shared_ptr<SubjectData> SubjectDataPtr;
 
 } // namespace
 
@@ -36,12 +38,21 @@ public:
             const DataString& name,
             const DataString& shortenedName)
         : id(id)
-        , data(new SubjectData{name, shortenedName})
-        , originalData (new SubjectData(*data))
+        , data(std::make_shared<SubjectData>(SubjectData{name, shortenedName}))
+        , originalData(data)
         , isModified(false)
         , isDeleted(false)
     {}
 
+    // data to change, copied if shared with original
+    SubjectData& mutableData()
+    {
+        if (data == originalData) {
+            data = std::make_shared<SubjectData>(*originalData);
+        }
+        return *data;
+    }
+
     ID id;
     SubjectDataPtr data;
     SubjectDataPtr originalData;
@@ -111,7 +122,7 @@ const DataString& Subject::name() const { return impl_->data->name; }
 void Subject::setName(const DataString& name)
 {
     if (name != impl_->data->name) {
-        impl_->data->name = name;
+        impl_->mutableData().name = name;
         impl_->isModified.name =
             !impl_->originalData || name != impl_->originalData->name;
     }
@@ -128,7 +139,7 @@ Subject::shortenedName() const { return impl_->data->shortenedName; }
 void Subject::setShortenedName(const DataString& name)
 {
     if (name != impl_->data->shortenedName) {
-        impl_->data->shortenedName = name;
+        impl_->mutableData().shortenedName = name;
         impl_->isModified.shortenedName =
             !impl_->originalData || name != impl_->originalData->shortenedName;
     }
@@ -142,10 +153,42 @@ bool Subject::isShortenedNameModified() const
 void Subject::save()
 {
     ATT_REQUIRE(!impl_->isDeleted, "Cannot save deleted subject, id " << impl_->id);
-    impl_->originalData.reset(new SubjectData(*impl_->data));
+    impl_->originalData = impl_->data;
     impl_->isModified.reset(false);
 }
 
+void Subject::write(SnapshotWriter& out) const
+{
+    QDataStream& s = out.stream();
+    out.write(impl_->id);
+    s << impl_->isDeleted << impl_->data->name << impl_->data->shortenedName;
+    s << bool(impl_->originalData);
+    if (impl_->originalData) {
+        s << impl_->originalData->name << impl_->originalData->shortenedName;
+    }
+}
+
+Subject Subject::read(SnapshotReader& in)
+{
+    QDataStream& s = in.stream();
+    Subject res(in.readID());
+    Impl& impl = *res.impl_;
+    bool hasOriginal = false;
+    s >> impl.isDeleted >> impl.data->name >> impl.data->shortenedName >> hasOriginal;
+    if (hasOriginal) {
+        impl.originalData = std::make_shared<SubjectData>();
+        s >> impl.originalData->name >> impl.originalData->shortenedName;
+        impl.isModified.name = impl.data->name != impl.originalData->name;
+        impl.isModified.shortenedName =
+            impl.data->shortenedName != impl.originalData->shortenedName;
+        if (!impl.isModified()) {
+            impl.originalData = impl.data;
+        }
+    }
+    in.check();
+    return res;
+}
+
 
 // SubjectsPlan
 
@@ -171,14 +214,15 @@ std::ostream& operator << (std::ostream& os, const SubjectID& k)
     return os;
 }
 
-typedef UniqueVector<SubjectPtr, SubjectID> SubjectsVector;
+typedef UniqueTree<SubjectPtr, SubjectID> SubjectsVector;
 
 struct SubjectsPlanData {
     DataString name;
     SubjectsVector subjects;
 };
 
-typedef std::unique_ptr<SubjectsPlanData> SubjectsPlanDataPtr;
+// original and current data are shared until first change after save
+typedef std::shared_ptr<SubjectsPlanData> SubjectsPlanDataPtr;
 
 
 typedef attestate::Diff<
@@ -190,10 +234,8 @@ DiffT;
 DiffT::ValuesType buildValues(const SubjectsVector& vec)
 {
     DiffT::ValuesType v;
-    const auto size = vec.size();
-    for (size_t i = 0; i < size; ++i) {
-        v[vec.at(i)] = i;
-    }
+    SubjectsPlan::Index i = 0;
+    vec.forEach([&v, &i] (const SubjectPtr& s) { v[s] = i++; });
     return v;
 }
 
@@ -208,8 +250,9 @@ class SubjectsPlan::Impl {
 public:
     explicit Impl(const ID& id)
         : id(id)
-        , data(new SubjectsPlanData{"", {}})
+        , data(std::make_shared<SubjectsPlanData>(SubjectsPlanData{"", {}}))
         , originalData(nullptr)
+        , layout(std::make_shared<SubjectsLayout>(std::vector<ID>()))
         , isNameModified(true)
         , isDeleted(false)
     {}
@@ -219,29 +262,51 @@ public:
             const DataString& name,
             SubjectPtrVector subjects)
         : id(id)
-        , data(new SubjectsPlanData{name, {}})
-        , originalData(new SubjectsPlanData(*data))
+        , data(nullptr)
+        , originalData(nullptr)
+        , layout(nullptr)
         , isNameModified(false)
         , isDeleted(false)
     {
+        std::vector<ID> ids;
+        ids.reserve(subjects.size());
         for (const auto& s : subjects) {
             ATT_ASSERT(s);
+            ids.push_back(s->id());
         }
-        data->subjects = SubjectsVector(std::move(subjects));
-        originalData->subjects = data->subjects;
+        data = std::make_shared<SubjectsPlanData>(
+            SubjectsPlanData{name, SubjectsVector(std::move(subjects))});
+        originalData = data;
+        layout = std::make_shared<SubjectsLayout>(ids);
+    }
+
+    // data to change, copied if shared with original
+    SubjectsPlanData& mutableData()
+    {
+        if (data == originalData) {
+            data = std::make_shared<SubjectsPlanData>(*originalData);
+        }
+        return *data;
     }
 
     bool areSubjectsModified() const
     {
-        return !originalData ||
-            !buildDiff(data->subjects, originalData->subjects).empty();
+        return !originalData || (data != originalData &&
+            !buildDiff(data->subjects, originalData->subjects).empty());
     }
 
     bool isModified() const { return isNameModified || areSubjectsModified(); }
 
+    // layout is append-only, it is not reverted with subjects
+    void addToLayout()
+    {
+        data->subjects.forEach([this] (const SubjectPtr& s) { layout->slot(s->id()); });
+    }
+
     ID id;
     SubjectsPlanDataPtr data;
     SubjectsPlanDataPtr originalData;
+    SubjectsLayoutPtr layout;
 
     bool isNameModified;
     bool isDeleted;
@@ -291,7 +356,7 @@ const DataString& SubjectsPlan::name() const { return impl_->data->name; }
 void SubjectsPlan::setName(const DataString& name)
 {
     if (name != impl_->data->name) {
-        impl_->data->name = name;
+        impl_->mutableData().name = name;
         impl_->isNameModified = !impl_->originalData ||
             impl_->originalData->name != name;
     }
@@ -305,29 +370,31 @@ bool SubjectsPlan::isNameModified() const
 void SubjectsPlan::insert(const SubjectPtr& subject, Index at)
 {
     ATT_ASSERT(subject);
-    impl_->data->subjects.insert(subject, at);
+    impl_->mutableData().subjects.insert(subject, at);
+    impl_->layout->slot(subject->id());
 }
 
 void SubjectsPlan::append(const SubjectPtr& subject)
 {
     ATT_ASSERT(subject);
-    impl_->data->subjects.append(subject);
+    impl_->mutableData().subjects.append(subject);
+    impl_->layout->slot(subject->id());
 }
 
 SubjectPtr SubjectsPlan::erase(Index at)
 {
-    return impl_->data->subjects.remove(at);
+    return impl_->mutableData().subjects.remove(at);
 }
 
 std::map<SubjectsPlan::Index, SubjectPtr>
 SubjectsPlan::erase(const std::set<Index>& at)
 {
-    return impl_->data->subjects.remove(at);
+    return impl_->mutableData().subjects.remove(at);
 }
 
 void SubjectsPlan::move(Index from, Index to)
 {
-    impl_->data->subjects.move(from, to);
+    impl_->mutableData().subjects.move(from, to);
 }
 
 bool SubjectsPlan::areSubjectsModified() const
@@ -344,6 +411,11 @@ const Subject& SubjectsPlan::at(Index at) const
     return *ptr;
 }
 
+const SubjectPtr& SubjectsPlan::subject(Index at) const
+{
+    return impl_->data->subjects.at(at);
+}
+
 bool SubjectsPlan::hasSubject(const ID& id) const
 {
     return impl_->data->subjects.contains(SubjectID(id));
@@ -357,14 +429,21 @@ size_t SubjectsPlan::subjectsCount() const
 SubjectsPlan::SubjectIdVector SubjectsPlan::subjectIds() const
 {
     SubjectIdVector res;
-    const auto size = impl_->data->subjects.size();
-    res.reserve(size);
-    for (Index i = 0; i < size; ++i) {
-        res.push_back(impl_->data->subjects.at(i)->id());
-    }
+    res.reserve(impl_->data->subjects.size());
+    impl_->data->subjects.forEach([&res] (const SubjectPtr& s) { res.push_back(s->id()); });
     return res;
 }
 
+const SubjectsLayoutPtr& SubjectsPlan::layout() const { return impl_->layout; }
+
+void SubjectsPlan::setLayout(const SubjectsLayoutPtr& layout)
+{
+    ATT_ASSERT(layout);
+    ATT_REQUIRE(!layout->isOpen(), "Subjects plan cannot share open grades layout");
+    impl_->layout = layout;
+    impl_->addToLayout();
+}
+
 bool SubjectsPlan::operator == (const SubjectsPlan& other) const
 {
     return impl_->id == other.impl_->id;
@@ -373,10 +452,77 @@ bool SubjectsPlan::operator == (const SubjectsPlan& other) const
 void SubjectsPlan::save()
 {
     ATT_REQUIRE(!impl_->isDeleted, "Cannot save deleted subjects plan, id " << impl_->id);
-    impl_->originalData.reset(new SubjectsPlanData(*impl_->data));
+    impl_->originalData = impl_->data;
     impl_->isNameModified = false;
 }
 
+namespace {
+
+void writeSubjects(SnapshotWriter& out, const SubjectsPlanData& data)
+{
+    out.stream() << data.name << quint32(data.subjects.size());
+    data.subjects.forEach([&out] (const SubjectPtr& subject) {
+        out.writeRef(subject, [&out] (const Subject& s) { s.write(out); });
+    });
+}
+
+SubjectsPlanDataPtr readSubjects(SnapshotReader& in)
+{
+    auto data = std::make_shared<SubjectsPlanData>(SubjectsPlanData{"", {}});
+    quint32 size = 0;
+    in.stream() >> data->name >> size;
+    in.check();
+    SubjectPtrVector subjects;
+    for (quint32 i = 0; i < size; ++i) {
+        auto subject = in.readRef<Subject>([&in] {
+            return std::make_shared<Subject>(Subject::read(in));
+        });
+        ATT_REQUIRE(subject, "No subject in snapshot subjects plan");
+        subjects.push_back(subject);
+    }
+    data->subjects = SubjectsVector(std::move(subjects));
+    return data;
+}
+
+} // namespace
+
+void SubjectsPlan::write(SnapshotWriter& out) const
+{
+    out.write(impl_->id);
+    out.stream() << impl_->isDeleted;
+    writeSubjects(out, *impl_->data);
+    out.stream() << bool(impl_->originalData);
+    if (impl_->originalData) {
+        writeSubjects(out, *impl_->originalData);
+    }
+    out.writeRef(impl_->layout, [&out] (const SubjectsLayout& layout) { layout.write(out); });
+}
+
+SubjectsPlan SubjectsPlan::read(SnapshotReader& in)
+{
+    SubjectsPlan res(in.readID());
+    Impl& impl = *res.impl_;
+    bool hasOriginal = false;
+    in.stream() >> impl.isDeleted;
+    impl.data = readSubjects(in);
+    in.stream() >> hasOriginal;
+    in.check();
+    if (hasOriginal) {
+        impl.originalData = readSubjects(in);
+        impl.isNameModified = impl.data->name != impl.originalData->name;
+        if (!impl.isModified()) {
+            impl.originalData = impl.data;
+        }
+    }
+    // grades of students read later share this layout by reference
+    auto layout = in.readRef<SubjectsLayout>([&in] {
+        return std::make_shared<SubjectsLayout>(SubjectsLayout::read(in));
+    });
+    ATT_REQUIRE(layout, "No grades layout in snapshot subjects plan");
+    res.setLayout(layout);
+    return res;
+}
+
 
 bool SubjectsPlan::SubjectPtrCompare::operator () (
     const SubjectPtr& p1, const SubjectPtr& p2) const
@@ -391,6 +537,13 @@ SubjectsPlan::Diff SubjectsPlan::diff(const SubjectsPlan& o) const
     return buildDiff(impl_->data->subjects, o.impl_->data->subjects);
 }
 
+SubjectsPlan::Diff SubjectsPlan::changes() const
+{
+    return impl_->originalData
+        ? buildDiff(impl_->originalData->subjects, impl_->data->subjects)
+        : buildDiff(SubjectsVector(), impl_->data->subjects);
+}
+
 void SubjectsPlan::applyDiff(const Diff& diff)
 {
     auto v = buildValues(impl_->data->subjects);
@@ -410,7 +563,8 @@ void SubjectsPlan::applyDiff(const Diff& diff)
         ++i;
         newSubjects.append(p.second);
     }
-    impl_->data->subjects = std::move(newSubjects);
+    impl_->mutableData().subjects = std::move(newSubjects);
+    impl_->addToLayout();
 }
 
 SubjectsPlan::Diff SubjectsPlan::reverseDiff(const SubjectsPlan::Diff& diff)
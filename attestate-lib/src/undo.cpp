@@ -0,0 +1,490 @@
+#include <attestate/undo.h>
+
+#include <attestate/subjects.h>
+#include <attestate/exception.h>
+
+#include <deque>
+#include <vector>
+
+namespace attestate {
+namespace undo {
+
+namespace {
+
+size_t stringBytes(const QString& s) { return sizeof(QString) + s.size() * sizeof(QChar); }
+
+size_t valueBytes(const FieldValue& value)
+{
+    const DataString* s = boost::get<DataString>(&value);
+    return sizeof(FieldValue) + (s ? s->size() * sizeof(QChar) : 0);
+}
+
+// student with its impl, current and original data
+size_t studentBytes(const Student& s)
+{
+    return sizeof(Student) + 256
+        + 2 * (stringBytes(s.familyName()) + stringBytes(s.name())
+            + stringBytes(s.parentalName()) + stringBytes(s.attestateId()))
+        + s.grades().codes().size();
+}
+
+// map node with key and both values
+const size_t DIFF_ENTRY_BYTES = 64;
+
+template <class T>
+const T& get(const FieldValue& value, student::Field field)
+{
+    const T* v = boost::get<T>(&value);
+    ATT_REQUIRE(v, "Unexpected value type for student field " << int(field));
+    return *v;
+}
+
+class Command {
+public:
+    virtual ~Command() {}
+
+    virtual void undo(Class& c, Changes& changes) = 0;
+    virtual void redo(Class& c, Changes& changes) = 0;
+
+    virtual size_t bytes() const = 0;
+};
+
+typedef std::unique_ptr<Command> CommandPtr;
+
+class GradesCommand : public Command {
+public:
+    GradesCommand(Class::Index at, const SubjectsGrades::Diff& diff) : at_(at), diff_(diff) {}
+
+    void undo(Class& c, Changes& changes) override
+    {
+        c.student(at_).grades().applyDiff(grades::reverseDiff(diff_));
+        changes.students.insert(at_);
+    }
+
+    void redo(Class& c, Changes& changes) override
+    {
+        c.student(at_).grades().applyDiff(diff_);
+        changes.students.insert(at_);
+    }
+
+    size_t bytes() const override
+    {
+        size_t res = sizeof(*this);
+        for (const auto& d : diff_) {
+            res += DIFF_ENTRY_BYTES
+                + (d.second.first ? d.second.first->size() * sizeof(QChar) : 0)
+                + (d.second.second ? d.second.second->size() * sizeof(QChar) : 0);
+        }
+        return res;
+    }
+
+private:
+    Class::Index at_;
+    SubjectsGrades::Diff diff_;
+};
+
+class FieldCommand : public Command {
+public:
+    FieldCommand(Class::Index at, student::Field field, FieldValue from, FieldValue to)
+        : at_(at), field_(field), from_(std::move(from)), to_(std::move(to))
+    {}
+
+    void undo(Class& c, Changes& changes) override
+    {
+        setFieldValue(c.student(at_), field_, from_);
+        changes.students.insert(at_);
+    }
+
+    void redo(Class& c, Changes& changes) override
+    {
+        setFieldValue(c.student(at_), field_, to_);
+        changes.students.insert(at_);
+    }
+
+    size_t bytes() const override { return sizeof(*this) + valueBytes(from_) + valueBytes(to_); }
+
+private:
+    Class::Index at_;
+    student::Field field_;
+    FieldValue from_;
+    FieldValue to_;
+};
+
+struct ClassData {
+    explicit ClassData(const Class& c)
+        : classId(c.classId())
+        , graduationYear(c.graduationYear())
+        , issueDate(c.issueDate())
+    {}
+
+    void apply(Class& c) const
+    {
+        c.setClassId(classId);
+        c.setGraduationYear(graduationYear);
+        c.setIssueDate(issueDate);
+    }
+
+    bool operator == (const ClassData& o) const
+    {
+        return classId == o.classId && graduationYear == o.graduationYear && issueDate == o.issueDate;
+    }
+
+    ClassId classId;
+    OptionalYear graduationYear;
+    OptionalDate issueDate;
+};
+
+class ClassCommand : public Command {
+public:
+    ClassCommand(const ClassData& from, const ClassData& to) : from_(from), to_(to) {}
+
+    void undo(Class& c, Changes& changes) override
+    {
+        from_.apply(c);
+        changes.isClassChanged = true;
+    }
+
+    void redo(Class& c, Changes& changes) override
+    {
+        to_.apply(c);
+        changes.isClassChanged = true;
+    }
+
+    size_t bytes() const override
+    {
+        return sizeof(*this) + (from_.classId.size() + to_.classId.size()) * sizeof(QChar);
+    }
+
+private:
+    ClassData from_;
+    ClassData to_;
+};
+
+// keeps student while it is out of class
+class StudentCommand : public Command {
+public:
+    StudentCommand(Class::Index at, Class::StudentPtr erased, size_t studentBytes)
+        : at_(at), erased_(std::move(erased)), studentBytes_(studentBytes)
+    {}
+
+    void undo(Class& c, Changes& changes) override { toggle(c, changes); }
+    void redo(Class& c, Changes& changes) override { toggle(c, changes); }
+
+    size_t bytes() const override { return sizeof(*this) + studentBytes_; }
+
+private:
+    void toggle(Class& c, Changes& changes)
+    {
+        if (erased_) {
+            c.insert(std::move(erased_), at_);
+        } else {
+            erased_ = c.erase(at_);
+        }
+        changes.isStructureChanged = true;
+    }
+
+    Class::Index at_;
+    Class::StudentPtr erased_;
+    size_t studentBytes_;
+};
+
+class PlanCommand : public Command {
+public:
+    PlanCommand(const SubjectsPlanPtr& plan, const SubjectsPlan::Diff& diff) : plan_(plan), diff_(diff) {}
+
+    void undo(Class&, Changes& changes) override
+    {
+        plan_->applyDiff(SubjectsPlan::reverseDiff(diff_));
+        changes.isStructureChanged = true;
+    }
+
+    void redo(Class&, Changes& changes) override
+    {
+        plan_->applyDiff(diff_);
+        changes.isStructureChanged = true;
+    }
+
+    size_t bytes() const override { return sizeof(*this) + diff_.size() * DIFF_ENTRY_BYTES; }
+
+private:
+    SubjectsPlanPtr plan_;
+    SubjectsPlan::Diff diff_;
+};
+
+struct Step {
+    Step() : bytes(0) {}
+
+    void append(CommandPtr command)
+    {
+        bytes += command->bytes();
+        commands.push_back(std::move(command));
+    }
+
+    std::vector<CommandPtr> commands;
+    size_t bytes;
+};
+
+} // namespace
+
+FieldValue fieldValue(const Student& s, student::Field field)
+{
+    switch (field) {
+        case student::Field::FamilyName: return s.familyName();
+        case student::Field::Name: return s.name();
+        case student::Field::ParentalName: return s.parentalName();
+        case student::Field::BirthDate: return s.birthDate();
+        case student::Field::GraduationYear: return s.graduationYear();
+        case student::Field::AttestateId: return s.attestateId();
+        case student::Field::IssueDate: return s.issueDate();
+    }
+    ATT_ERROR("Unknown student field " << int(field));
+    return FieldValue();
+}
+
+void setFieldValue(Student& s, student::Field field, const FieldValue& value)
+{
+    switch (field) {
+        case student::Field::FamilyName:
+            s.setFamilyName(get<DataString>(value, field));
+            break;
+        case student::Field::Name:
+            s.setName(get<DataString>(value, field));
+            break;
+        case student::Field::ParentalName:
+            s.setParentalName(get<DataString>(value, field));
+            break;
+        case student::Field::BirthDate:
+            s.setBirthDate(get<QDate>(value, field));
+            break;
+        case student::Field::GraduationYear:
+            s.setGraduationYear(get<OptionalYear>(value, field));
+            break;
+        case student::Field::AttestateId:
+            s.setAttestateId(get<DataString>(value, field));
+            break;
+        case student::Field::IssueDate:
+            s.setIssueDate(get<OptionalDate>(value, field));
+            break;
+    }
+}
+
+
+class Stack::Impl {
+public:
+    Impl(Class& c, size_t maxBytes)
+        : cls(c)
+        , maxBytes(maxBytes)
+        , groupDepth(0)
+        , bytes(0)
+    {}
+
+    void push(CommandPtr command)
+    {
+        group.append(std::move(command));
+        if (!groupDepth) {
+            pushGroup();
+        }
+    }
+
+    template <class F>
+    void changeClass(F change)
+    {
+        const ClassData from(cls);
+        change(cls);
+        const ClassData to(cls);
+        if (!(from == to)) {
+            push(CommandPtr(new ClassCommand(from, to)));
+        }
+    }
+
+    void pushGroup()
+    {
+        Step step;
+        std::swap(step, group);
+        if (step.commands.empty()) {
+            return;
+        }
+        clearRedo();
+        bytes += step.bytes;
+        undo.push_back(std::move(step));
+        trim();
+    }
+
+    void clearRedo()
+    {
+        for (const auto& step : redo) {
+            bytes -= step.bytes;
+        }
+        redo.clear();
+    }
+
+    // oldest undo steps first, then farthest redo steps;
+    // next step to undo, or to redo if there is none, is always kept
+    void trim()
+    {
+        while (bytes > maxBytes && undo.size() > 1) {
+            bytes -= undo.front().bytes;
+            undo.pop_front();
+        }
+        while (bytes > maxBytes && redo.size() > (undo.empty() ? 1 : 0)) {
+            bytes -= redo.front().bytes;
+            redo.pop_front();
+        }
+    }
+
+    Class& cls;
+    size_t maxBytes;
+
+    // next steps to undo and to redo are at back
+    std::deque<Step> undo;
+    std::deque<Step> redo;
+
+    Step group;
+    size_t groupDepth;
+
+    size_t bytes;
+};
+
+Stack::Stack(Class& c, size_t maxBytes)
+    : impl_(new Impl(c, maxBytes))
+{}
+
+Stack::~Stack()
+{}
+
+void Stack::setGrades(Class::Index at, const SubjectsGrades::Diff& diff)
+{
+    if (diff.empty()) {
+        return;
+    }
+    impl_->cls.student(at).grades().applyDiff(diff);
+    impl_->push(CommandPtr(new GradesCommand(at, diff)));
+}
+
+void Stack::setGrade(Class::Index at, const ID& subjectId, const grades::OptionalValue& value)
+{
+    const auto old = impl_->cls.student(at).grades().value(subjectId);
+    if (old == value) {
+        return;
+    }
+    setGrades(at, {{subjectId, {old, value}}});
+}
+
+void Stack::setField(Class::Index at, student::Field field, const FieldValue& value)
+{
+    Student& s = impl_->cls.student(at);
+    FieldValue old = fieldValue(s, field);
+    if (old == value) {
+        return;
+    }
+    setFieldValue(s, field, value);
+    impl_->push(CommandPtr(new FieldCommand(at, field, std::move(old), value)));
+}
+
+void Stack::setClassId(const ClassId& classId)
+{
+    impl_->changeClass([&classId] (Class& c) { c.setClassId(classId); });
+}
+
+void Stack::setGraduationYear(const OptionalYear& year)
+{
+    impl_->changeClass([&year] (Class& c) { c.setGraduationYear(year); });
+}
+
+void Stack::setIssueDate(const OptionalDate& issueDate)
+{
+    impl_->changeClass([&issueDate] (Class& c) { c.setIssueDate(issueDate); });
+}
+
+void Stack::insert(Class::StudentPtr student, Class::Index at)
+{
+    ATT_REQUIRE(student, "Student is not set");
+    const size_t bytes = studentBytes(*student);
+    impl_->cls.insert(std::move(student), at);
+    impl_->push(CommandPtr(new StudentCommand(at, nullptr, bytes)));
+}
+
+void Stack::erase(Class::Index at)
+{
+    auto student = impl_->cls.erase(at);
+    const size_t bytes = studentBytes(*student);
+    impl_->push(CommandPtr(new StudentCommand(at, std::move(student), bytes)));
+}
+
+void Stack::changeSubjectsPlan(const SubjectsPlan::Diff& diff)
+{
+    const auto& plan = impl_->cls.subjectsPlan();
+    ATT_REQUIRE(plan, "Class " << impl_->cls.id() << " has no subjects plan");
+    if (diff.empty()) {
+        return;
+    }
+    plan->applyDiff(diff);
+    impl_->push(CommandPtr(new PlanCommand(plan, diff)));
+}
+
+void Stack::beginGroup() { ++impl_->groupDepth; }
+
+void Stack::endGroup()
+{
+    ATT_REQUIRE(impl_->groupDepth, "Undo group is not started");
+    if (!--impl_->groupDepth) {
+        impl_->pushGroup();
+    }
+}
+
+bool Stack::canUndo() const { return !impl_->undo.empty(); }
+bool Stack::canRedo() const { return !impl_->redo.empty(); }
+
+size_t Stack::undoCount() const { return impl_->undo.size(); }
+size_t Stack::redoCount() const { return impl_->redo.size(); }
+
+Changes Stack::undo()
+{
+    ATT_REQUIRE(!impl_->groupDepth, "Cannot undo inside of undo group");
+    ATT_REQUIRE(canUndo(), "Nothing to undo");
+    Step step = std::move(impl_->undo.back());
+    impl_->undo.pop_back();
+
+    Changes changes;
+    for (auto it = step.commands.rbegin(); it != step.commands.rend(); ++it) {
+        (*it)->undo(impl_->cls, changes);
+    }
+    impl_->redo.push_back(std::move(step));
+    return changes;
+}
+
+Changes Stack::redo()
+{
+    ATT_REQUIRE(!impl_->groupDepth, "Cannot redo inside of undo group");
+    ATT_REQUIRE(canRedo(), "Nothing to redo");
+    Step step = std::move(impl_->redo.back());
+    impl_->redo.pop_back();
+
+    Changes changes;
+    for (auto& command : step.commands) {
+        command->redo(impl_->cls, changes);
+    }
+    impl_->undo.push_back(std::move(step));
+    return changes;
+}
+
+size_t Stack::bytes() const { return impl_->bytes; }
+
+size_t Stack::maxBytes() const { return impl_->maxBytes; }
+
+void Stack::setMaxBytes(size_t maxBytes)
+{
+    impl_->maxBytes = maxBytes;
+    impl_->trim();
+}
+
+void Stack::clear()
+{
+    ATT_REQUIRE(!impl_->groupDepth, "Cannot clear undo stack inside of undo group");
+    impl_->undo.clear();
+    impl_->redo.clear();
+    impl_->bytes = 0;
+}
+
+} // namespace undo
+} // namespace attestate
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <attestate/exception.h>
+
+#include <map>
+#include <set>
+#include <memory>
+#include <utility>
+#include <cstdint>
+
+namespace attestate {
+
+// Keyed sequence with the same interface as UniqueVector.
+// Values are kept in an implicit treap (order-statistic tree by position),
+// so positional access, insert, remove and move are O(log n)
+// and the size is not limited by the index type.
+
+template <class V, class K = V>
+class UniqueTree {
+public:
+    typedef size_t Index;
+
+    UniqueTree() : root_(nullptr), seed_(SEED) {}
+
+    template <class Container>
+    UniqueTree(
+            const Container& c,
+            const typename std::enable_if<
+                !std::is_same<Container, UniqueTree<V, K>>::value,
+                Container
+            >::type* = nullptr)
+        : root_(nullptr)
+        , seed_(SEED)
+    {
+        for (const auto& v : c) {
+            append(v);
+        }
+    }
+
+    template <class Container>
+    UniqueTree(
+            Container&& c,
+            const typename std::enable_if<
+                !std::is_same<Container, UniqueTree<V, K>>::value,
+                Container
+            >::type* = nullptr)
+        : root_(nullptr)
+        , seed_(SEED)
+    {
+        for (auto&& v : c) {
+            append(std::move(v));
+        }
+    }
+
+    UniqueTree(const UniqueTree<V, K>& o) : root_(nullptr), seed_(SEED) { *this = o; }
+
+    UniqueTree<V, K>& operator = (const UniqueTree<V, K>& o)
+    {
+        if (this == &o) {
+            return *this;
+        }
+        clear();
+        o.forEach([this] (const V& v) { append(v); });
+        return *this;
+    }
+
+    UniqueTree(UniqueTree<V, K>&& o) : root_(nullptr), seed_(SEED) { *this = std::move(o); }
+
+    UniqueTree<V, K>& operator = (UniqueTree<V, K>&& o)
+    {
+        if (this == &o) {
+            return *this;
+        }
+        clear();
+        root_ = o.root_;
+        o.root_ = nullptr;
+        keys_ = std::move(o.keys_);
+        o.keys_.clear();
+        seed_ = o.seed_;
+        return *this;
+    }
+
+    ~UniqueTree() { clear(); }
+
+    const V& at(Index at) const
+    {
+        checkIndexIsValid(at);
+        return nodeAt(at)->value;
+    }
+
+    bool contains(const K& key) const { return keys_.find(key) != keys_.end(); }
+
+    void insert(const V& v, Index at) { insertImpl(V(v), at, /* check = */ true); }
+    void insert(V&& v, Index at) { insertImpl(std::move(v), at, /* check = */ true); }
+
+    void insert(const std::map<Index, V>& v)
+    {
+        checkInsertData(v);
+        for (const auto& p : v) {
+            insertImpl(V(p.second), p.first, /* check = */ false);
+        }
+    }
+
+    void insert(std::map<Index, V>&& v)
+    {
+        checkInsertData(v);
+        for (auto&& p : v) {
+            insertImpl(std::move(p.second), p.first, /* check = */ false);
+        }
+    }
+
+    void append(const V& v) { insertImpl(V(v), size(), /* check = */ true); }
+    void append(V&& v) { insertImpl(std::move(v), size(), /* check = */ true); }
+
+    V remove(Index at)
+    {
+        checkIndexIsValid(at);
+        return removeImpl(at);
+    }
+
+    // index -> v before removal
+    std::map<Index, V> remove(const std::set<Index>& at)
+    {
+        size_t rc = 0;
+        for (auto i : at) {
+            checkIndexIsValid(i - rc++);
+        }
+
+        std::map<Index, V> res;
+        size_t deleted = 0;
+        for (auto i : at) {
+            res.insert(typename std::map<Index, V>::value_type{i, removeImpl(i - deleted++)});
+        }
+        return res;
+    }
+
+    void move(Index from, Index to)
+    {
+        checkIndexIsValid(from);
+        checkIndexIsValid(to);
+        if (from == to) {
+            return;
+        }
+        attach(detach(from), to);
+    }
+
+    // kept for interface compatibility with UniqueVector
+    void reserve(size_t /*size*/) {}
+
+    bool empty() const { return !root_; }
+    size_t size() const { return sizeOf(root_); }
+
+    // in-order traversal, O(n)
+    template <class F>
+    void forEach(F f) const { forEachImpl(root_, f); }
+
+private:
+    static const uint32_t SEED = 2463534242u;
+
+    struct Node {
+        Node(V&& v, uint32_t priority)
+            : value(std::move(v))
+            , priority(priority)
+            , size(1)
+            , left(nullptr)
+            , right(nullptr)
+        {}
+
+        V value;
+        uint32_t priority;
+        size_t size;
+        Node* left;
+        Node* right;
+    };
+
+    static size_t sizeOf(const Node* n) { return n ? n->size : 0; }
+
+    static void update(Node* n)
+    {
+        n->size = 1 + sizeOf(n->left) + sizeOf(n->right);
+    }
+
+    // xorshift32, deterministic so that tree shape is reproducible
+    uint32_t nextPriority()
+    {
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        return seed_;
+    }
+
+    // first count nodes go to l, the rest to r
+    static void split(Node* t, size_t count, Node*& l, Node*& r)
+    {
+        if (!t) {
+            l = r = nullptr;
+            return;
+        }
+        if (sizeOf(t->left) < count) {
+            split(t->right, count - sizeOf(t->left) - 1, t->right, r);
+            l = t;
+        } else {
+            split(t->left, count, l, t->left);
+            r = t;
+        }
+        update(t);
+    }
+
+    static Node* merge(Node* l, Node* r)
+    {
+        if (!l) {
+            return r;
+        }
+        if (!r) {
+            return l;
+        }
+        if (l->priority > r->priority) {
+            l->right = merge(l->right, r);
+            update(l);
+            return l;
+        }
+        r->left = merge(l, r->left);
+        update(r);
+        return r;
+    }
+
+    // at must be checked by caller
+    const Node* nodeAt(Index at) const
+    {
+        const Node* n = root_;
+        for (;;) {
+            const size_t ls = sizeOf(n->left);
+            if (at < ls) {
+                n = n->left;
+            } else if (at == ls) {
+                return n;
+            } else {
+                at -= ls + 1;
+                n = n->right;
+            }
+        }
+    }
+
+    void attach(Node* n, Index at)
+    {
+        Node* l;
+        Node* r;
+        split(root_, at, l, r);
+        root_ = merge(merge(l, n), r);
+    }
+
+    Node* detach(Index at)
+    {
+        Node* l;
+        Node* m;
+        Node* r;
+        split(root_, at, l, r);
+        split(r, 1, m, r);
+        root_ = merge(l, r);
+        return m;
+    }
+
+    void insertImpl(V&& v, Index at, bool check)
+    {
+        if (check) {
+            ATT_REQUIRE(at <= size(), "Index " << at << " is out of range");
+        }
+        auto res = keys_.insert(K(v));
+        ATT_REQUIRE(res.second, "Key " << *res.first << " is already present");
+        attach(new Node(std::move(v), nextPriority()), at);
+    }
+
+    V removeImpl(Index at)
+    {
+        std::unique_ptr<Node> n(detach(at));
+        keys_.erase(K(n->value));
+        return std::move(n->value);
+    }
+
+    void checkIndexIsValid(Index at) const
+    {
+        ATT_REQUIRE(at < size(), "Index " << at << " is out of range");
+    }
+
+    void checkInsertData(const std::map<Index, V>& v) const
+    {
+        size_t prevCnt = 0;
+        std::set<K> ks;
+        for (const auto& p : v) {
+            ATT_REQUIRE(p.first <= size() + prevCnt++, "Invalid index " << p.first);
+            K key(p.second);
+            ATT_REQUIRE(keys_.find(key) == keys_.end(), "Duplicate key " << key);
+            ATT_REQUIRE(ks.insert(key).second, "Duplicate key " << key);
+        }
+    }
+
+    template <class F>
+    static void forEachImpl(const Node* n, F& f)
+    {
+        if (!n) {
+            return;
+        }
+        forEachImpl(n->left, f);
+        f(n->value);
+        forEachImpl(n->right, f);
+    }
+
+    static void destroy(Node* n)
+    {
+        if (!n) {
+            return;
+        }
+        destroy(n->left);
+        destroy(n->right);
+        delete n;
+    }
+
+    void clear()
+    {
+        destroy(root_);
+        root_ = nullptr;
+        keys_.clear();
+    }
+
+    Node* root_;
+    std::set<K> keys_;
+    uint32_t seed_;
+};
+
+} // namespace attestate
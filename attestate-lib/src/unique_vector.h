@@ -16,7 +16,7 @@ template <class V, class K>
 class UniqueVectorImpl<V, K, false>
 {
 public:
-    typedef uint8_t Index;
+    typedef size_t Index;
 
     UniqueVectorImpl() : values_(new ValuesMap) {}
 
@@ -207,7 +207,7 @@ private:
 template <class V>
 class UniqueVectorImpl<V, V, true> {
 public:
-    typedef uint8_t Index;
+    typedef size_t Index;
 
     UniqueVectorImpl() : set_(new Set) {}
 
@@ -398,7 +398,7 @@ class UniqueVector {
 private:
     typedef UniqueVectorImpl<V, K, std::is_same<V, K>::value> Impl;
 public:
-    typedef uint8_t Index;
+    typedef size_t Index;
 
     UniqueVector() {}
 
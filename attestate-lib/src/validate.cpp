@@ -3,61 +3,111 @@
 #include <attestate/serialize.h>
 #include <attestate/student.h>
 #include <attestate/grades.h>
+#include <attestate/exception.h>
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace attestate {
 namespace validation {
 
-boost::optional<StudentErrors> validate(const Class& c, Class::Index studentIdx)
+namespace {
+
+typedef boost::optional<ValueError> OptionalError;
+
+struct PropertyCheck {
+    const QString& tag;
+    OptionalError (*check)(const Class& c, const Student& s);
+};
+
+OptionalError notEmpty(const DataString& value)
+{
+    return value.isEmpty() ? OptionalError(ValueError::Empty) : boost::none;
+}
+
+const std::vector<PropertyCheck>& propertyChecks()
 {
     using namespace cfg::tags;
 
-    const Student& s = c.student(studentIdx);
-    if (s.state() == State::Deleted) {
-        return boost::none;
-    }
+    static const std::vector<PropertyCheck> s_checks = {
+        {property::FAMILY_NAME, [] (const Class&, const Student& s) {
+            return notEmpty(s.familyName());
+        }},
+        {property::NAME, [] (const Class&, const Student& s) {
+            return notEmpty(s.name());
+        }},
+        {property::PARENTAL_NAME, [] (const Class&, const Student& s) {
+            return notEmpty(s.parentalName());
+        }},
+        {property::ATTESTATE_ID, [] (const Class&, const Student& s) {
+            return notEmpty(s.attestateId());
+        }},
+        {property::BIRTH_DATE, [] (const Class&, const Student& s) {
+            return s.birthDate().isNull() || !s.birthDate().isValid()
+                ? OptionalError(ValueError::Invalid)
+                : boost::none;
+        }},
+        // class values are used if student has none
+        {property::ISSUE_DATE, [] (const Class& c, const Student& s) {
+            const bool isInvalid = s.issueDate()
+                ? s.issueDate()->isNull() || !s.issueDate()->isValid()
+                : !c.issueDate();
+            return isInvalid ? OptionalError(ValueError::Invalid) : boost::none;
+        }},
+        {property::GRADUATION_YEAR, [] (const Class& c, const Student& s) {
+            return !s.graduationYear() && !c.graduationYear()
+                ? OptionalError(ValueError::Empty)
+                : boost::none;
+        }}
+    };
+    return s_checks;
+}
 
-    PropertyErrors v;
-    if (s.familyName().isEmpty()) {
-        v.emplace(property::FAMILY_NAME, ValueError::Empty);
-    }
-    if (s.name().isEmpty()) {
-        v.emplace(property::NAME, ValueError::Empty);
-    }
-    if (s.parentalName().isEmpty()) {
-        v.emplace(property::PARENTAL_NAME, ValueError::Empty);
+OptionalError gradeError(const Student& s, const ID& subjectId)
+{
+    const grades::Code gc = s.grades().code(subjectId);
+    if (gc == grades::NO_CODE) {
+        return ValueError::Empty;
+    } else if (gc == grades::INVALID_CODE) {
+        return ValueError::Invalid;
     }
+    return boost::none;
+}
 
-    if (s.attestateId().isEmpty()) {
-        v.emplace(property::ATTESTATE_ID, ValueError::Empty);
+template <class Map, class Key>
+void setError(Map& errors, const Key& key, const OptionalError& error)
+{
+    if (error) {
+        errors[key] = *error;
+    } else {
+        errors.erase(key);
     }
+}
 
-    if (s.birthDate().isNull() || !s.birthDate().isValid()) {
-        v.emplace(property::BIRTH_DATE, ValueError::Invalid);
-    }
+} // namespace
 
-    if (!s.issueDate()) {
-        if (!c.issueDate()) {
-            v.emplace(property::ISSUE_DATE, ValueError::Invalid);
-        }
-    } else if (s.issueDate()->isNull() || !s.issueDate()->isValid()) {
-        v.emplace(property::ISSUE_DATE, ValueError::Invalid);
+boost::optional<StudentErrors> validate(const Class& c, Class::Index studentIdx)
+{
+    const Student& s = c.student(studentIdx);
+    if (s.state() == State::Deleted) {
+        return boost::none;
     }
 
-    if (!s.graduationYear()) {
-        if (!c.graduationYear()) {
-            v.emplace(property::GRADUATION_YEAR, ValueError::Empty);
+    PropertyErrors v;
+    for (const auto& pc : propertyChecks()) {
+        if (auto e = pc.check(c, s)) {
+            v.emplace(pc.tag, *e);
         }
     }
 
     GradeErrors ge;
     const auto& sp = c.subjectsPlan();
     for (size_t i = 0; sp && i < sp->subjectsCount(); ++i) {
-        const auto subjId = sp->at(i).id();
-        auto gv = s.grades().value(subjId);
-        if (!gv || gv->isEmpty()) {
-            ge.emplace(subjId, ValueError::Empty);
-        } else if (!grades::isValid(*gv)) {
-            ge.emplace(subjId, ValueError::Invalid);
+        const auto& subjId = sp->at(i).id();
+        if (auto e = gradeError(s, subjId)) {
+            ge.emplace(subjId, *e);
         }
     }
 
@@ -68,16 +118,27 @@ boost::optional<StudentErrors> validate(const Class& c, Class::Index studentIdx)
     return StudentErrors{std::move(v), std::move(ge)};
 }
 
-boost::optional<ClassErrors> validate(const Class& c)
+namespace {
+
+PropertyErrors classPropertyErrors(
+    const OptionalDate& issueDate, const OptionalYear& graduationYear)
 {
     PropertyErrors v;
-    if (!c.issueDate() || !c.issueDate()->isValid()) {
+    if (!issueDate || !issueDate->isValid()) {
         v.emplace(cfg::tags::property::ISSUE_DATE, ValueError::Invalid);
     }
 
-    if (!c.graduationYear()) {
+    if (!graduationYear) {
         v.emplace(cfg::tags::property::GRADUATION_YEAR, ValueError::Empty);
     }
+    return v;
+}
+
+} // namespace
+
+boost::optional<ClassErrors> validate(const Class& c)
+{
+    PropertyErrors v = classPropertyErrors(c.issueDate(), c.graduationYear());
 
     StudentErrorsMap se;
     for (size_t i = 0 ; i < c.studentsCount(); ++i) {
@@ -94,5 +155,274 @@ boost::optional<ClassErrors> validate(const Class& c)
     return ClassErrors{std::move(v), std::move(se)};
 }
 
+boost::optional<ClassErrors> validate(const ClassTable& t)
+{
+    using namespace cfg::tags;
+
+    PropertyErrors v = classPropertyErrors(t.issueDate(), t.graduationYear());
+
+    const size_t rows = t.rowsCount();
+    std::vector<StudentErrors> errors(rows);
+
+    auto checkNotEmpty = [&] (const std::vector<DataString>& column, const QString& tag)
+    {
+        for (ClassTable::Row r = 0; r < rows; ++r) {
+            if (column[r].isEmpty()) {
+                errors[r].propertyErrors.emplace(tag, ValueError::Empty);
+            }
+        }
+    };
+
+    checkNotEmpty(t.familyNames(), property::FAMILY_NAME);
+    checkNotEmpty(t.names(), property::NAME);
+    checkNotEmpty(t.parentalNames(), property::PARENTAL_NAME);
+    checkNotEmpty(t.attestateIds(), property::ATTESTATE_ID);
+
+    const auto& birthDates = t.birthDates();
+    for (ClassTable::Row r = 0; r < rows; ++r) {
+        if (birthDates[r].isNull() || !birthDates[r].isValid()) {
+            errors[r].propertyErrors.emplace(property::BIRTH_DATE, ValueError::Invalid);
+        }
+    }
+
+    const auto& issueDates = t.issueDates();
+    for (ClassTable::Row r = 0; r < rows; ++r) {
+        const auto& d = issueDates[r];
+        if (d ? d->isNull() || !d->isValid() : !t.issueDate()) {
+            errors[r].propertyErrors.emplace(property::ISSUE_DATE, ValueError::Invalid);
+        }
+    }
+
+    if (!t.graduationYear()) {
+        const auto& years = t.graduationYears();
+        for (ClassTable::Row r = 0; r < rows; ++r) {
+            if (!years[r]) {
+                errors[r].propertyErrors.emplace(property::GRADUATION_YEAR, ValueError::Empty);
+            }
+        }
+    }
+
+    for (size_t j = 0; j < t.subjectsCount(); ++j) {
+        const auto& codes = t.gradeCodes(j);
+        for (ClassTable::Row r = 0; r < rows; ++r) {
+            if (codes[r] == grades::NO_CODE) {
+                errors[r].gradeErrors.emplace(t.subjectIds()[j], ValueError::Empty);
+            } else if (codes[r] == grades::INVALID_CODE) {
+                errors[r].gradeErrors.emplace(t.subjectIds()[j], ValueError::Invalid);
+            }
+        }
+    }
+
+    StudentErrorsMap se;
+    for (ClassTable::Row r = 0; r < rows; ++r) {
+        auto& e = errors[r];
+        if (!e.propertyErrors.empty() || !e.gradeErrors.empty()) {
+            se.emplace(t.studentIds()[r], std::move(e));
+        }
+    }
+
+    if (v.empty() && se.empty()) {
+        return boost::none;
+    }
+
+    return ClassErrors{std::move(v), std::move(se)};
+}
+
+namespace {
+
+// students checked by one task
+const size_t STUDENTS_RANGE = 256;
+
+struct StudentsRange {
+    size_t classPos;
+    Class::Index begin;
+    Class::Index end;
+};
+
+} // namespace
+
+ClassErrorsMap validate(const std::vector<const Class*>& classes, size_t workers)
+{
+    std::vector<StudentsRange> ranges;
+    for (size_t i = 0; i < classes.size(); ++i) {
+        ATT_ASSERT(classes[i]);
+        const size_t count = classes[i]->studentsCount();
+        for (Class::Index b = 0; b < count; b += STUDENTS_RANGE) {
+            ranges.push_back({i, b, std::min(b + STUDENTS_RANGE, count)});
+        }
+    }
+
+    // filled by tasks, merged in tasks order for deterministic result
+    typedef std::vector<std::pair<ID, StudentErrors>> RangeErrors;
+    std::vector<RangeErrors> rangeErrors(ranges.size());
+
+    parallel::TaskCounter counter(ranges.size());
+    parallel::runWorkers(
+        parallel::workersCount(workers, ranges.size()),
+        [&] (size_t /*worker*/)
+        {
+            size_t task = 0;
+            while (counter.next(task)) {
+                const StudentsRange& r = ranges[task];
+                const Class& c = *classes[r.classPos];
+                for (Class::Index i = r.begin; i < r.end; ++i) {
+                    auto e = validate(c, i);
+                    if (e) {
+                        rangeErrors[task].emplace_back(c.student(i).id(), std::move(*e));
+                    }
+                }
+            }
+        });
+
+    ClassErrorsMap res;
+    auto rangeIt = ranges.begin();
+    auto errorsIt = rangeErrors.begin();
+    for (size_t i = 0; i < classes.size(); ++i) {
+        const Class& c = *classes[i];
+        ClassErrors ce{classPropertyErrors(c.issueDate(), c.graduationYear()), {}};
+        for ( ; rangeIt != ranges.end() && rangeIt->classPos == i; ++rangeIt, ++errorsIt) {
+            for (auto& e : *errorsIt) {
+                ce.studentErrors.insert(std::move(e));
+            }
+        }
+        if (!ce.propertyErrors.empty() || !ce.studentErrors.empty()) {
+            res[c.id()] = std::move(ce);
+        }
+    }
+    return res;
+}
+
+
+// Validator
+
+class Validator::Impl {
+public:
+    explicit Impl(const Class& c) : c(c) {}
+
+    void setClassErrors()
+    {
+        errors.propertyErrors = classPropertyErrors(c.issueDate(), c.graduationYear());
+    }
+
+    void setStudentErrors(Class::Index at)
+    {
+        const Student& s = c.student(at);
+        auto e = validate(c, at);
+        if (e) {
+            errors.studentErrors[s.id()] = std::move(*e);
+        } else {
+            errors.studentErrors.erase(s.id());
+        }
+    }
+
+    // removes entry if student has no errors left
+    template <class F>
+    void updateStudentErrors(Class::Index at, F update)
+    {
+        const Student& s = c.student(at);
+        if (s.state() == State::Deleted) {
+            errors.studentErrors.erase(s.id());
+            return;
+        }
+        auto it = errors.studentErrors.emplace(s.id(), StudentErrors()).first;
+        update(s, it->second);
+        if (it->second.propertyErrors.empty() && it->second.gradeErrors.empty()) {
+            errors.studentErrors.erase(it);
+        }
+    }
+
+    const Class& c;
+    ClassErrors errors;
+    IDSet studentIds;
+};
+
+Validator::Validator(const Class& c)
+    : impl_(new Impl(c))
+{
+    revalidate();
+}
+
+Validator::~Validator()
+{}
+
+const ClassErrors& Validator::errors() const { return impl_->errors; }
+
+bool Validator::hasErrors() const
+{
+    return !impl_->errors.propertyErrors.empty() || !impl_->errors.studentErrors.empty();
+}
+
+void Validator::onStudentChanged(Class::Index at)
+{
+    impl_->setStudentErrors(at);
+}
+
+void Validator::onPropertyChanged(Class::Index at, const QString& propertyTag)
+{
+    const auto& checks = propertyChecks();
+    auto it = std::find_if(checks.begin(), checks.end(),
+        [&propertyTag] (const PropertyCheck& pc) { return pc.tag == propertyTag; });
+    ATT_REQUIRE(it != checks.end(), "Unknown property: " << propertyTag.toStdString());
+
+    const Class& c = impl_->c;
+    impl_->updateStudentErrors(at, [&c, it] (const Student& s, StudentErrors& e) {
+        setError(e.propertyErrors, it->tag, it->check(c, s));
+    });
+}
+
+void Validator::onGradeChanged(Class::Index at, const ID& subjectId)
+{
+    const auto& sp = impl_->c.subjectsPlan();
+    if (!sp || !sp->hasSubject(subjectId)) {
+        return;
+    }
+    impl_->updateStudentErrors(at, [&subjectId] (const Student& s, StudentErrors& e) {
+        setError(e.gradeErrors, subjectId, gradeError(s, subjectId));
+    });
+}
+
+void Validator::onClassChanged()
+{
+    using namespace cfg::tags;
+
+    impl_->setClassErrors();
+    // only properties which fall back to class values depend on it
+    for (Class::Index i = 0; i < impl_->c.studentsCount(); ++i) {
+        onPropertyChanged(i, property::ISSUE_DATE);
+        onPropertyChanged(i, property::GRADUATION_YEAR);
+    }
+}
+
+void Validator::onStudentsChanged()
+{
+    const Class& c = impl_->c;
+    IDSet ids;
+    for (Class::Index i = 0; i < c.studentsCount(); ++i) {
+        const ID& id = c.student(i).id();
+        ids.insert(id);
+        if (!impl_->studentIds.count(id)) {
+            impl_->setStudentErrors(i);
+        }
+    }
+    for (const auto& id : impl_->studentIds) {
+        if (!ids.count(id)) {
+            impl_->errors.studentErrors.erase(id);
+        }
+    }
+    impl_->studentIds = std::move(ids);
+}
+
+void Validator::revalidate()
+{
+    const Class& c = impl_->c;
+    impl_->errors = ClassErrors();
+    impl_->studentIds.clear();
+    impl_->setClassErrors();
+    for (Class::Index i = 0; i < c.studentsCount(); ++i) {
+        impl_->studentIds.insert(c.student(i).id());
+        impl_->setStudentErrors(i);
+    }
+}
+
 } // namespace validation
 } // namespace attestate
@@ -0,0 +1,121 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include <attestate/class_table.h>
+#include <attestate/validate.h>
+#include <attestate/exception.h>
+
+#include "helpers.h"
+
+using namespace attestate;
+
+BOOST_AUTO_TEST_SUITE(class_table_tests)
+
+const ID SUBJ_ID_1 = ID::gen();
+const ID SUBJ_ID_2 = ID::gen();
+
+const grades::Value G_5 = "5";
+const grades::Value G_T = QString::fromUtf8("д");
+const grades::Value G_BAD = "7";
+
+Class::StudentPtr createStudent(
+    const DataString& familyName,
+    const SubjectsGrades& grades,
+    const OptionalDate& issueDate = boost::none)
+{
+    return Class::StudentPtr(new Student(
+        ID::gen(),
+        familyName, "Name", "Parental",
+        QDate(1998, 1, 1),
+        grades,
+        boost::none,
+        "0000001",
+        issueDate));
+}
+
+std::unique_ptr<Class> createClass()
+{
+    auto plan = std::make_shared<SubjectsPlan>(
+        ID::gen(), "Plan",
+        SubjectPtrVector{
+            std::make_shared<Subject>(SUBJ_ID_1, "Subject 1"),
+            std::make_shared<Subject>(SUBJ_ID_2, "Subject 2")
+        });
+    auto layout = std::make_shared<SubjectsLayout>(plan->subjectIds());
+
+    std::vector<Class::StudentPtr> students;
+    students.push_back(createStudent(
+        "Ivanov", SubjectsGrades(layout, {{SUBJ_ID_1, G_5}, {SUBJ_ID_2, G_T}})));
+    students.push_back(createStudent(
+        "", SubjectsGrades(layout, {{SUBJ_ID_2, G_BAD}}), QDate(2016, 6, 1)));
+    // separate layout with other subjects order
+    students.push_back(createStudent(
+        "Petrov", SubjectsGrades({{SUBJ_ID_2, G_5}, {SUBJ_ID_1, G_T}})));
+
+    return std::unique_ptr<Class>(new Class(
+        ID::gen(), "11A", Year(2016), QDate(2016, 6, 25), std::move(students), plan));
+}
+
+BOOST_AUTO_TEST_CASE(test_columns)
+{
+    auto c = createClass();
+    c->student(2).setDeleted(true);
+
+    ClassTable t(*c);
+    BOOST_REQUIRE(t.rowsCount() == 2 && t.subjectsCount() == 2);
+    BOOST_CHECK(t.id() == c->id() && t.classId() == "11A");
+    BOOST_CHECK(t.graduationYear() == c->graduationYear());
+
+    BOOST_CHECK(t.studentIds()[1] == c->student(1).id());
+    BOOST_CHECK(t.studentIndexes()[1] == 1);
+    BOOST_CHECK(t.familyNames()[0] == "Ivanov" && t.familyNames()[1].isEmpty());
+    BOOST_CHECK(!t.issueDates()[0] && t.issueDates()[1] == QDate(2016, 6, 1));
+
+    BOOST_CHECK(t.subjectIds()[0] == SUBJ_ID_1 && t.subjectIds()[1] == SUBJ_ID_2);
+    const auto& codes1 = t.gradeCodes(0);
+    const auto& codes2 = t.gradeCodes(1);
+    BOOST_CHECK(codes1[0] == grades::code(G_5) && codes1[1] == grades::NO_CODE);
+    BOOST_CHECK(codes2[0] == grades::code(G_T) && codes2[1] == grades::INVALID_CODE);
+    BOOST_CHECK_THROW(t.gradeCodes(2), Exception);
+
+    c->student(2).setDeleted(false);
+    ClassTable t1(*c);
+    BOOST_REQUIRE(t1.rowsCount() == 3);
+    BOOST_CHECK(t1.gradeCodes(0)[2] == grades::code(G_T));
+    BOOST_CHECK(t1.gradeCodes(1)[2] == grades::code(G_5));
+}
+
+BOOST_AUTO_TEST_CASE(test_validation)
+{
+    auto c = createClass();
+
+    auto checkSame = [&] ()
+    {
+        auto exp = validation::validate(*c);
+        auto recv = validation::validate(ClassTable(*c));
+        BOOST_REQUIRE(!exp == !recv);
+        if (!exp) {
+            return;
+        }
+        BOOST_CHECK(exp->propertyErrors == recv->propertyErrors);
+        BOOST_REQUIRE(exp->studentErrors.size() == recv->studentErrors.size());
+        for (const auto& e : exp->studentErrors) {
+            const auto& r = recv->studentErrors.at(e.first);
+            BOOST_CHECK(e.second.propertyErrors == r.propertyErrors);
+            BOOST_CHECK(e.second.gradeErrors == r.gradeErrors);
+        }
+    };
+
+    checkSame();
+    c->setGraduationYear(boost::none);
+    c->setIssueDate(boost::none);
+    checkSame();
+    c->student(1).setDeleted(true);
+    checkSame();
+    c->student(0).grades().setValue(SUBJ_ID_1, boost::none);
+    checkSame();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
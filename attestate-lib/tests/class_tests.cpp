@@ -582,6 +582,93 @@ BOOST_AUTO_TEST_CASE(test_deleted)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_grades_layout)
+{
+    Class c(createClass());
+    const SubjectsLayoutPtr& layout = c.subjectsPlan()->layout();
+    BOOST_CHECK(c.student(0).grades().layout() == layout);
+    BOOST_CHECK(c.student(1).grades().layout() == layout);
+    BOOST_CHECK(c.student(0).grades().value(SUBJ_ID_2) == G_V_2);
+    BOOST_CHECK(c.state() == State::Existing);
+
+    // standalone grades of added student move to plan layout
+    Class::StudentPtr s(new Student(ID::gen()));
+    s->grades().setValue(SUBJ_ID_3, G_V_1);
+    c.append(std::move(s));
+    BOOST_CHECK(c.student(2).grades().layout() == layout);
+    BOOST_CHECK(c.student(2).grades().value(SUBJ_ID_3) == G_V_1);
+
+    // subjects out of plan don't widen shared layout
+    const size_t size = layout->size();
+    BOOST_CHECK_THROW(c.student(0).grades().setValue(ID::gen(), G_V_1), Exception);
+    const ID straySubjectId = ID::gen();
+    Class::StudentPtr stray(new Student(ID::gen()));
+    stray->grades().setValue(straySubjectId, G_V_1);
+    c.append(std::move(stray));
+    BOOST_CHECK(layout->size() == size && c.studentsCount() == 4);
+    BOOST_CHECK(c.student(3).grades().layout() != layout);
+    BOOST_CHECK(c.student(3).grades().value(straySubjectId) == G_V_1);
+
+    // subject added to plan can be graded
+    auto subject = std::make_shared<Subject>(ID::gen(), "Subject 4");
+    c.subjectsPlan()->append(subject);
+    c.student(0).grades().setValue(subject->id(), G_V_1);
+    BOOST_CHECK(c.student(1).grades().layout() == layout && layout->size() == size + 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_grades_layout_of_new_plan)
+{
+    Class c(createClass());
+    Class::StudentPtr s(new Student(ID::gen()));
+    s->grades().setValue(SUBJ_ID_1, G_V_1);
+    c.append(std::move(s));
+    auto plan = std::make_shared<SubjectsPlan>(ID::gen(), "Plan 3", SubjectPtrVector{SUBJ_1});
+    c.setSubjectsPlan(plan);
+    BOOST_CHECK(c.student(2).grades().layout() == plan->layout());
+    // grades of subjects out of new plan are kept in own layouts,
+    // plan layout is left as is
+    BOOST_CHECK(c.student(0).grades().layout() != plan->layout());
+    BOOST_CHECK(c.student(1).grades().layout() != c.student(0).grades().layout());
+    BOOST_CHECK(plan->layout()->size() == 1);
+    BOOST_CHECK(c.student(0).grades().value(SUBJ_ID_2) == G_V_2);
+    BOOST_CHECK(c.student(1).grades().value(SUBJ_ID_3) == G_V_3);
+    BOOST_CHECK(!c.student(0).isModified());
+
+    auto subject = std::make_shared<Subject>(ID::gen(), "Subject 4");
+    plan->append(subject);
+    c.student(0).grades().setValue(subject->id(), G_V_1);
+    c.student(2).grades().setValue(subject->id(), G_V_1);
+    BOOST_CHECK(c.student(0).grades().value(subject->id()) == G_V_1);
+    BOOST_CHECK(c.student(2).grades().value(subject->id()) == G_V_1);
+    BOOST_CHECK(plan->layout()->size() == 2);
+
+    // student erased and inserted back keeps grades out of plan
+    c.insert(c.erase(0), 0);
+    BOOST_CHECK(c.student(0).grades().value(SUBJ_ID_2) == G_V_2);
+    BOOST_CHECK(plan->layout()->size() == 2);
+
+    // without plan any subject can be graded
+    c.setSubjectsPlan(nullptr);
+    BOOST_CHECK(c.student(1).grades().layout()->isOpen());
+    c.student(1).grades().setValue(ID::gen(), G_V_1);
+    BOOST_CHECK(c.student(1).grades().value(SUBJ_ID_2) == G_V_2_2);
+}
+
+BOOST_AUTO_TEST_CASE(test_grades_layout_of_moved_student)
+{
+    Class from(createClass());
+    Class to(ID::gen());
+    to.setSubjectsPlan(createSubjectsPlan2());
+    to.append(from.erase(0));
+    BOOST_CHECK(to.student(0).grades().layout() == to.subjectsPlan()->layout());
+    BOOST_CHECK(to.student(0).grades().value(SUBJ_ID_1) == G_V_1);
+
+    auto subject = std::make_shared<Subject>(ID::gen(), "Subject 4");
+    to.subjectsPlan()->append(subject);
+    to.student(0).grades().setValue(subject->id(), G_V_1);
+    BOOST_CHECK(to.student(0).grades().value(subject->id()) == G_V_1);
+}
+
 BOOST_AUTO_TEST_CASE(test_save)
 {
     {
@@ -636,6 +723,13 @@ BOOST_AUTO_TEST_CASE(test_save)
         for (auto sp : c.studentsList()) {
             BOOST_CHECK(!sp->isModified() && sp->state() == State::Existing);
         }
+
+        // saved students are original now
+        c.erase(1);
+        BOOST_CHECK(c.areStudentsModified());
+        c.save();
+        BOOST_CHECK(c.state() == State::Existing);
+        checkStudentsList(c, {STUDENT_ID_1});
     }
 }
 
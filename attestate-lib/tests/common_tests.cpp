@@ -0,0 +1,99 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include <attestate/common.h>
+#include <attestate/exception.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace attestate;
+
+BOOST_AUTO_TEST_SUITE(common_tests)
+
+BOOST_AUTO_TEST_CASE(test_gen_concurrent)
+{
+    const size_t THREADS = 4;
+    const size_t IDS = 5000;
+
+    std::vector<std::vector<OID>> oids(THREADS);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&oids, t, IDS] {
+            for (size_t i = 0; i < IDS; ++i) {
+                oids[t].push_back(ID::gen().oid());
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::vector<OID> all;
+    for (const auto& o : oids) {
+        BOOST_CHECK(std::is_sorted(o.begin(), o.end()));
+        all.insert(all.end(), o.begin(), o.end());
+    }
+    std::sort(all.begin(), all.end());
+    BOOST_CHECK(std::adjacent_find(all.begin(), all.end()) == all.end());
+    BOOST_CHECK(all.front() != ID::emptyID().oid());
+}
+
+BOOST_AUTO_TEST_CASE(test_reserve)
+{
+    IDBlock block = ID::reserve(3);
+    BOOST_REQUIRE(block.size() == 3);
+
+    const ID first = block.gen();
+    BOOST_CHECK(block.gen().oid() == first.oid() + 1);
+    BOOST_CHECK(block.gen().oid() == first.oid() + 2);
+    BOOST_CHECK(block.empty());
+    BOOST_CHECK_THROW(block.gen(), Exception);
+
+    BOOST_CHECK(ID::gen() != first);
+    BOOST_CHECK(ID::reserve(1).gen().oid() > first.oid() + 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_scoped_block)
+{
+    auto genFrom = [] (IDBlock& block)
+    {
+        ScopedIDBlock scope(block);
+        std::vector<OID> oids;
+        for (size_t i = 0; i < 4; ++i) {
+            oids.push_back(ID::gen().oid());
+        }
+        return oids;
+    };
+
+    IDBlock block1 = ID::reserve(4);
+    IDBlock block2 = ID::reserve(4);
+    const OID first1 = IDBlock(block1).gen().oid();
+    const OID first2 = IDBlock(block2).gen().oid();
+
+    const auto oids1 = genFrom(block1);
+    const auto oids2 = genFrom(block2);
+    for (size_t i = 0; i < 4; ++i) {
+        BOOST_CHECK(oids1[i] - first1 == oids2[i] - first2);
+    }
+    BOOST_CHECK(block1.empty() && block2.empty());
+
+    {
+        ScopedIDBlock scope(block1);
+        BOOST_CHECK_THROW(ID::gen(), Exception);
+
+        IDBlock inner = ID::reserve(1);
+        {
+            ScopedIDBlock innerScope(inner);
+            ID::gen();
+        }
+        BOOST_CHECK(inner.empty());
+        BOOST_CHECK_THROW(ID::gen(), Exception);
+    }
+    BOOST_CHECK_NO_THROW(ID::gen());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include <attestate/db.h>
+#include <attestate/class.h>
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+#include <attestate/grades.h>
+
+#include "helpers.h"
+
+#include <QTemporaryDir>
+
+using namespace attestate;
+
+BOOST_AUTO_TEST_SUITE(db_tests)
+
+const grades::Value G_4 = "4";
+const grades::Value G_5 = "5";
+
+struct DBFixture {
+    DBFixture()
+        : path(dir.filePath("db_test.sqlite"))
+    {
+        BOOST_REQUIRE(dir.isValid());
+
+        s1 = std::make_shared<Subject>(ID::gen(), "Subject 1", "S1");
+        s2 = std::make_shared<Subject>(ID::gen(), "Subject 2");
+        plan = std::make_shared<SubjectsPlan>(ID::gen(), "Plan", SubjectPtrVector{s1, s2});
+        cls = createGradedClass(plan, {{s1->id(), G_5}, {s2->id(), G_4}}, 3, QDate(2016, 6, 25));
+    }
+
+    QTemporaryDir dir;
+    QString path;
+    SubjectPtr s1;
+    SubjectPtr s2;
+    SubjectsPlanPtr plan;
+    std::unique_ptr<Class> cls;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_round_trip, DBFixture)
+{
+    db::Database database(path);
+    // class, plan, 2 plan subjects, 2 subjects, 3 students with 2 grades and class update
+    BOOST_CHECK_EQUAL(database.save(*cls), 1 + 1 + 2 + 2 + 3 * 3 + 1);
+    BOOST_CHECK(cls->id().dbid() != 0);
+    BOOST_CHECK(cls->state() == State::Existing);
+    BOOST_CHECK(cls->student(0).id().dbid() != 0);
+    BOOST_CHECK(s1->id().dbid() != 0);
+
+    // nothing changed
+    BOOST_CHECK_EQUAL(database.save(*cls), 0u);
+
+    db::Database other(path);
+    BOOST_REQUIRE_EQUAL(other.classIds().size(), 1u);
+    auto loaded = other.load(cls->id().dbid());
+    BOOST_CHECK(loaded->state() == State::Existing);
+    BOOST_CHECK(loaded->classId() == "11A");
+    BOOST_CHECK(equals(loaded->graduationYear(), OptionalYear(2016)));
+    BOOST_CHECK(!loaded->issueDate());
+    BOOST_REQUIRE_EQUAL(loaded->studentsCount(), 3u);
+    BOOST_REQUIRE_EQUAL(loaded->subjectsPlan()->subjectsCount(), 2u);
+    BOOST_CHECK(loaded->subjectsPlan()->at(0).name() == "Subject 1");
+    BOOST_CHECK(loaded->subjectsPlan()->at(0).shortenedName() == "S1");
+
+    const ID loadedS2 = loaded->subjectsPlan()->at(1).id();
+    for (size_t i = 0; i < 3; ++i) {
+        const Student& s = loaded->student(i);
+        BOOST_CHECK_EQUAL(s.id().dbid(), cls->student(i).id().dbid());
+        BOOST_CHECK(s.familyName() == "Family" + QString::number(i));
+        BOOST_CHECK(s.birthDate() == QDate(1998, 1, 1 + i));
+        BOOST_CHECK(equals(s.issueDate(), OptionalDate(QDate(2016, 6, 25))));
+        BOOST_CHECK(equals(s.grades().value(loadedS2), grades::OptionalValue(G_4)));
+    }
+
+    // plans are shared by classes of one database
+    auto again = other.load(cls->id().dbid());
+    BOOST_CHECK(again->subjectsPlan() == loaded->subjectsPlan());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_incremental_save, DBFixture)
+{
+    db::Database database(path);
+    database.save(*cls);
+
+    cls->student(1).grades().setValue(s2->id(), G_5);
+    BOOST_CHECK_EQUAL(database.save(*cls), 1u);
+
+    cls->student(2).grades().setValue(s1->id(), boost::none);
+    cls->student(0).setName("Renamed");
+    BOOST_CHECK_EQUAL(database.save(*cls), 2u);
+
+    auto loaded = db::Database(path).load(cls->id().dbid());
+    const ID loadedS1 = loaded->subjectsPlan()->at(0).id();
+    const ID loadedS2 = loaded->subjectsPlan()->at(1).id();
+    BOOST_CHECK(equals(loaded->student(1).grades().value(loadedS2), grades::OptionalValue(G_5)));
+    BOOST_CHECK(!loaded->student(2).grades().value(loadedS1));
+    BOOST_CHECK(loaded->student(0).name() == "Renamed");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_students_order, DBFixture)
+{
+    db::Database database(path);
+    database.save(*cls);
+
+    const DBID erased = cls->student(0).id().dbid();
+    cls->erase(0);
+    cls->insert(Class::StudentPtr(new Student(ID::gen())), 1);
+    cls->student(0).setDeleted(true);
+    database.save(*cls);
+    BOOST_REQUIRE_EQUAL(cls->studentsCount(), 2u);
+
+    auto loaded = db::Database(path).load(cls->id().dbid());
+    BOOST_REQUIRE_EQUAL(loaded->studentsCount(), 2u);
+    BOOST_CHECK(loaded->student(0).id().dbid() != erased);
+    BOOST_CHECK_EQUAL(loaded->student(0).id().dbid(), cls->student(0).id().dbid());
+    BOOST_CHECK(loaded->student(0).familyName().isEmpty());
+    BOOST_CHECK(loaded->student(1).familyName() == "Family2");
+
+    // student moved within class is not modified, only its position is written
+    cls->append(cls->erase(0));
+    BOOST_CHECK_EQUAL(database.save(*cls), 2u);
+    loaded = db::Database(path).load(cls->id().dbid());
+    BOOST_REQUIRE_EQUAL(loaded->studentsCount(), 2u);
+    BOOST_CHECK(loaded->student(0).familyName() == "Family2");
+    BOOST_CHECK_EQUAL(loaded->student(1).id().dbid(), cls->student(1).id().dbid());
+
+    cls->setDeleted(true);
+    database.save(*cls);
+    BOOST_CHECK(database.classIds().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,7 +16,12 @@
 
 #include "helpers.h"
 
+#include <QDir>
+
+#include <atomic>
+#include <chrono>
 #include <initializer_list>
+#include <thread>
 
 using namespace attestate;
 
@@ -216,6 +221,136 @@ BOOST_AUTO_TEST_CASE(test)
         gen::fillTemplate(*c, i, *doc);
         check(*doc, c->student(i), *c);
     }
+
+    // same result, capacities of changed tables are bound
+    gen::BoundTemplate bound(*doc);
+    BOOST_CHECK(&bound.doc() == doc.get());
+    for (size_t i = c->studentsCount(); i > 0; --i) {
+        bound.fill(*c, i - 1);
+        check(*doc, c->student(i - 1), *c);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_batch)
+{
+    auto c = csv::read(
+        "../../tests/data/generate_data.csv",
+        csv::Params{';', "dd.MM.yyyy"});
+    BOOST_REQUIRE(c->studentsCount() > 1);
+    c->student(1).setDeleted(true);
+
+    QDir dir(QDir::temp().filePath("attestate-batch-test"));
+    dir.removeRecursively();
+    BOOST_REQUIRE(QDir::temp().mkpath(dir.path()));
+
+    // no test assertions in worker threads
+    std::atomic<size_t> maxDone(0);
+    std::atomic<bool> isTotalValid(true);
+    auto res = gen::generate(
+        *c,
+        gen::BatchParams{"../../../doctpl-lib/tests/data/11kl_2016.xml", dir.path(), 4},
+        [&] (size_t done, size_t total)
+        {
+            if (done > total || total != c->studentsCount() - 1) {
+                isTotalValid = false;
+            }
+            size_t prev = maxDone;
+            while (prev < done && !maxDone.compare_exchange_weak(prev, done)) {}
+        });
+
+    BOOST_CHECK(!res.isCancelled);
+    BOOST_CHECK_MESSAGE(res.errors.empty(), res.errors.size() << " students failed");
+    BOOST_CHECK(res.generated == c->studentsCount() - 1);
+    BOOST_CHECK(maxDone == c->studentsCount() - 1 && isTotalValid);
+    for (size_t i = 0; i < c->studentsCount(); ++i) {
+        BOOST_CHECK(i == 1 || dir.exists(gen::pdfFileName(c->student(i))));
+    }
+
+    std::atomic<bool> cancel(true);
+    auto cancelled = gen::generate(
+        *c,
+        gen::BatchParams{"../../../doctpl-lib/tests/data/11kl_2016.xml", dir.path(), 2},
+        nullptr,
+        &cancel);
+    BOOST_CHECK(cancelled.isCancelled && cancelled.generated == 0);
+
+    // bad template fails before printing
+    BOOST_REQUIRE(dir.removeRecursively() && QDir::temp().mkpath(dir.path()));
+    BOOST_CHECK_THROW(
+        gen::generate(*c, gen::BatchParams{dir.filePath("missing.xml"), dir.path(), 2}),
+        std::exception);
+    BOOST_CHECK(dir.entryList(QDir::Files).isEmpty());
+
+    dir.removeRecursively();
+}
+
+BOOST_AUTO_TEST_CASE(test_job)
+{
+    auto c = csv::read(
+        "../../tests/data/generate_data.csv",
+        csv::Params{';', "dd.MM.yyyy"});
+    const size_t total = c->studentsCount();
+
+    QDir dir(QDir::temp().filePath("attestate-job-test"));
+    dir.removeRecursively();
+    BOOST_REQUIRE(QDir::temp().mkpath(dir.path()));
+    const gen::BatchParams params{"../../../doctpl-lib/tests/data/11kl_2016.xml", dir.path(), 2};
+
+    std::atomic<size_t> callbacks(0);
+    {
+        gen::GenerationJob job(*c, params, [&] (const gen::JobProgress&) { ++callbacks; });
+        BOOST_CHECK_THROW(job.wait(), Exception);
+
+        // paused before start, nothing is generated until resumed
+        job.pause();
+        job.start();
+        BOOST_CHECK_THROW(job.start(), Exception);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        BOOST_CHECK(job.isPaused() && job.progress().done == 0);
+        BOOST_CHECK(job.progress().etaSeconds < 0);
+
+        job.resume();
+        auto res = job.wait();
+        BOOST_CHECK(job.isFinished());
+        BOOST_CHECK(!res.isCancelled && res.errors.empty());
+        BOOST_CHECK_EQUAL(res.generated, total);
+        BOOST_CHECK_EQUAL(res.generatedStudents.size(), total);
+
+        const auto progress = job.progress();
+        BOOST_CHECK(progress.done == total && progress.total == total && progress.failed == 0);
+        BOOST_CHECK(progress.studentsPerSecond > 0 && progress.etaSeconds == 0);
+        BOOST_CHECK_EQUAL(callbacks, total);
+    }
+    {
+        // time paused before start is not counted
+        gen::GenerationJob job(*c, params);
+        job.pause();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        job.resume();
+        job.pause();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        job.start();
+        job.resume();
+        job.wait();
+        const auto progress = job.progress();
+        BOOST_CHECK(progress.done == total && progress.studentsPerSecond > 0);
+    }
+    {
+        // cancel wakes paused workers
+        gen::GenerationJob job(*c, params);
+        job.pause();
+        job.start();
+        job.cancel();
+        auto res = job.wait();
+        BOOST_CHECK(res.isCancelled && res.generated == 0 && res.generatedStudents.empty());
+    }
+    {
+        gen::GenerationJob job(*c, gen::BatchParams{params.templatePath, dir.filePath("none"), 1});
+        job.start();
+        BOOST_CHECK_THROW(job.wait(), Exception);
+    }
+
+    dir.removeRecursively();
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -165,6 +165,175 @@ BOOST_AUTO_TEST_CASE(test_diff)
     BOOST_CHECK(g1.value(ID_4) == NO_GRADE);
 }
 
+BOOST_AUTO_TEST_CASE(test_modification_tracking)
+{
+    const ID ID_1 = ID::gen();
+    const ID ID_2 = ID::gen();
+    const ID ID_3 = ID::gen();
+
+    SubjectsGrades g({{ID_1, G_5}, {ID_2, G_4}});
+    BOOST_CHECK(!g.isModified());
+
+    g.setValue(ID_1, G_5); // same value
+    BOOST_CHECK(!g.isModified() && !g.isModified(ID_1));
+
+    g.setValue(ID_1, G_3);
+    g.setValue(ID_3, G_T);
+    BOOST_CHECK(g.isModified());
+    BOOST_CHECK(g.isModified(ID_1) && !g.isModified(ID_2) && g.isModified(ID_3));
+    BOOST_CHECK(g.isModifiedAt(*g.layout()->find(ID_3)) && !g.isModifiedAt(*g.layout()->find(ID_2)));
+    BOOST_CHECK(!g.isModifiedAt(g.layout()->size()));
+
+    g.setValue(ID_1, G_4);
+    BOOST_CHECK(g.isModified(ID_1));
+    g.setValue(ID_1, G_5); // reverted
+    g.setValue(ID_3, NO_GRADE);
+    BOOST_CHECK(!g.isModified() && !g.isModified(ID_1) && !g.isModified(ID_3));
+    BOOST_CHECK(!g.isModifiedAt(*g.layout()->find(ID_1)));
+
+    g.setValue(ID_2, NO_GRADE);
+    BOOST_CHECK(g.isModified(ID_2));
+    g.save();
+    BOOST_CHECK(!g.isModified());
+    g.setValue(ID_2, G_4);
+    BOOST_CHECK(g.isModified(ID_2));
+    g.save();
+
+    // diffs
+
+    SubjectsGrades other({{ID_1, G_4}, {ID_3, G_3}});
+    auto diff = g.diff(other);
+    g.applyDiff(diff);
+    BOOST_CHECK(g.isModified(ID_1) && g.isModified(ID_2) && g.isModified(ID_3));
+    g.applyDiff(grades::reverseDiff(diff));
+    BOOST_CHECK(!g.isModified());
+
+    // assignment is tracked against saved values
+
+    g = other;
+    BOOST_CHECK(g.isModified(ID_1) && g.isModified(ID_2) && g.isModified(ID_3));
+    g = SubjectsGrades({{ID_1, G_5}, {ID_2, G_4}});
+    BOOST_CHECK(!g.isModified());
+}
+
+BOOST_AUTO_TEST_CASE(test_shared_layout)
+{
+    const ID ID_1 = ID::gen();
+    const ID ID_2 = ID::gen();
+    const ID ID_3 = ID::gen();
+    const grades::Value G_BAD = "7";
+
+    auto layout = std::make_shared<SubjectsLayout>(std::vector<ID>{ID_1, ID_2});
+    BOOST_CHECK(layout->size() == 2 && *layout->find(ID_2) == 1 && !layout->find(ID_3));
+
+    SubjectsGrades g1(layout, {{ID_1, G_5}, {ID_2, G_BAD}});
+    SubjectsGrades g2(layout, {{ID_2, G_4}});
+
+    BOOST_CHECK(g1.code(ID_1) == grades::code(G_5));
+    BOOST_CHECK(g1.code(ID_2) == grades::INVALID_CODE);
+    BOOST_CHECK(g1.value(ID_2) == G_BAD);
+    BOOST_CHECK(g2.code(ID_1) == grades::NO_CODE);
+    BOOST_CHECK(g2.code(ID_3) == grades::NO_CODE);
+    BOOST_CHECK(g1.codes().size() == 2);
+
+    // subject out of plan layout is rejected, layout is not widened
+
+    BOOST_CHECK_THROW(g2.setValue(ID_3, G_T), Exception);
+    BOOST_CHECK_THROW(SubjectsGrades(layout, {{ID_3, G_T}}), Exception);
+    BOOST_CHECK(layout->size() == 2 && !g2.value(ID_3) && !g2.isModified());
+
+    // added to plan
+    layout->slot(ID_3);
+    g2.setValue(ID_3, G_T);
+    BOOST_CHECK(layout->size() == 3 && layout->subjectId(2) == ID_3);
+    BOOST_CHECK(g2.value(ID_3) == G_T && g1.value(ID_3) == NO_GRADE);
+
+    auto diff = g1.diff(g2);
+    BOOST_REQUIRE(diff.size() == 3);
+    BOOST_CHECK(diff.at(ID_1).first == G_5 && diff.at(ID_1).second == NO_GRADE);
+    BOOST_CHECK(diff.at(ID_2).first == G_BAD && diff.at(ID_2).second == G_4);
+    BOOST_CHECK(diff.at(ID_3).first == NO_GRADE && diff.at(ID_3).second == G_T);
+
+    // same diff with separate layouts
+
+    SubjectsGrades g3({{ID_3, G_T}, {ID_2, G_4}});
+    BOOST_CHECK(g1.diff(g3) == diff);
+
+    g1.applyDiff(diff);
+    BOOST_CHECK(g1.diff(g2).empty());
+    checkGradeValues(g1, {ID_1, ID_2, ID_3}, {NO_GRADE, G_4, G_T});
+}
+
+BOOST_AUTO_TEST_CASE(test_standalone_layout)
+{
+    const ID ID_1 = ID::gen();
+    const ID ID_2 = ID::gen();
+
+    // default grades share empty layout until first value
+    SubjectsGrades g1;
+    SubjectsGrades g2;
+    BOOST_CHECK(g1.layout() == g2.layout() && g1.layout()->isOpen());
+    g1.setValue(ID_1, G_5);
+    BOOST_CHECK(g1.layout() != g2.layout() && g2.layout()->size() == 0);
+
+    // copies don't widen layouts of each other
+    SubjectsGrades g3(g1);
+    g3.setValue(ID_2, G_4);
+    BOOST_CHECK(g1.layout()->size() == 1 && g3.layout()->size() == 2);
+
+    // moved to plan layout with values and modifications
+    auto plan = std::make_shared<SubjectsLayout>(std::vector<ID>{ID_2, ID_1});
+    g3.setLayout(plan);
+    BOOST_CHECK(g3.layout() == plan && !plan->isOpen() && plan->size() == 2);
+    BOOST_CHECK(g3.value(ID_1) == G_5 && g3.value(ID_2) == G_4);
+    BOOST_CHECK(g3.isModified(ID_1) && g3.isModified(ID_2));
+    BOOST_CHECK(g3.codes().at(0) == grades::code(G_4));
+
+    // subjects absent from plan
+    SubjectsGrades g4({{ID::gen(), G_3}});
+    BOOST_CHECK_THROW(g4.setLayout(plan), Exception);
+    BOOST_CHECK(plan->size() == 2 && g4.layout()->isOpen());
+
+    // empty grades take layout of assigned ones
+    g2 = g3;
+    BOOST_CHECK(g2.layout() == plan && g2.value(ID_2) == G_4);
+}
+
+BOOST_AUTO_TEST_CASE(test_move_and_swap)
+{
+    const ID ID_1 = ID::gen();
+    const ID ID_2 = ID::gen();
+
+    SubjectsGrades g1;
+    g1.setValue(ID_1, G_5);
+    SubjectsGrades g2;
+    g2.setValue(ID_2, G_3);
+    g2.save();
+
+    std::swap(g1, g2);
+    BOOST_CHECK(g1.value(ID_2) == G_3 && !g1.value(ID_1) && !g1.isModified());
+    BOOST_CHECK(g2.value(ID_1) == G_5 && !g2.value(ID_2) && g2.isModified(ID_1));
+
+    // assignment into moved-from object
+    SubjectsGrades g3(std::move(g1));
+    g1 = std::move(g2);
+    BOOST_CHECK(g1.value(ID_1) == G_5 && g1.isModified(ID_1));
+    g2 = g3;
+    BOOST_CHECK(g2.value(ID_2) == G_3 && !g2.isModified());
+}
+
+BOOST_AUTO_TEST_CASE(test_codes)
+{
+    for (const grades::Value& v : grades::validValues()) {
+        const grades::Code c = grades::code(v);
+        BOOST_CHECK(c != grades::NO_CODE && c != grades::INVALID_CODE);
+        BOOST_CHECK(grades::value(c) == v);
+    }
+    BOOST_CHECK(grades::code("") == grades::INVALID_CODE);
+    BOOST_CHECK_THROW(grades::value(grades::NO_CODE), Exception);
+    BOOST_CHECK_THROW(grades::value(grades::INVALID_CODE), Exception);
+}
+
 BOOST_AUTO_TEST_CASE(test_erase_nonexistent_grade)
 {
     const ID ID_1 = ID::gen();
@@ -216,4 +385,34 @@ BOOST_AUTO_TEST_CASE(test_types)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_code_overloads)
+{
+    BOOST_CHECK(grades::validValues().size() == 9);
+    for (const grades::Value& v : grades::validValues()) {
+        const grades::Code c = grades::code(v);
+        BOOST_CHECK(grades::isValid(c));
+        BOOST_CHECK(grades::type(c) == grades::type(v));
+        if (grades::type(c) == grades::Type::HasRepresentation) {
+            BOOST_CHECK(grades::representation(c) == grades::representation(v));
+            BOOST_CHECK(grades::representation(c).startsWith(v));
+        } else {
+            BOOST_CHECK_THROW(grades::representation(c), Exception);
+        }
+    }
+    BOOST_CHECK(grades::representation(grades::code(G_4)) == QString::fromUtf8("4 (хорошо)"));
+
+    BOOST_CHECK(!grades::isValid(grades::NO_CODE) && !grades::isValid(grades::INVALID_CODE));
+    // codes follow the table without gaps
+    const grades::Code maxCode = grades::validValues().size();
+    BOOST_CHECK(grades::isValid(maxCode) && !grades::isValid(grades::Code(maxCode + 1)));
+    BOOST_CHECK(grades::value(1) == G_5 && grades::value(maxCode) == "-");
+    BOOST_CHECK_THROW(grades::value(grades::Code(maxCode + 1)), Exception);
+    BOOST_CHECK_THROW(grades::type(grades::Code(maxCode + 1)), Exception);
+    BOOST_CHECK(grades::code("55") == grades::INVALID_CODE);
+    BOOST_CHECK(!grades::isValid("55") && !grades::isValid("7"));
+    BOOST_CHECK_THROW(grades::type(grades::INVALID_CODE), Exception);
+    BOOST_CHECK_THROW(grades::type("7"), Exception);
+    BOOST_CHECK_THROW(grades::representation("7"), Exception);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,7 +1,32 @@
 #include "helpers.h"
 
+#include <attestate/student.h>
+
+#include <vector>
+
 using namespace attestate;
 
 namespace std {
 
 } // namespace std
+
+std::unique_ptr<Class> createGradedClass(
+    const SubjectsPlanPtr& plan,
+    const std::map<ID, grades::Value>& grades,
+    size_t studentsCount,
+    const OptionalDate& studentsIssueDate)
+{
+    std::vector<Class::StudentPtr> students;
+    for (size_t i = 0; i < studentsCount; ++i) {
+        students.emplace_back(new Student(
+            ID::gen(),
+            "Family" + QString::number(i), "Name", "Parental",
+            QDate(1998, 1, 1 + i),
+            SubjectsGrades(plan->layout(), grades),
+            boost::none,
+            "000000" + QString::number(i),
+            studentsIssueDate));
+    }
+    return std::unique_ptr<Class>(new Class(
+        ID::gen(), "11A", Year(2016), boost::none, std::move(students), plan));
+}
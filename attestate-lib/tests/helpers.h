@@ -3,11 +3,16 @@
 #include "../src/helpers.h"
 
 #include <attestate/common.h>
+#include <attestate/class.h>
+#include <attestate/grades.h>
+#include <attestate/subjects.h>
 
 #include <boost/optional.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include <iostream>
+#include <map>
+#include <memory>
 
 #include <QApplication>
 
@@ -47,3 +52,11 @@ bool equals(const boost::optional<T>& l, const boost::optional<T>& r)
     return (!l && !r) || (l &&r && *l == *r);
 }
 
+// Existing class "11A" of 2016 with students "Family<i>" "Name" "Parental",
+// born 1998-01-<i + 1>, attestate ids "000000<i>" and same grades
+// on plan layout
+std::unique_ptr<attestate::Class> createGradedClass(
+    const attestate::SubjectsPlanPtr& plan,
+    const std::map<attestate::ID, attestate::grades::Value>& grades,
+    size_t studentsCount = 3,
+    const attestate::OptionalDate& studentsIssueDate = boost::none);
@@ -0,0 +1,189 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include <attestate/journal.h>
+#include <attestate/class.h>
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+#include <attestate/grades.h>
+
+#include "helpers.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+using namespace attestate;
+
+BOOST_AUTO_TEST_SUITE(journal_tests)
+
+const grades::Value G_4 = "4";
+const grades::Value G_5 = "5";
+
+struct JournalFixture {
+    JournalFixture()
+        : basePath(dir.filePath("journal_test.atts"))
+        , journalPath(dir.filePath("journal_test.attj"))
+    {
+        BOOST_REQUIRE(dir.isValid());
+
+        s1 = std::make_shared<Subject>(ID::gen(), "Subject 1");
+        s2 = std::make_shared<Subject>(ID::gen(), "Subject 2");
+        plan = std::make_shared<SubjectsPlan>(ID::gen(), "Plan", SubjectPtrVector{s1, s2});
+        cls = createGradedClass(plan, {{s1->id(), G_5}});
+    }
+
+    // edits of current class, recorded into journal
+    void edit(journal::Journal& j)
+    {
+        cls->student(0).setFamilyName("Changed");
+        j.studentChanged(0, 0, cls->student(0), student::Field::FamilyName);
+
+        auto diff = SubjectsGrades::Diff{{s2->id(), {boost::none, G_4}}};
+        cls->student(1).grades().applyDiff(diff);
+        j.gradesChanged(0, 1, *cls, diff);
+
+        cls->erase(2);
+        j.studentErased(0, 2);
+
+        Class::StudentPtr student(new Student(ID::gen()));
+        student->setName("Inserted");
+        student->grades().setValue(s1->id(), G_4);
+        cls->insert(std::move(student), 0);
+        j.studentInserted(0, 0, *cls);
+
+        cls->setIssueDate(QDate(2016, 6, 25));
+        j.classChanged(0, *cls);
+
+        auto s3 = std::make_shared<Subject>(ID::gen());
+        s3->setName("Subject 3");
+        auto planDiff = SubjectsPlan::Diff{{s1, {0, 1}}, {s2, {1, 2}}, {s3, {boost::none, 0}}};
+        plan->applyDiff(planDiff);
+        j.planChanged(0, planDiff);
+    }
+
+    void checkEdited(const Class& c)
+    {
+        BOOST_REQUIRE_EQUAL(c.studentsCount(), 3u);
+        BOOST_CHECK(c.student(0).name() == "Inserted");
+        BOOST_CHECK(c.student(0).state() == State::New);
+        BOOST_CHECK(c.student(1).familyName() == "Changed");
+        BOOST_CHECK(c.student(1).isFamilyNameModified());
+        BOOST_CHECK(c.student(2).familyName() == "Family1");
+        BOOST_CHECK(equals(c.issueDate(), OptionalDate(QDate(2016, 6, 25))));
+
+        const auto& p = *c.subjectsPlan();
+        BOOST_REQUIRE_EQUAL(p.subjectsCount(), 3u);
+        BOOST_CHECK(p.at(0).name() == "Subject 3");
+        BOOST_CHECK(p.at(0).state() == State::New);
+        BOOST_CHECK(p.at(1).name() == "Subject 1");
+        BOOST_CHECK(equals(c.student(0).grades().value(p.at(1).id()), grades::OptionalValue(G_4)));
+        BOOST_CHECK(equals(c.student(2).grades().value(p.at(2).id()), grades::OptionalValue(G_4)));
+        BOOST_CHECK(c.student(2).isGradeModified(p.at(2).id()));
+    }
+
+    QTemporaryDir dir;
+    QString basePath;
+    QString journalPath;
+    SubjectPtr s1;
+    SubjectPtr s2;
+    SubjectsPlanPtr plan;
+    std::unique_ptr<Class> cls;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_replay, JournalFixture)
+{
+    {
+        journal::Journal j(basePath, journalPath);
+        BOOST_CHECK(j.load().empty());
+        j.compact({cls.get()});
+        edit(j);
+        BOOST_CHECK_EQUAL(j.recordsCount(), 6u);
+        checkEdited(*cls);
+    }
+
+    // as after crash, edits are replayed over base
+    journal::Journal j(basePath, journalPath);
+    auto classes = j.load();
+    BOOST_REQUIRE_EQUAL(classes.size(), 1u);
+    BOOST_CHECK_EQUAL(j.recordsCount(), 6u);
+    checkEdited(*classes[0]);
+
+    // next records are appended after replayed ones
+    classes[0]->student(2).setName("Appended");
+    j.studentChanged(0, 2, classes[0]->student(2), student::Field::Name);
+
+    auto again = journal::Journal(basePath, journalPath).load();
+    BOOST_REQUIRE_EQUAL(again.size(), 1u);
+    checkEdited(*again[0]);
+    BOOST_CHECK(again[0]->student(2).name() == "Appended");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_compaction, JournalFixture)
+{
+    journal::Journal j(basePath, journalPath);
+    j.load();
+    j.compact({cls.get()});
+    edit(j);
+    const qint64 journalSize = QFileInfo(journalPath).size();
+
+    j.compact({cls.get()});
+    BOOST_CHECK_EQUAL(j.recordsCount(), 0u);
+    BOOST_CHECK(QFileInfo(journalPath).size() < journalSize);
+
+    auto classes = journal::Journal(basePath, journalPath).load();
+    BOOST_REQUIRE_EQUAL(classes.size(), 1u);
+    checkEdited(*classes[0]);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_incomplete_record, JournalFixture)
+{
+    {
+        journal::Journal j(basePath, journalPath);
+        j.load();
+        j.compact({cls.get()});
+        edit(j);
+    }
+    // last record is cut by crash
+    const qint64 size = QFileInfo(journalPath).size();
+    BOOST_REQUIRE(QFile::resize(journalPath, size - 3));
+
+    journal::Journal j(basePath, journalPath);
+    auto classes = j.load();
+    BOOST_CHECK_EQUAL(j.recordsCount(), 5u);
+    BOOST_REQUIRE_EQUAL(classes.size(), 1u);
+    BOOST_CHECK_EQUAL(classes[0]->subjectsPlan()->subjectsCount(), 2u);
+    BOOST_CHECK(equals(classes[0]->issueDate(), OptionalDate(QDate(2016, 6, 25))));
+
+    // incomplete record is dropped, so appended records are readable
+    classes[0]->setClassId("11B");
+    j.classChanged(0, *classes[0]);
+    auto again = journal::Journal(basePath, journalPath).load();
+    BOOST_REQUIRE_EQUAL(again.size(), 1u);
+    BOOST_CHECK(again[0]->classId() == "11B");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_journal_of_other_base, JournalFixture)
+{
+    journal::Journal j(basePath, journalPath);
+    j.load();
+    j.compact({cls.get()});
+    edit(j);
+
+    // base replaced, journal is not restarted
+    QFile::remove(basePath);
+    cls->setClassId("Other");
+    cls->save();
+    snapshot::write({cls.get()}, basePath);
+
+    journal::Journal other(basePath, journalPath);
+    auto classes = other.load();
+    BOOST_CHECK_EQUAL(other.recordsCount(), 0u);
+    BOOST_REQUIRE_EQUAL(classes.size(), 1u);
+    BOOST_CHECK(classes[0]->classId() == "Other");
+    BOOST_CHECK(classes[0]->state() == State::Existing);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
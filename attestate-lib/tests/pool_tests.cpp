@@ -0,0 +1,111 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include "../src/pool.h"
+
+#include <attestate/serialize.h>
+#include <attestate/class.h>
+#include <attestate/student.h>
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace attestate;
+
+BOOST_AUTO_TEST_SUITE(pool_tests)
+
+BOOST_AUTO_TEST_CASE(test_scoped_blocks)
+{
+    std::vector<char*> blocks;
+    {
+        pool::ScopedPool scope;
+        for (size_t i = 0; i < 1000; ++i) {
+            blocks.push_back(static_cast<char*>(pool::allocate(40)));
+            std::memset(blocks.back(), int(i % 256), 40);
+        }
+    }
+    // blocks of one chunk follow each other
+    BOOST_CHECK(blocks[1] > blocks[0]);
+    BOOST_CHECK(size_t(blocks[1] - blocks[0]) < 2 * 40);
+
+    // pool is kept by its blocks after scope is left, blocks may be freed in any thread
+    std::thread t([&blocks] {
+        for (size_t i = 0; i < blocks.size(); i += 2) {
+            pool::deallocate(blocks[i]);
+        }
+    });
+    t.join();
+    for (size_t i = 1; i < blocks.size(); i += 2) {
+        BOOST_CHECK_EQUAL(blocks[i][39], char(i % 256));
+        pool::deallocate(blocks[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_nested_and_heap)
+{
+    // no scope
+    void* heap = pool::allocate(16);
+    void* large = nullptr;
+    void* outer = nullptr;
+    void* inner = nullptr;
+    {
+        pool::ScopedPool outerScope;
+        outer = pool::allocate(16);
+        large = pool::allocate(1024 * 1024);
+        {
+            pool::ScopedPool innerScope;
+            inner = pool::allocate(16);
+        }
+        void* next = pool::allocate(16);
+        // outer pool is current again
+        BOOST_CHECK(static_cast<char*>(next) > static_cast<char*>(outer));
+        BOOST_CHECK(static_cast<char*>(next) - static_cast<char*>(outer) < 64);
+        pool::deallocate(next);
+    }
+    pool::deallocate(inner);
+    pool::deallocate(outer);
+    pool::deallocate(large);
+    pool::deallocate(heap);
+    pool::deallocate(nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(test_pooled_class)
+{
+    Class::StudentPtr kept;
+    {
+        auto c = csv::read(
+            "../../tests/data/generate_data.csv",
+            csv::Params{';', "dd.MM.yyyy"});
+        BOOST_REQUIRE(c->studentsCount() > 1);
+        // student taken out of class outlives it
+        kept = c->erase(0);
+        c->student(0).setFamilyName("Changed");
+        BOOST_CHECK(c->student(0).familyName() == "Changed");
+    }
+    kept->setName("Kept");
+    BOOST_CHECK(kept->name() == "Kept");
+    BOOST_CHECK(!kept->grades().layout()->isOpen());
+}
+
+BOOST_AUTO_TEST_CASE(test_kept_student_pins_class_memory)
+{
+    const size_t chunks = pool::chunksCount();
+    Class::StudentPtr kept;
+    {
+        auto c = csv::read(
+            "../../tests/data/generate_data.csv",
+            csv::Params{';', "dd.MM.yyyy"});
+        BOOST_REQUIRE(pool::chunksCount() > chunks);
+        kept = c->erase(0);
+    }
+    // class is destroyed, its chunks are kept by the erased student
+    BOOST_CHECK(pool::chunksCount() > chunks);
+    kept.reset();
+    BOOST_CHECK_EQUAL(pool::chunksCount(), chunks);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
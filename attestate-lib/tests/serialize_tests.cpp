@@ -12,7 +12,11 @@
 
 #include "../src/helpers.h"
 
+#include <QDir>
+
 #include <initializer_list>
+#include <fstream>
+#include <cstdio>
 
 using namespace attestate;
 
@@ -288,4 +292,90 @@ BOOST_AUTO_TEST_CASE(test_with_students_different_issue_dates)
     }
 }
 
+// mapped reader and QTextStream based one
+
+BOOST_AUTO_TEST_CASE(test_read_and_read_stream_are_equal)
+{
+    using namespace cfg::header::tags;
+    const QString d = ";";
+    const QString header = ATTESTATE_ID + d + ISSUE_DATE + d + FAMILY_NAME
+        + d + NAME + d + PARENTAL_NAME + d + BIRTH_DATE
+        + d + SUBJECT_1->name() + d + SUBJECT_2->name() + d + SUBJECT_3->name();
+    const QString text = header + "\r\n"
+        + QString::fromUtf8(" 001 ;01.06.2016;Иванов; Иван ;Иванович;01.02.2000;5; д ;7\r\n")
+        + QString::fromUtf8("002;01.06.2016;Петров;Петр;Петрович;bad date;;Н;4\r\n")
+        + QString::fromUtf8("003;;Сидоров;Сидор;Сидорович;03.04.2000;3;+;-");
+
+    {
+        std::ofstream os("test_raw.csv", std::ios::binary);
+        os << "\xEF\xBB\xBF" << text.toStdString(); // with BOM
+    }
+
+    csv::Params params{';', QString("dd.MM.yyyy")};
+    auto sCls = csv::readStream("test_raw.csv", params);
+    auto mCls = csv::read("test_raw.csv", params);
+
+    BOOST_REQUIRE(mCls->studentsCount() == 3);
+    checkClass(*sCls, *mCls);
+    BOOST_CHECK(sCls->issueDate() == mCls->issueDate());
+    BOOST_CHECK(mCls->issueDate() == QDate(2016, 6, 1));
+    BOOST_CHECK(mCls->subjectsPlan()->at(0).name() == SUBJECT_1->name());
+
+    const auto& s0 = mCls->student(0);
+    BOOST_CHECK(s0.attestateId() == "001" && s0.name() == QString::fromUtf8("Иван"));
+    BOOST_CHECK(!s0.issueDate());
+    const auto& sp = mCls->subjectsPlan();
+    BOOST_CHECK(s0.grades().value(sp->at(1).id()) == G_T_1);
+    BOOST_CHECK(s0.grades().value(sp->at(2).id()) == grades::Value("7"));
+    BOOST_CHECK(mCls->student(1).grades().value(sp->at(0).id()) == boost::none);
+    BOOST_CHECK(mCls->student(1).birthDate().isNull());
+
+    {
+        std::ofstream os("test_raw.csv", std::ios::binary);
+        os << header.toStdString() << "\n001;;A;B;C;01.02.2000;5\n";
+    }
+    BOOST_CHECK_THROW(csv::read("test_raw.csv", params), Exception);
+    BOOST_CHECK_THROW(csv::readStream("test_raw.csv", params), Exception);
+
+    std::remove("test_raw.csv");
+}
+
+BOOST_AUTO_TEST_CASE(test_read_many)
+{
+    QDir dir(QDir::temp().filePath("attestate-read-many-test"));
+    dir.removeRecursively();
+    BOOST_REQUIRE(QDir::temp().mkpath(dir.path()));
+
+    csv::Params params{';', QString("dd.MM.yyyy")};
+    auto cls = createClass();
+    csv::write(*cls, dir.filePath("a.csv"), params);
+    csv::write(*cls, dir.filePath("c.csv"), params);
+    {
+        std::ofstream os(dir.filePath("b.csv").toStdString());
+        os << "broken header\n";
+    }
+
+    auto res = csv::readMany(
+        QStringList{dir.filePath("c.csv"), dir.filePath("b.csv"), dir.filePath("none.csv")},
+        params, 2);
+    BOOST_REQUIRE(res.size() == 3);
+    BOOST_CHECK(res[0].filename == dir.filePath("c.csv") && res[0].error.empty());
+    BOOST_REQUIRE(res[0].cls);
+    checkClass(*cls, *res[0].cls);
+    BOOST_CHECK(!res[1].cls && !res[1].error.empty());
+    BOOST_CHECK(!res[2].cls && !res[2].error.empty());
+
+    auto dirRes = csv::readDir(dir.path(), params);
+    BOOST_REQUIRE(dirRes.size() == 3);
+    BOOST_CHECK(dirRes[0].filename == dir.filePath("a.csv") && dirRes[0].cls);
+    BOOST_CHECK(dirRes[1].filename == dir.filePath("b.csv") && !dirRes[1].cls);
+    BOOST_CHECK(dirRes[2].filename == dir.filePath("c.csv") && dirRes[2].cls);
+    BOOST_CHECK(dirRes[0].cls->id() != dirRes[2].cls->id());
+    // ids of earlier files are reserved first
+    BOOST_CHECK(dirRes[0].cls->id() < dirRes[2].cls->student(0).id());
+    BOOST_CHECK(dirRes[0].cls->student(0).id() < dirRes[2].cls->subjectsPlan()->id());
+
+    dir.removeRecursively();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
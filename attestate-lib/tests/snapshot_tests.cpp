@@ -0,0 +1,188 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include <attestate/snapshot.h>
+#include <attestate/class.h>
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+#include <attestate/grades.h>
+#include <attestate/exception.h>
+
+#include "helpers.h"
+
+#include <QTemporaryDir>
+
+#include <fstream>
+
+using namespace attestate;
+
+BOOST_AUTO_TEST_SUITE(snapshot_tests)
+
+const grades::Value G_4 = "4";
+const grades::Value G_5 = "5";
+const grades::Value G_BAD = "7";
+
+struct Workspace {
+    Workspace()
+    {
+        auto s1 = std::make_shared<Subject>(ID::gen(), "Subject 1", "S1");
+        auto s2 = std::make_shared<Subject>(ID::gen(), "Subject 2");
+        auto s3 = std::make_shared<Subject>(ID::gen(), "Subject 3");
+        plan = std::make_shared<SubjectsPlan>(ID::gen(), "Plan", SubjectPtrVector{s1, s2, s3});
+        c1 = createGradedClass(plan, {{s1->id(), G_5}, {s2->id(), G_BAD}});
+        c1->setIssueDate(QDate(2016, 6, 25));
+        c1->save();
+        c1->setDBID(42);
+        c2.reset(new Class(ID::gen(), "11B", boost::none, boost::none, {}, plan));
+
+        // modifications since load
+        c1->student(0).setFamilyName("Changed");
+        c1->student(0).grades().setValue(s1->id(), G_4);
+        c1->student(1).grades().setValue(s3->id(), G_5);
+        c1->erase(2);
+        c1->append(Class::StudentPtr(new Student(ID::gen())));
+        c1->setIssueDate(boost::none);
+        plan->move(0, 2);
+        s2->setName("Renamed");
+    }
+
+    SubjectsPlanPtr plan;
+    std::unique_ptr<Class> c1;
+    std::unique_ptr<Class> c2;
+};
+
+BOOST_AUTO_TEST_CASE(test_round_trip)
+{
+    Workspace w;
+    QTemporaryDir dir;
+    BOOST_REQUIRE(dir.isValid());
+    const QString path = dir.filePath("snapshot_test.atts");
+    snapshot::write({w.c1.get(), w.c2.get()}, path);
+    auto classes = snapshot::read(path);
+
+    BOOST_REQUIRE(classes.size() == 2);
+    const Class& c1 = *classes[0];
+    const Class& c2 = *classes[1];
+
+    BOOST_CHECK(c1.id() != w.c1->id() && c1.id().dbid() == 42);
+    BOOST_CHECK(c1.state() == State::Modified && c2.state() == State::Existing);
+    BOOST_CHECK(c1.classId() == "11A" && c1.graduationYear() == Year(2016));
+    BOOST_CHECK(!c1.issueDate() && c1.isIssueDateModified());
+    BOOST_CHECK(!c1.isClassIdModified() && c1.areStudentsModified());
+
+    // plan is shared and keeps its modifications
+    BOOST_REQUIRE(c1.subjectsPlan() && c1.subjectsPlan() == c2.subjectsPlan());
+    const SubjectsPlan& plan = *c1.subjectsPlan();
+    BOOST_REQUIRE(plan.subjectsCount() == 3);
+    BOOST_CHECK(plan.areSubjectsModified() && !plan.isNameModified());
+    BOOST_CHECK(plan.at(2).name() == "Subject 1" && plan.at(2).shortenedName() == "S1");
+    BOOST_CHECK(plan.at(0).name() == "Renamed" && plan.at(0).state() == State::Modified);
+    BOOST_CHECK(plan.at(1).state() == State::Existing);
+
+    BOOST_REQUIRE(c1.studentsCount() == 3);
+    const Student& st0 = c1.student(0);
+    BOOST_CHECK(st0.state() == State::Modified);
+    BOOST_CHECK(st0.familyName() == "Changed" && st0.isFamilyNameModified());
+    BOOST_CHECK(!st0.isNameModified());
+    const ID s1 = plan.at(2).id();
+    const ID s2 = plan.at(0).id();
+    const ID s3 = plan.at(1).id();
+    BOOST_CHECK(st0.grades().value(s1) == G_4 && st0.isGradeModified(s1));
+    BOOST_CHECK(st0.grades().value(s2) == G_BAD && !st0.isGradeModified(s2));
+
+    const Student& st1 = c1.student(1);
+    BOOST_CHECK(st1.grades().value(s3) == G_5 && st1.isGradeModified(s3));
+    BOOST_CHECK(!st1.isPersonalInfoModified() && st1.birthDate() == QDate(1998, 1, 2));
+    BOOST_CHECK(st0.grades().layout() == st1.grades().layout());
+    BOOST_CHECK(plan.layout() == st0.grades().layout());
+
+    BOOST_CHECK(c1.student(2).state() == State::New);
+
+    // saving makes it equal to original workspace after save
+    classes[0]->save();
+    BOOST_CHECK(classes[0]->state() == State::Existing);
+    BOOST_CHECK(!classes[0]->student(0).isModified());
+}
+
+BOOST_AUTO_TEST_CASE(test_plan_layout_after_empty_class)
+{
+    Workspace w;
+    QTemporaryDir dir;
+    BOOST_REQUIRE(dir.isValid());
+    const QString path = dir.filePath("snapshot_test.atts");
+    // first class of plan has no students
+    snapshot::write({w.c2.get(), w.c1.get()}, path);
+    auto classes = snapshot::read(path);
+
+    BOOST_REQUIRE(classes.size() == 2);
+    Class& c1 = *classes[1];
+    const SubjectsPlanPtr& plan = c1.subjectsPlan();
+    BOOST_REQUIRE(plan && plan == classes[0]->subjectsPlan());
+    BOOST_CHECK(c1.student(0).grades().layout() == plan->layout());
+    BOOST_CHECK(c1.student(1).grades().layout() == plan->layout());
+
+    auto subject = std::make_shared<Subject>(ID::gen(), "Subject 4");
+    plan->append(subject);
+    c1.student(1).grades().setValue(subject->id(), G_4);
+    BOOST_CHECK(c1.student(1).grades().value(subject->id()) == G_4);
+}
+
+BOOST_AUTO_TEST_CASE(test_standalone_grades)
+{
+    const ID subjectId = ID::gen();
+    Class c(ID::gen());
+    c.append(Class::StudentPtr(new Student(ID::gen())));
+    c.student(0).grades().setValue(subjectId, G_5);
+    QTemporaryDir dir;
+    BOOST_REQUIRE(dir.isValid());
+    const QString path = dir.filePath("snapshot_test.atts");
+    snapshot::write({&c}, path);
+    auto classes = snapshot::read(path);
+
+    BOOST_REQUIRE(classes.size() == 1 && !classes[0]->subjectsPlan());
+    SubjectsGrades& grades = classes[0]->student(0).grades();
+    BOOST_CHECK(grades.layout()->isOpen());
+    BOOST_CHECK(grades.value(subjectId) == G_5);
+
+    // grades without plan take any subject after reading
+    const ID newSubjectId = ID::gen();
+    grades.setValue(newSubjectId, G_4);
+    BOOST_CHECK(grades.value(newSubjectId) == G_4 && grades.value(subjectId) == G_5);
+}
+
+BOOST_AUTO_TEST_CASE(test_bad_file)
+{
+    QTemporaryDir dir;
+    BOOST_REQUIRE(dir.isValid());
+    const QString path = dir.filePath("snapshot_test.atts");
+    {
+        std::ofstream f(path.toStdString(), std::ios::binary);
+        f << "not a snapshot";
+    }
+    BOOST_CHECK_THROW(snapshot::read(path), Exception);
+
+    Workspace w;
+    snapshot::write({w.c1.get()}, path);
+    std::string data;
+    {
+        std::ifstream f(path.toStdString(), std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream f(path.toStdString(), std::ios::binary | std::ios::trunc);
+        f.write(data.data(), data.size() / 2);
+    }
+    BOOST_CHECK_THROW(snapshot::read(path), Exception);
+
+    // unknown version
+    data[5] = char(99);
+    {
+        std::ofstream f(path.toStdString(), std::ios::binary | std::ios::trunc);
+        f.write(data.data(), data.size());
+    }
+    BOOST_CHECK_THROW(snapshot::read(path), Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -29,6 +29,7 @@ BOOST_AUTO_TEST_CASE(test_construction_new)
     BOOST_CHECK(s.issueDate() == boost::none && s.isIssueDateModified());
     BOOST_CHECK(s.grades().diff(SubjectsGrades()).empty());
     BOOST_CHECK(s.areGradesModified());
+    BOOST_CHECK(s.modifiedFields() == student::ALL_FIELDS);
 }
 
 const ID ID_1 = ID::gen();
@@ -218,10 +219,13 @@ BOOST_AUTO_TEST_CASE(test_edit_grades)
         grades.setValue(SUBJ_ID_3, G_V_3);
         BOOST_CHECK(s.state() == State::Modified && s.isModified());
         BOOST_CHECK(s.areGradesModified());
+        BOOST_CHECK(!s.isGradeModified(SUBJ_ID_1));
+        BOOST_CHECK(s.isGradeModified(SUBJ_ID_2) && s.isGradeModified(SUBJ_ID_3));
         grades.setValue(SUBJ_ID_2, G_V_2);
         grades.setValue(SUBJ_ID_3, boost::none);
         BOOST_CHECK(s.state() == State::Existing && !s.isModified());
         BOOST_CHECK(!s.areGradesModified());
+        BOOST_CHECK(!s.isGradeModified(SUBJ_ID_2) && !s.isGradeModified(SUBJ_ID_3));
     }
     {
         Student s(ID::gen());
@@ -371,6 +375,32 @@ BOOST_AUTO_TEST_CASE(test_save_existing)
     BOOST_CHECK(s.issueDate() == ISSUE_DATE_2 && !s.isIssueDateModified());
 }
 
+BOOST_AUTO_TEST_CASE(test_modify_after_save)
+{
+    Student s(createStudent1());
+
+    s.setFamilyName(FNAME_2);
+    s.grades().setValue(SUBJ_ID_2, G_V_2_2);
+    s.save();
+
+    s.setName(NAME_2);
+    BOOST_CHECK(s.state() == State::Modified);
+    BOOST_CHECK(s.familyName() == FNAME_2 && !s.isFamilyNameModified());
+    BOOST_CHECK(s.isNameModified() && !s.areGradesModified());
+
+    s.setName(NAME_1);
+    s.grades().setValue(SUBJ_ID_2, G_V_2);
+    BOOST_CHECK(!s.isNameModified() && s.isGradeModified(SUBJ_ID_2));
+
+    s.grades().setValue(SUBJ_ID_2, G_V_2_2);
+    BOOST_CHECK(s.state() == State::Existing);
+
+    s.save();
+    BOOST_CHECK(s.state() == State::Existing);
+    BOOST_CHECK(s.familyName() == FNAME_2 && s.name() == NAME_1);
+    BOOST_CHECK(s.grades().value(SUBJ_ID_2) == G_V_2_2);
+}
+
 BOOST_AUTO_TEST_CASE(test_delete)
 {
     {
@@ -394,4 +424,22 @@ BOOST_AUTO_TEST_CASE(test_delete)
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_modified_fields)
+{
+    Student s(createStudent1());
+    BOOST_CHECK(s.modifiedFields() == 0);
+
+    s.setName(NAME_2);
+    s.setIssueDate(ISSUE_DATE_2);
+    BOOST_CHECK(s.modifiedFields() ==
+        (student::fieldBit(student::Field::Name) | student::fieldBit(student::Field::IssueDate)));
+    BOOST_CHECK(s.isFieldModified(student::Field::Name) && s.isNameModified());
+    BOOST_CHECK(!s.isFieldModified(student::Field::FamilyName));
+
+    s.setName(NAME_1);
+    BOOST_CHECK(s.modifiedFields() == student::fieldBit(student::Field::IssueDate));
+    s.save();
+    BOOST_CHECK(s.modifiedFields() == 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
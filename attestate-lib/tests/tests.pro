@@ -9,11 +9,19 @@ SOURCES += \
     helpers.cpp \
     grades_tests.cpp \
     unique_vector_tests.cpp \
+    unique_tree_tests.cpp \
     diff_tests.cpp \
     class_tests.cpp \
     serialize_tests.cpp \
     generate_tests.cpp \
-    validation_tests.cpp
+    validation_tests.cpp \
+    class_table_tests.cpp \
+    common_tests.cpp \
+    snapshot_tests.cpp \
+    db_tests.cpp \
+    journal_tests.cpp \
+    undo_tests.cpp \
+    pool_tests.cpp
 
 LIBS += \
     -L../src -lattestate -lboost_unit_test_framework
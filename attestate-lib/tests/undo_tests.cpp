@@ -0,0 +1,205 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include <attestate/undo.h>
+#include <attestate/class.h>
+#include <attestate/student.h>
+#include <attestate/subjects.h>
+#include <attestate/grades.h>
+
+#include "helpers.h"
+
+using namespace attestate;
+
+BOOST_AUTO_TEST_SUITE(undo_tests)
+
+const grades::Value G_4 = "4";
+const grades::Value G_5 = "5";
+
+struct UndoFixture {
+    UndoFixture()
+    {
+        s1 = std::make_shared<Subject>(ID::gen(), "Subject 1");
+        s2 = std::make_shared<Subject>(ID::gen(), "Subject 2");
+        plan = std::make_shared<SubjectsPlan>(ID::gen(), "Plan", SubjectPtrVector{s1, s2});
+        cls = createGradedClass(plan, {{s1->id(), G_5}});
+    }
+
+    SubjectPtr s1;
+    SubjectPtr s2;
+    SubjectsPlanPtr plan;
+    std::unique_ptr<Class> cls;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_undo_redo, UndoFixture)
+{
+    undo::Stack stack(*cls);
+
+    stack.setGrade(0, s1->id(), G_4);
+    stack.setGrade(1, s2->id(), G_5);
+    stack.setField(2, student::Field::FamilyName, DataString("Changed"));
+    stack.setField(2, student::Field::IssueDate, OptionalDate(QDate(2016, 6, 25)));
+    stack.setIssueDate(QDate(2016, 6, 20));
+    BOOST_CHECK_EQUAL(stack.undoCount(), 5u);
+
+    // no changes, nothing recorded
+    stack.setGrade(0, s1->id(), G_4);
+    stack.setClassId("11A");
+    BOOST_CHECK_EQUAL(stack.undoCount(), 5u);
+
+    auto changes = stack.undo();
+    BOOST_CHECK(changes.isClassChanged);
+    BOOST_CHECK(!cls->issueDate());
+
+    stack.undo();
+    changes = stack.undo();
+    BOOST_CHECK(changes.students == std::set<Class::Index>{2});
+    BOOST_CHECK(cls->student(2).familyName() == "Family2");
+    BOOST_CHECK(!cls->student(2).issueDate());
+
+    stack.undo();
+    stack.undo();
+    BOOST_CHECK(!stack.canUndo());
+    BOOST_CHECK_EQUAL(stack.redoCount(), 5u);
+    BOOST_CHECK(cls->state() == State::Existing);
+    BOOST_CHECK(equals(cls->student(0).grades().value(s1->id()), grades::OptionalValue(G_5)));
+
+    stack.redo();
+    stack.redo();
+    BOOST_CHECK(equals(cls->student(0).grades().value(s1->id()), grades::OptionalValue(G_4)));
+    BOOST_CHECK(equals(cls->student(1).grades().value(s2->id()), grades::OptionalValue(G_5)));
+
+    // new edit discards redo steps
+    stack.setClassId("11B");
+    BOOST_CHECK(!stack.canRedo());
+    BOOST_CHECK_EQUAL(stack.undoCount(), 3u);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_students_and_plan, UndoFixture)
+{
+    undo::Stack stack(*cls);
+
+    Class::StudentPtr student(new Student(ID::gen()));
+    const ID insertedId = student->id();
+    const ID erasedId = cls->student(0).id();
+    stack.insert(std::move(student), 1);
+    stack.erase(0);
+    stack.changeSubjectsPlan({{s1, {0, 1}}, {s2, {1, 0}}});
+
+    BOOST_REQUIRE_EQUAL(cls->studentsCount(), 3u);
+    BOOST_CHECK(cls->student(0).id() == insertedId);
+    BOOST_CHECK(plan->at(0).id() == s2->id());
+
+    auto changes = stack.undo();
+    BOOST_CHECK(changes.isStructureChanged);
+    BOOST_CHECK(plan->at(0).id() == s1->id());
+
+    stack.undo();
+    BOOST_CHECK(cls->student(0).id() == erasedId);
+    stack.undo();
+    BOOST_CHECK_EQUAL(cls->studentsCount(), 3u);
+    BOOST_CHECK(!cls->areStudentsModified());
+
+    stack.redo();
+    stack.redo();
+    BOOST_CHECK(cls->student(0).id() == insertedId);
+    BOOST_CHECK_EQUAL(cls->studentsCount(), 3u);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_groups, UndoFixture)
+{
+    undo::Stack stack(*cls);
+    {
+        undo::Group group(stack);
+        for (size_t i = 0; i < 3; ++i) {
+            stack.setGrade(i, s2->id(), G_4);
+        }
+        {
+            undo::Group nested(stack);
+            stack.setClassId("11B");
+        }
+        BOOST_CHECK_EQUAL(stack.undoCount(), 0u);
+        BOOST_CHECK_THROW(stack.undo(), Exception);
+    }
+    BOOST_CHECK_EQUAL(stack.undoCount(), 1u);
+
+    auto changes = stack.undo();
+    BOOST_CHECK(changes.students == (std::set<Class::Index>{0, 1, 2}));
+    BOOST_CHECK(changes.isClassChanged);
+    BOOST_CHECK(cls->state() == State::Existing);
+
+    // empty group is not a step
+    {
+        undo::Group group(stack);
+    }
+    BOOST_CHECK_EQUAL(stack.undoCount(), 0u);
+    BOOST_CHECK_EQUAL(stack.redoCount(), 1u);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_memory_ceiling, UndoFixture)
+{
+    undo::Stack stack(*cls);
+    stack.setGrade(0, s2->id(), G_4);
+    const size_t stepBytes = stack.bytes();
+    BOOST_CHECK(stepBytes > 0);
+
+    stack.setMaxBytes(stepBytes * 2);
+    stack.setGrade(1, s2->id(), G_4);
+    stack.setGrade(2, s2->id(), G_4);
+    BOOST_CHECK_EQUAL(stack.undoCount(), 2u);
+    BOOST_CHECK(stack.bytes() <= stack.maxBytes());
+
+    // oldest step is dropped, its edit stays
+    stack.undo();
+    stack.undo();
+    BOOST_CHECK(!stack.canUndo());
+    BOOST_CHECK(equals(cls->student(0).grades().value(s2->id()), grades::OptionalValue(G_4)));
+    BOOST_CHECK(!cls->student(1).grades().value(s2->id()));
+
+    stack.clear();
+    BOOST_CHECK_EQUAL(stack.bytes(), 0u);
+    BOOST_CHECK(!stack.canRedo());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_step_over_ceiling, UndoFixture)
+{
+    undo::Stack stack(*cls);
+    stack.setGrade(0, s2->id(), G_4);
+    stack.setMaxBytes(1);
+    BOOST_CHECK_EQUAL(stack.undoCount(), 1u);
+
+    // bulk edit larger than ceiling replaces older steps and can be undone
+    {
+        undo::Group group(stack);
+        for (Class::Index i = 0; i < cls->studentsCount(); ++i) {
+            stack.setField(i, student::Field::Name, DataString("Changed"));
+        }
+    }
+    BOOST_CHECK_EQUAL(stack.undoCount(), 1u);
+    BOOST_CHECK(stack.bytes() > stack.maxBytes());
+
+    auto changes = stack.undo();
+    BOOST_CHECK(changes.students == (std::set<Class::Index>{0, 1, 2}));
+    BOOST_CHECK(cls->student(2).name() == "Name");
+    BOOST_CHECK(equals(cls->student(0).grades().value(s2->id()), grades::OptionalValue(G_4)));
+
+    // it is kept for redo
+    stack.setMaxBytes(0);
+    BOOST_CHECK_EQUAL(stack.redoCount(), 1u);
+    stack.redo();
+    BOOST_CHECK(cls->student(2).name() == "Changed");
+}
+
+BOOST_AUTO_TEST_CASE(test_field_values)
+{
+    Student s(ID::gen());
+    undo::setFieldValue(s, student::Field::GraduationYear, OptionalYear(2016));
+    BOOST_CHECK(equals(s.graduationYear(), OptionalYear(2016)));
+    BOOST_CHECK(undo::fieldValue(s, student::Field::GraduationYear) == undo::FieldValue(OptionalYear(2016)));
+    BOOST_CHECK_THROW(
+        undo::setFieldValue(s, student::Field::BirthDate, DataString("1998-01-01")), Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,287 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_NO_MAIN
+
+#include <boost/test/unit_test.hpp>
+
+#include "../src/unique_tree.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <initializer_list>
+
+using namespace attestate;
+
+// tests of helper class UniqueTree
+
+// with copyable type
+
+BOOST_AUTO_TEST_SUITE(unique_tree_tests_copyable)
+
+typedef UniqueTree<std::string> StringTree;
+
+void checkTree(const StringTree& v, std::initializer_list<std::string> exp)
+{
+    BOOST_REQUIRE_MESSAGE(
+        v.size() == exp.size(),
+        "Size mismatch, expected " << exp.size() << ", received " << v.size());
+
+    BOOST_CHECK(v.empty() == (exp.size() == 0));
+
+    size_t at = 0;
+    for (auto i : exp) {
+        BOOST_CHECK_MESSAGE(
+            v.at(at) == i,
+            "Value mismatch at " << at << ", expected " << i << ", received " << v.at(at));
+        ++at;
+        BOOST_CHECK_MESSAGE(v.contains(i), "Value " << i << " is expected");
+    }
+
+    std::vector<std::string> traversed;
+    v.forEach([&traversed] (const std::string& s) { traversed.push_back(s); });
+    BOOST_CHECK(std::equal(traversed.begin(), traversed.end(), exp.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(test_create)
+{
+    StringTree v0;
+    checkTree(v0, {});
+
+    std::vector<std::string> c = {"3", "-3", "0", "4"};
+    StringTree v(c);
+    checkTree(v, {"3", "-3", "0", "4"});
+
+    std::vector<std::string> cd = {"3", "3", "0", "4"};
+    std::unique_ptr<StringTree> vd;
+    BOOST_CHECK_THROW(vd.reset(new StringTree(cd)), Exception);
+}
+
+BOOST_AUTO_TEST_CASE(test_copy_and_move)
+{
+    std::vector<std::string> c = {"3", "-3", "0", "4"};
+    std::unique_ptr<StringTree> v0(new StringTree(c));
+
+    StringTree v(*v0);
+    v0.reset();
+    checkTree(v, {"3", "-3", "0", "4"});
+
+    std::vector<std::string> c2 = {"0", "1", "2"};
+    std::unique_ptr<StringTree> v1(new StringTree(c2));
+    v = *v1;
+    v1.reset();
+    checkTree(v, {"0", "1", "2"});
+
+    StringTree v2(std::move(v));
+    checkTree(v2, {"0", "1", "2"});
+    checkTree(v, {});
+}
+
+BOOST_AUTO_TEST_CASE(test_insert)
+{
+    std::vector<std::string> c = {"1"};
+    StringTree v(c);
+    v.insert("0", 0);
+    v.insert("4", 2);
+    v.insert("3", 2);
+    v.append("5");
+    checkTree(v, {"0", "1", "3", "4", "5"});
+
+    std::vector<std::string> c1 = {"1", "4", "5"};
+    StringTree v1(c1);
+    std::map<StringTree::Index, std::string> values = {
+        {0, "0"}, {2, "2"}, {3, "3"}, {6, "6"}, {7, "7"}
+    };
+    v1.insert(values);
+    checkTree(v1, {"0", "1", "2", "3", "4", "5", "6", "7"});
+}
+
+BOOST_AUTO_TEST_CASE(test_insert_error)
+{
+    {
+        StringTree v;
+        BOOST_CHECK_THROW(v.insert("2", 1), Exception); // invalid index
+        checkTree(v, {});
+    }
+    {
+        StringTree v(std::vector<std::string>{"1", "-2"});
+        BOOST_CHECK_THROW(v.insert("-2", 0), Exception); // duplicate key
+        BOOST_CHECK_THROW(v.append("1"), Exception); // duplicate key
+        checkTree(v, {"1", "-2"});
+    }
+    {
+        std::vector<std::string> c = {"1", "4", "5"};
+        StringTree v(c);
+        BOOST_CHECK_THROW(v.insert({{0, "0"}, {2, "1"}}), Exception); // dup key
+        checkTree(v, {"1", "4", "5"});
+        BOOST_CHECK_THROW(v.insert({{0, "0"}, {8, "2"}}), Exception); // invalid index
+        checkTree(v, {"1", "4", "5"});
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_remove)
+{
+    std::vector<std::string> c = {"1", "2", "3", "4"};
+    StringTree v(c);
+    BOOST_CHECK(v.remove(0) == "1");
+    checkTree(v, {"2", "3", "4"});
+    BOOST_CHECK(v.remove(1) == "3");
+    checkTree(v, {"2", "4"});
+    BOOST_CHECK(!v.contains("3"));
+    BOOST_CHECK_THROW(v.remove(2), Exception);
+
+    std::vector<std::string> c1 = {"0", "1", "2", "3", "4", "5", "6"};
+    StringTree v1(c1);
+    auto recv = v1.remove(std::set<StringTree::Index>{0, 2, 3, 6});
+    checkTree(v1, {"1", "4", "5"});
+    BOOST_REQUIRE(recv.size() == 4);
+    BOOST_CHECK(recv.at(0) == "0" && recv.at(2) == "2" && recv.at(3) == "3" && recv.at(6) == "6");
+
+    BOOST_CHECK_THROW(v1.remove(std::set<StringTree::Index>{0, 1, 8}), Exception);
+    checkTree(v1, {"1", "4", "5"});
+}
+
+BOOST_AUTO_TEST_CASE(test_move)
+{
+    std::vector<std::string> c = {"0", "1", "2", "3", "4", "5", "6"};
+    StringTree v(c);
+
+    v.move(0, 2);
+    checkTree(v, {"1", "2", "0", "3", "4", "5", "6"});
+    v.move(2, 0);
+    checkTree(v, {"0", "1", "2", "3", "4", "5", "6"});
+
+    v.move(3, 6);
+    checkTree(v, {"0", "1", "2", "4", "5", "6", "3"});
+    v.move(6, 3);
+    checkTree(v, {"0", "1", "2", "3", "4", "5", "6"});
+
+    v.move(4, 4);
+    checkTree(v, {"0", "1", "2", "3", "4", "5", "6"});
+
+    BOOST_CHECK_THROW(v.move(0, 7), Exception);
+    BOOST_CHECK_THROW(v.move(7, 0), Exception);
+}
+
+// more than 255 elements, checked against plain vector
+
+BOOST_AUTO_TEST_CASE(test_wide_index)
+{
+    const size_t SIZE = 5000;
+
+    StringTree v;
+    std::vector<std::string> exp;
+    std::mt19937 gen(1);
+
+    for (size_t i = 0; i < SIZE; ++i) {
+        const std::string s = std::to_string(i);
+        const size_t at = gen() % (exp.size() + 1);
+        v.insert(s, at);
+        exp.insert(exp.begin() + at, s);
+    }
+    BOOST_REQUIRE(v.size() == SIZE);
+
+    for (size_t i = 0; i < SIZE; ++i) {
+        const size_t from = gen() % SIZE;
+        const size_t to = gen() % SIZE;
+        v.move(from, to);
+        std::string s = exp.at(from);
+        exp.erase(exp.begin() + from);
+        exp.insert(exp.begin() + to, s);
+    }
+
+    for (size_t i = 0; i < SIZE / 2; ++i) {
+        const size_t at = gen() % exp.size();
+        BOOST_CHECK(v.remove(at) == exp.at(at));
+        exp.erase(exp.begin() + at);
+    }
+
+    BOOST_REQUIRE(v.size() == exp.size());
+    for (size_t i = 0; i < exp.size(); ++i) {
+        BOOST_CHECK(v.at(i) == exp.at(i));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// K, V with movable type
+
+BOOST_AUTO_TEST_SUITE(unique_tree_tests_movable)
+
+typedef std::unique_ptr<std::string> StringPtr;
+
+class Key {
+public:
+    explicit Key(const StringPtr& p) : k_(*p) {}
+
+    const std::string& operator () () const { return k_; }
+
+    bool operator < (const Key& o) const { return k_ < o.k_; }
+
+private:
+    std::string k_;
+};
+
+std::ostream& operator << (std::ostream& s, const Key& k)
+{
+    s << k();
+    return s;
+}
+
+typedef UniqueTree<StringPtr, Key> StringPtrTree;
+
+StringPtrTree createTree(std::initializer_list<std::string> l)
+{
+    std::vector<StringPtr> c;
+    for (auto i : l) {
+        c.push_back(StringPtr(new std::string(i)));
+    }
+    return StringPtrTree(std::move(c));
+}
+
+void checkTree(const StringPtrTree& v, std::initializer_list<std::string> exp)
+{
+    BOOST_REQUIRE_MESSAGE(
+        v.size() == exp.size(),
+        "Size mismatch, expected " << exp.size() << ", received " << v.size());
+
+    size_t at = 0;
+    for (auto i : exp) {
+        BOOST_CHECK_MESSAGE(
+            *v.at(at) == i,
+            "Value mismatch at " << at << ", expected " << i << ", received " << *v.at(at));
+        ++at;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_modify)
+{
+    StringPtrTree v = createTree({"1", "4", "5"});
+    checkTree(v, {"1", "4", "5"});
+
+    v.insert(StringPtr(new std::string("0")), 0);
+    v.append(StringPtr(new std::string("6")));
+    checkTree(v, {"0", "1", "4", "5", "6"});
+
+    std::map<StringPtrTree::Index, StringPtr> values;
+    values.emplace(2, StringPtr(new std::string("2")));
+    values.emplace(3, StringPtr(new std::string("3")));
+    v.insert(std::move(values));
+    checkTree(v, {"0", "1", "2", "3", "4", "5", "6"});
+
+    BOOST_CHECK(*v.remove(6) == "6");
+    v.move(0, 5);
+    checkTree(v, {"1", "2", "3", "4", "5", "0"});
+
+    auto removed = v.remove(std::set<StringPtrTree::Index>{0, 5});
+    BOOST_REQUIRE(removed.size() == 2);
+    BOOST_CHECK(*removed.at(0) == "1" && *removed.at(5) == "0");
+    checkTree(v, {"2", "3", "4", "5"});
+
+    StringPtr dup(new std::string("3"));
+    BOOST_CHECK_THROW(v.append(std::move(dup)), Exception);
+    BOOST_CHECK(dup && *dup == "3"); // not consumed on error
+    checkTree(v, {"2", "3", "4", "5"});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <attestate/validate.h>
+#include <attestate/exception.h>
 
 #include "../src/helpers.h"
 
@@ -204,4 +205,155 @@ BOOST_AUTO_TEST_CASE(test_student_personal)
 #undef UPDATE_VALUE
 }
 
+BOOST_AUTO_TEST_CASE(test_incremental_validator)
+{
+    const ID subj1 = ID::gen();
+    const ID subj2 = ID::gen();
+    auto plan = std::make_shared<SubjectsPlan>(
+        ID::gen(), "Plan",
+        SubjectPtrVector{
+            std::make_shared<Subject>(subj1, "Subject 1"),
+            std::make_shared<Subject>(subj2, "Subject 2")
+        });
+
+    auto createStudent = [&] (const QString& familyName)
+    {
+        return Class::StudentPtr(new Student(
+            ID::gen(), familyName, "Name", "Parental", QDate(1998, 1, 1),
+            SubjectsGrades({{subj1, "5"}, {subj2, "4"}}),
+            boost::none, "0000001", boost::none));
+    };
+
+    std::vector<Class::StudentPtr> students;
+    students.push_back(createStudent("Ivanov"));
+    students.push_back(createStudent("Petrov"));
+    Class c(ID::gen(), "11A", Year(2016), QDate(2016, 6, 25), std::move(students), plan);
+
+    Validator validator(c);
+
+    auto checkSame = [&] ()
+    {
+        auto exp = validate(c);
+        BOOST_REQUIRE(!exp == !validator.hasErrors());
+        if (!exp) {
+            return;
+        }
+        const ClassErrors& recv = validator.errors();
+        BOOST_CHECK(exp->propertyErrors == recv.propertyErrors);
+        BOOST_REQUIRE(exp->studentErrors.size() == recv.studentErrors.size());
+        for (const auto& e : exp->studentErrors) {
+            BOOST_REQUIRE(recv.studentErrors.count(e.first));
+            const auto& r = recv.studentErrors.at(e.first);
+            BOOST_CHECK(e.second.propertyErrors == r.propertyErrors);
+            BOOST_CHECK(e.second.gradeErrors == r.gradeErrors);
+        }
+    };
+
+    checkSame();
+
+    c.student(0).setFamilyName("");
+    validator.onPropertyChanged(0, cfg::tags::property::FAMILY_NAME);
+    checkSame();
+
+    c.student(1).grades().setValue(subj2, QString("7"));
+    validator.onGradeChanged(1, subj2);
+    checkSame();
+    c.student(1).grades().setValue(subj2, boost::none);
+    validator.onGradeChanged(1, subj2);
+    checkSame();
+
+    c.setIssueDate(boost::none);
+    c.setGraduationYear(boost::none);
+    validator.onClassChanged();
+    checkSame();
+
+    c.student(0).setIssueDate(QDate(2016, 6, 20));
+    validator.onPropertyChanged(0, cfg::tags::property::ISSUE_DATE);
+    checkSame();
+
+    c.setIssueDate(QDate(2016, 6, 25));
+    c.setGraduationYear(Year(2016));
+    validator.onClassChanged();
+    checkSame();
+
+    c.student(0).setFamilyName("Ivanov");
+    validator.onPropertyChanged(0, cfg::tags::property::FAMILY_NAME);
+    c.student(1).grades().setValue(subj2, QString("4"));
+    validator.onGradeChanged(1, subj2);
+    checkSame();
+    BOOST_CHECK(!validator.hasErrors());
+
+    c.student(0).setDeleted(true);
+    validator.onStudentChanged(0);
+    checkSame();
+    c.student(0).setDeleted(false);
+    validator.onStudentChanged(0);
+    checkSame();
+
+    c.append(Class::StudentPtr(new Student(ID::gen())));
+    c.erase(1);
+    validator.onStudentsChanged();
+    checkSame();
+
+    plan->append(std::make_shared<Subject>(ID::gen(), "Subject 3"));
+    validator.revalidate();
+    checkSame();
+
+    BOOST_CHECK_THROW(validator.onPropertyChanged(0, "UNKNOWN"), Exception);
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_validation)
+{
+    const ID subj = ID::gen();
+    auto plan = std::make_shared<SubjectsPlan>(
+        ID::gen(), "Plan", SubjectPtrVector{std::make_shared<Subject>(subj, "Subject")});
+
+    // big class is split into several students ranges
+    auto createClass = [&] (size_t size, OptionalYear year)
+    {
+        std::vector<Class::StudentPtr> students;
+        for (size_t i = 0; i < size; ++i) {
+            students.emplace_back(new Student(
+                ID::gen(), i % 7 ? "Family" : "", "Name", "Parental", QDate(1998, 1, 1),
+                i % 5 ? SubjectsGrades({{subj, "5"}}) : SubjectsGrades(),
+                boost::none, "0000001", boost::none));
+        }
+        return std::unique_ptr<Class>(new Class(
+            ID::gen(), "11A", year, QDate(2016, 6, 25), std::move(students), plan));
+    };
+
+    std::vector<std::unique_ptr<Class>> owned;
+    owned.push_back(createClass(1000, Year(2016)));
+    owned.push_back(createClass(3, boost::none));
+    owned.push_back(createClass(0, Year(2016)));
+    owned.push_back(createClass(600, boost::none));
+    owned[0]->student(7).setDeleted(true);
+
+    std::vector<const Class*> classes;
+    for (const auto& c : owned) {
+        classes.push_back(c.get());
+    }
+
+    for (size_t workers : {1, 4}) {
+        auto res = validate(classes, workers);
+        BOOST_REQUIRE(res.size() == 3);
+        BOOST_CHECK(!res.count(owned[2]->id()));
+        for (const auto& c : owned) {
+            auto exp = validate(*c);
+            BOOST_REQUIRE(!exp == !res.count(c->id()));
+            if (!exp) {
+                continue;
+            }
+            const ClassErrors& recv = res.at(c->id());
+            BOOST_CHECK(exp->propertyErrors == recv.propertyErrors);
+            BOOST_REQUIRE(exp->studentErrors.size() == recv.studentErrors.size());
+            for (const auto& e : exp->studentErrors) {
+                const auto& r = recv.studentErrors.at(e.first);
+                BOOST_CHECK(e.second.propertyErrors == r.propertyErrors);
+                BOOST_CHECK(e.second.gradeErrors == r.gradeErrors);
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()